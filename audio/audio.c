@@ -10,155 +10,1530 @@
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
+#ifndef M_SQRT2
+#define M_SQRT2 1.41421356237309504880
+#endif
+
+enum { ENVELOPE_CONTROL_FRAMES = 32 };
+enum { MAX_COALESCE_CANDIDATES = 64 };
+// Below this many unfiltered voices a span is not worth splitting.
+enum { PARALLEL_MIN_VOICES = 8 };
+// Floats of effect state cleared per period after a panic or a NaN.
+enum { FX_CLEAR_SLICE_FLOATS = 65536 };
+enum { FX_CLEAR_IDLE = 0, FX_CLEAR_DELAY, FX_CLEAR_REVERB, FX_CLEAR_CONVOLVER };
 
-static size_t next_index(size_t idx) {
-    return (idx + 1) % 1024;
+static const double STEAL_FADE_SECONDS = 0.003;
+static const double GAIN_SMOOTH_SECONDS = 0.005;
+static const double DELAY_MAX_SECONDS = 4.0;
+static const double IMPULSE_MAX_SECONDS = 10.0;
+
+static void voice_pool_reset(VoicePool *pool) {
+    pool->active_count = 0;
+    pool->fading_count = 0;
+    pool->filtered_count = 0;
+    filter_bank_reset(&pool->filters);
+    pool->free_count = pool->size;
+    for (uint32_t i = 0; i < pool->size; ++i) {
+        pool->free_slots[i] = pool->size - 1 - i;
+    }
 }
 
-static void audio_callback(ma_device *device, void *output, const void *input, ma_uint32 frame_count) {
-    (void)input;
-    AudioEngine *engine = (AudioEngine *)device->config.pUserData;
-    float *out = (float *)output;
-    const uint32_t channels = engine->channels;
-    memset(out, 0, sizeof(float) * frame_count * channels);
+static void voice_pool_free(VoicePool *pool) {
+    free(pool->voices);
+    free(pool->free_slots);
+    free(pool->active);
+    filter_bank_free(&pool->filters);
+    memset(pool, 0, sizeof(*pool));
+}
+
+static bool voice_pool_init(VoicePool *pool, uint32_t capacity) {
+    memset(pool, 0, sizeof(*pool));
+    if (capacity == 0) capacity = AUDIO_DEFAULT_VOICES;
+    uint32_t reserve = capacity / 8;
+    if (reserve < 4) reserve = 4;
+    pool->capacity = capacity;
+    pool->size = capacity + reserve;
+    pool->voices = (ActiveVoice *)calloc(pool->size, sizeof(ActiveVoice));
+    pool->free_slots = (uint32_t *)malloc(sizeof(uint32_t) * pool->size);
+    pool->active = (uint32_t *)malloc(sizeof(uint32_t) * pool->size);
+    if (!pool->voices || !pool->free_slots || !pool->active || !filter_bank_init(&pool->filters, pool->size)) {
+        voice_pool_free(pool);
+        return false;
+    }
+    voice_pool_reset(pool);
+    return true;
+}
+
+static void event_stage_reset(EventStage *stage) {
+    stage->count = 0;
+    stage->free_count = stage->capacity;
+    for (uint32_t i = 0; i < stage->capacity; ++i) {
+        stage->free_slots[i] = stage->capacity - 1 - i;
+    }
+}
+
+static void event_stage_free(EventStage *stage) {
+    free(stage->events);
+    free(stage->free_slots);
+    free(stage->heap);
+    memset(stage, 0, sizeof(*stage));
+}
+
+static bool event_stage_init(EventStage *stage, uint32_t capacity) {
+    memset(stage, 0, sizeof(*stage));
+    stage->capacity = capacity;
+    stage->events = (QueuedEvent *)malloc(sizeof(QueuedEvent) * capacity);
+    stage->free_slots = (uint32_t *)malloc(sizeof(uint32_t) * capacity);
+    stage->heap = (EventStageEntry *)malloc(sizeof(EventStageEntry) * capacity);
+    if (!stage->events || !stage->free_slots || !stage->heap) {
+        event_stage_free(stage);
+        return false;
+    }
+    event_stage_reset(stage);
+    return true;
+}
+
+static bool event_stage_before(const EventStageEntry *a, const EventStageEntry *b) {
+    if (a->start_frame != b->start_frame) return a->start_frame < b->start_frame;
+    return a->seq < b->seq;
+}
+
+// Copies queued into a free slot and sifts it up the heap. The caller checks
+// free_count first.
+static void event_stage_push(EventStage *stage, const QueuedEvent *queued) {
+    uint32_t slot = stage->free_slots[--stage->free_count];
+    stage->events[slot] = *queued;
+    EventStageEntry entry = {queued->event.start_frame, stage->next_seq++, slot};
+    uint32_t i = stage->count++;
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!event_stage_before(&entry, &stage->heap[parent])) break;
+        stage->heap[i] = stage->heap[parent];
+        i = parent;
+    }
+    stage->heap[i] = entry;
+}
+
+// Removes the earliest entry; its slot goes back on the free stack, so the
+// event must be consumed before the next push.
+static void event_stage_pop(EventStage *stage) {
+    stage->free_slots[stage->free_count++] = stage->heap[0].slot;
+    EventStageEntry last = stage->heap[--stage->count];
+    uint32_t i = 0;
+    for (;;) {
+        uint32_t child = 2 * i + 1;
+        if (child >= stage->count) break;
+        if (child + 1 < stage->count && event_stage_before(&stage->heap[child + 1], &stage->heap[child])) ++child;
+        if (!event_stage_before(&stage->heap[child], &last)) break;
+        stage->heap[i] = stage->heap[child];
+        i = child;
+    }
+    if (stage->count > 0) stage->heap[i] = last;
+}
+
+static void event_ring_free(EventRing *ring) {
+    free(ring->slots);
+    ring->slots = NULL;
+    ring->capacity = 0;
+    ring->mask = 0;
+}
+
+static bool event_ring_init(EventRing *ring, uint32_t capacity) {
+    if (capacity == 0) capacity = AUDIO_DEFAULT_EVENT_CAPACITY;
+    if (capacity > AUDIO_MAX_EVENT_CAPACITY) capacity = AUDIO_MAX_EVENT_CAPACITY;
+    uint32_t size = 16;
+    while (size < capacity) size <<= 1;
+    atomic_store(&ring->head, 0);
+    atomic_store(&ring->tail, 0);
+    ring->pending = 0;
+    ring->tail_cache = 0;
+    ring->slots = (QueuedEvent *)malloc(sizeof(QueuedEvent) * size);
+    if (!ring->slots) return false;
+    ring->capacity = size;
+    ring->mask = size - 1;
+    return true;
+}
+
+static ActiveVoice *voice_pool_acquire(VoicePool *pool) {
+    if (pool->free_count == 0) return NULL;
+    uint32_t slot = pool->free_slots[--pool->free_count];
+    ActiveVoice *voice = &pool->voices[slot];
+    voice->active_index = pool->active_count;
+    pool->active[pool->active_count++] = slot;
+    return voice;
+}
+
+// Frees the voice at active_index and drops its hold on the epoch.
+static void voice_pool_release(VoicePool *pool, AudioEpochHolds *held, uint32_t active_index) {
+    uint32_t slot = pool->active[active_index];
+    ActiveVoice *voice = &pool->voices[slot];
+    audio_epoch_release(held, voice->epoch);
+    if (voice->fade_frames > 0) {
+        pool->fading_count--;
+    }
+    if (voice->filtered) {
+        for (uint32_t ch = 0; ch < voice->filter_channels; ++ch) {
+            filter_bank_detach(&pool->filters, filter_bank_lane(&pool->filters, slot, ch));
+        }
+        voice->filtered = false;
+        pool->filtered_count--;
+    }
+    uint32_t last = pool->active[--pool->active_count];
+    pool->active[active_index] = last;
+    pool->voices[last].active_index = active_index;
+    pool->free_slots[pool->free_count++] = slot;
+}
+
+static double voice_envelope(const ActiveVoice *voice, uint64_t global_frame) {
+    double amplitude = 1.0;
+    if (voice->is_pitched) {
+        uint64_t frames_since_start = global_frame - voice->start_frame;
+        if (voice->attack_frames > 0 && frames_since_start < voice->attack_frames) {
+            amplitude *= (double)frames_since_start / (double)voice->attack_frames;
+        }
+        if (voice->note_off_frame > 0 && global_frame >= voice->note_off_frame) {
+            uint64_t release_pos = global_frame - voice->note_off_frame;
+            if (release_pos >= voice->release_frames) return 0.0;
+            amplitude *= 1.0 - ((double)release_pos / (double)voice->release_frames);
+        }
+    }
+    if (voice->fade_frames > 0) {
+        uint64_t fade_pos = global_frame - voice->fade_start_frame;
+        if (fade_pos >= voice->fade_frames) return 0.0;
+        amplitude *= 1.0 - ((double)fade_pos / (double)voice->fade_frames);
+    }
+    return amplitude;
+}
+
+// Number of frames, starting at global_frame, for which the envelope is a
+// constant 1.0 (sustain or unpitched). Zero while attacking, releasing or
+// fading out after being stolen.
+static uint64_t envelope_flat_frames(const ActiveVoice *voice, uint64_t global_frame) {
+    if (voice->fade_frames > 0) return 0;
+    if (!voice->is_pitched) return UINT64_MAX;
+    if (global_frame - voice->start_frame < voice->attack_frames) return 0;
+    if (voice->note_off_frame == 0) return UINT64_MAX;
+    if (global_frame >= voice->note_off_frame) return 0;
+    return voice->note_off_frame - global_frame;
+}
+
+// Number of frames the voice can still produce from global_frame on, limited
+// by the end of the sample data, the release tail and any steal fade.
+static uint64_t voice_frames_remaining(const ActiveVoice *voice, uint64_t global_frame) {
+    uint64_t end = (uint64_t)voice->sample->frame_count << RESAMPLE_FRAC_BITS;
+    uint64_t remaining = 0;
+    if (voice->position < end) {
+        remaining = (end - voice->position + voice->increment - 1) / voice->increment;
+    }
+    if (voice->is_pitched && voice->note_off_frame > 0) {
+        uint64_t end_frame = voice->note_off_frame + voice->release_frames;
+        uint64_t until_end = end_frame > global_frame ? end_frame - global_frame : 0;
+        if (until_end < remaining) remaining = until_end;
+    }
+    if (voice->fade_frames > 0) {
+        uint64_t end_frame = voice->fade_start_frame + voice->fade_frames;
+        uint64_t until_end = end_frame > global_frame ? end_frame - global_frame : 0;
+        if (until_end < remaining) remaining = until_end;
+    }
+    return remaining;
+}
+
+// Level used to rank voices for stealing. Voices still in their attack count
+// at full level so a note that just started is not the first one taken.
+static double voice_peak_gain(const ActiveVoice *voice) {
+    return voice->gain[0] > voice->gain[1] ? voice->gain[0] : voice->gain[1];
+}
+
+static double voice_steal_level(const ActiveVoice *voice, uint64_t global_frame) {
+    if (voice->is_synth) {
+        return voice_envelope(voice, global_frame) * voice->synth.env_level * voice_peak_gain(voice);
+    }
+    if (voice->is_pitched && global_frame - voice->start_frame < voice->attack_frames && voice->fade_frames == 0) {
+        return voice_peak_gain(voice);
+    }
+    return voice_envelope(voice, global_frame) * voice_peak_gain(voice);
+}
+
+static bool steal_candidate_better(VoiceStealPolicy policy, const ActiveVoice *candidate, const ActiveVoice *current, uint64_t global_frame) {
+    if (!current) return true;
+    switch (policy) {
+        case VOICE_STEAL_QUIETEST: {
+            double a = voice_steal_level(candidate, global_frame);
+            double b = voice_steal_level(current, global_frame);
+            if (a != b) return a < b;
+            break;
+        }
+        case VOICE_STEAL_PRIORITY:
+            if (candidate->priority != current->priority) return candidate->priority < current->priority;
+            break;
+        case VOICE_STEAL_OLDEST:
+        default:
+            break;
+    }
+    return candidate->start_frame < current->start_frame;
+}
+
+// Chooses the sounding voice to steal for ev, or NULL when every voice
+// outranks the new event under the priority policy.
+static ActiveVoice *pick_steal_victim(AudioEngine *engine, const ScheduledEvent *ev, uint64_t global_frame) {
+    VoicePool *pool = &engine->pool;
+    ActiveVoice *victim = NULL;
+    for (uint32_t i = 0; i < pool->active_count; ++i) {
+        ActiveVoice *voice = &pool->voices[pool->active[i]];
+        if (voice->fade_frames > 0) continue;
+        if (steal_candidate_better(engine->steal_policy, voice, victim, global_frame)) {
+            victim = voice;
+        }
+    }
+    if (victim && engine->steal_policy == VOICE_STEAL_PRIORITY && victim->priority > ev->priority) {
+        return NULL;
+    }
+    return victim;
+}
+
+// Frees a slot held by a fading voice, cutting the one closest to silence.
+static bool cut_fading_voice(AudioEngine *engine, uint64_t global_frame) {
+    VoicePool *pool = &engine->pool;
+    uint32_t best = UINT32_MAX;
+    double best_level = 0.0;
+    for (uint32_t i = 0; i < pool->active_count; ++i) {
+        const ActiveVoice *voice = &pool->voices[pool->active[i]];
+        if (voice->fade_frames == 0) continue;
+        double level = voice_envelope(voice, global_frame) * voice_peak_gain(voice);
+        if (best == UINT32_MAX || level < best_level) {
+            best = i;
+            best_level = level;
+        }
+    }
+    if (best == UINT32_MAX) return false;
+    voice_pool_release(pool, &engine->held, best);
+    return true;
+}
+
+// Finds a slot for a new voice, stealing a sounding voice (which then fades
+// out over a few milliseconds) once the pool is at capacity.
+static ActiveVoice *allocate_voice(AudioEngine *engine, const ScheduledEvent *ev, uint64_t global_frame) {
+    VoicePool *pool = &engine->pool;
+    if (pool->active_count - pool->fading_count >= pool->capacity) {
+        ActiveVoice *victim = pick_steal_victim(engine, ev, global_frame);
+        if (!victim) return NULL;
+        audio_stats_add(&engine->stats.voices_stolen, 1);
+        victim->fade_start_frame = global_frame;
+        victim->fade_frames = engine->steal_fade_frames;
+        pool->fading_count++;
+    }
+    if (pool->free_count == 0 && !cut_fading_voice(engine, global_frame)) {
+        return NULL;
+    }
+    return voice_pool_acquire(pool);
+}
 
+static bool voice_matches_event(const ActiveVoice *voice, const QueuedEvent *queued, uint64_t increment, ResampleQuality quality) {
+    const ScheduledEvent *ev = &queued->event;
+    const float *g = queued->channel_gain;
+    // Same pan means the left/right gains are in the same ratio.
+    if (voice->is_synth != ev->is_synth) return false;
+    if (voice->bus != ev->bus) return false;
+    if (voice->send[AUDIO_SEND_DELAY] != ev->delay || voice->send[AUDIO_SEND_REVERB] != ev->room) return false;
+    if (voice->filtered != queued->filtered) return false;
+    if (queued->filtered &&
+        (voice->filter.lpf != ev->filter.lpf || voice->filter.hpf != ev->filter.hpf || voice->filter.resonance != ev->filter.resonance)) {
+        return false;
+    }
+    if (ev->is_synth) {
+        return voice->fade_frames == 0 &&
+               voice->target_gain[0] * g[1] == voice->target_gain[1] * g[0] &&
+               voice->start_frame == ev->start_frame &&
+               voice->note_duration_frames == ev->note_duration_frames &&
+               voice->synth_frequency == ev->frequency &&
+               synth_params_equal(&voice->synth_params, &ev->synth);
+    }
+    return voice->fade_frames == 0 &&
+           voice->target_gain[0] * g[1] == voice->target_gain[1] * g[0] &&
+           voice->sample == ev->sample &&
+           voice->start_frame == ev->start_frame &&
+           voice->increment == increment &&
+           voice->is_pitched == ev->is_pitched &&
+           voice->note_duration_frames == (ev->is_pitched ? ev->note_duration_frames : 0) &&
+           voice->resample_quality == quality;
+}
+
+// Moves the voice's left/right gain to target over smooth_frames output
+// frames (immediately when 0).
+static void voice_set_gain(ActiveVoice *voice, const float target[2], uint32_t smooth_frames) {
+    voice->target_gain[0] = target[0];
+    voice->target_gain[1] = target[1];
+    voice->smooth_frames = smooth_frames;
+    if (smooth_frames == 0) {
+        voice->gain[0] = target[0];
+        voice->gain[1] = target[1];
+    }
+}
+
+static void start_sample_voice(AudioEngine *engine,
+                               ActiveVoice *voice,
+                               const ScheduledEvent *ev,
+                               uint64_t global_frame,
+                               double rate,
+                               uint64_t increment,
+                               ResampleQuality quality) {
     const uint64_t attack_frames = (uint64_t)((double)engine->sample_rate * 0.005);
     const uint64_t base_release_frames = (uint64_t)((double)engine->sample_rate * 0.040);
+    voice->sample = ev->sample;
+    voice->start_frame = ev->start_frame;
+    voice->playback_rate = rate;
+    voice->increment = increment;
+    voice->position = 0;
+    if (global_frame > ev->start_frame) {
+        // Late trigger: skip the part of the sample that should already have played.
+        uint64_t late = global_frame - ev->start_frame;
+        voice->position = (late < (UINT64_MAX / voice->increment)) ? late * voice->increment : UINT64_MAX;
+    }
+    voice->resample_quality = quality;
+    voice->is_pitched = ev->is_pitched;
+    voice->note_duration_frames = ev->note_duration_frames;
+    voice->attack_frames = attack_frames > 0 ? attack_frames : 1;
+    voice->release_frames = base_release_frames > 0 ? base_release_frames : 1;
+    voice->note_off_frame = 0;
+    voice->mix_kernel = mix_kernel_for(&engine->mix, ev->sample->channels, engine->bus_channels);
 
-    if (atomic_exchange(&engine->panic, false)) {
-        engine->voice_count = 0;
-        atomic_store(&engine->event_tail, atomic_load(&engine->event_head));
+    if (voice->is_pitched) {
+        if (voice->note_duration_frames > 0) {
+            // Allow pitched notes to finish their release even when the next
+            // note overlaps (legato-lite). Keep a consistent release instead
+            // of clamping it to the note length so repeated notes do not hard cut.
+            voice->note_off_frame = voice->start_frame + voice->note_duration_frames;
+        }
+    } else {
+        voice->note_duration_frames = 0;
+        voice->note_off_frame = 0;
+        voice->attack_frames = 0;
+        voice->release_frames = 0;
     }
+}
 
-    uint64_t frame_cursor = atomic_load(&engine->frame_cursor);
+// Routes a freshly started voice through the filter bank, loading the
+// coefficients computed at queue time into its lanes.
+static void attach_voice_filter(AudioEngine *engine, ActiveVoice *voice, const QueuedEvent *queued) {
+    VoicePool *pool = &engine->pool;
+    uint32_t slot = pool->active[voice->active_index];
+    uint32_t source_channels = voice->is_synth ? 1 : voice->sample->channels;
+    voice->filter_channels = source_channels > FILTER_LANES_PER_SLOT ? FILTER_LANES_PER_SLOT : source_channels;
+    for (uint32_t ch = 0; ch < voice->filter_channels; ++ch) {
+        filter_bank_attach(&pool->filters, filter_bank_lane(&pool->filters, slot, ch), queued->filter_coeffs);
+    }
+    voice->filter = queued->event.filter;
+    voice->filtered = true;
+    voice->mix_kernel = mix_kernel_for(&engine->mix, voice->filter_channels, engine->bus_channels);
+    pool->filtered_count++;
+}
 
-    for (ma_uint32 frame = 0; frame < frame_count; ++frame) {
-        uint64_t global_frame = frame_cursor + frame;
-
-        size_t tail = atomic_load(&engine->event_tail);
-        size_t head = atomic_load(&engine->event_head);
-        while (tail != head) {
-            ScheduledEvent *ev = &engine->event_queue[tail];
-            if (ev->start_frame > global_frame) break;
-
-            if (engine->voice_count < (sizeof(engine->voices) / sizeof(engine->voices[0]))) {
-                ActiveVoice *voice = &engine->voices[engine->voice_count++];
-                voice->sample = ev->sample;
-                voice->start_frame = ev->start_frame;
-                voice->playback_rate = (ev->playback_rate > 0.0) ? ev->playback_rate : 1.0;
-                voice->is_pitched = ev->is_pitched;
-                voice->note_duration_frames = ev->note_duration_frames;
-                voice->attack_frames = attack_frames > 0 ? attack_frames : 1;
-                voice->release_frames = base_release_frames > 0 ? base_release_frames : 1;
-                voice->note_off_frame = 0;
+// Starts a voice for the queued event, or folds it into an identical voice
+// that was started at the same frame (listed in candidates) by summing gains.
+static void start_voice(AudioEngine *engine, const QueuedEvent *queued, uint64_t global_frame, uint32_t *candidates, uint32_t *candidate_count) {
+    const ScheduledEvent *ev = &queued->event;
+    if (!ev->sample && !ev->is_synth) return;
 
-                if (voice->is_pitched) {
-                    if (voice->note_duration_frames > 0) {
-                        // Allow pitched notes to finish their release even when the next
-                        // note overlaps (legato-lite). Keep a consistent release instead
-                        // of clamping it to the note length so repeated notes do not hard cut.
-                        voice->note_off_frame = voice->start_frame + voice->note_duration_frames;
-                    }
-                } else {
-                    voice->note_duration_frames = 0;
-                    voice->note_off_frame = 0;
-                    voice->attack_frames = 0;
-                    voice->release_frames = 0;
-                }
+    double rate = (ev->playback_rate > 0.0) ? ev->playback_rate : 1.0;
+    double source_rate = rate;
+    if (ev->sample && ev->sample->sample_rate > 0 && ev->sample->sample_rate != engine->sample_rate) {
+        source_rate *= (double)ev->sample->sample_rate / (double)engine->sample_rate;
+    }
+    uint64_t increment = resample_increment_from_rate(source_rate);
+    ResampleQuality quality = (ev->resample_quality != RESAMPLE_DEFAULT) ? ev->resample_quality : engine->resample_quality;
+
+    for (uint32_t i = 0; i < *candidate_count; ++i) {
+        ActiveVoice *existing = &engine->pool.voices[candidates[i]];
+        if (voice_matches_event(existing, queued, increment, quality)) {
+            // The voice has not produced any output yet, so no smoothing.
+            float summed[2] = {
+                existing->target_gain[0] + queued->channel_gain[0],
+                existing->target_gain[1] + queued->channel_gain[1],
+            };
+            voice_set_gain(existing, summed, 0);
+            if (ev->priority > existing->priority) existing->priority = ev->priority;
+            return;
+        }
+    }
+
+    if (global_frame > ev->start_frame) {
+        audio_stats_add(&engine->stats.events_late, 1);
+    }
+    ActiveVoice *voice = allocate_voice(engine, ev, global_frame);
+    if (!voice) {
+        audio_stats_add(&engine->stats.voices_dropped, 1);
+        return;
+    }
+    voice_set_gain(voice, queued->channel_gain, 0);
+    voice->priority = ev->priority;
+    voice->fade_start_frame = 0;
+    voice->fade_frames = 0;
+    voice->start_frame = ev->start_frame;
+    voice->is_synth = ev->is_synth;
+    voice->bus = ev->bus;
+    voice->epoch = ev->epoch;
+    audio_epoch_hold(&engine->held, voice->epoch);
+    if (voice->is_synth) {
+        // The synth runs its own ADSR; the gate closes after note_duration_frames.
+        voice->sample = NULL;
+        voice->is_pitched = false;
+        voice->note_duration_frames = ev->note_duration_frames;
+        voice->note_off_frame = ev->note_duration_frames > 0 ? ev->start_frame + ev->note_duration_frames : 0;
+        voice->synth_params = ev->synth;
+        voice->synth_frequency = ev->frequency;
+        voice->mix_kernel = mix_kernel_for(&engine->mix, 1, engine->bus_channels);
+        synth_voice_start(&voice->synth, &ev->synth, ev->frequency, engine->sample_rate);
+    } else {
+        start_sample_voice(engine, voice, ev, global_frame, rate, increment, quality);
+    }
+    voice->filtered = false;
+    if (queued->filtered) {
+        attach_voice_filter(engine, voice, queued);
+    }
+    voice->send[AUDIO_SEND_DELAY] = ev->delay;
+    voice->send[AUDIO_SEND_REVERB] = ev->room;
+    uint32_t source_channels = voice->filtered ? voice->filter_channels : (voice->is_synth ? 1 : voice->sample->channels);
+    voice->send_kernel = mix_kernel_for(&engine->mix, source_channels, 2);
+
+    if (*candidate_count < MAX_COALESCE_CANDIDATES) {
+        candidates[(*candidate_count)++] = engine->pool.active[voice->active_index];
+    }
+}
+
+// Moves everything the transport has queued into the stage. Runs once per
+// period; if the stage is full the rest waits in the ring for the next one.
+// Returns false in that case.
+static bool drain_event_ring(AudioEngine *engine) {
+    EventStage *stage = &engine->stage;
+    EventRing *ring = &engine->ring;
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    while (tail != head && stage->free_count > 0) {
+        audio_epoch_hold(&engine->held, ring->slots[tail & ring->mask].event.epoch);
+        event_stage_push(stage, &ring->slots[tail & ring->mask]);
+        ++tail;
+    }
+    atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    return tail == head;
+}
+
+// Starts every staged event due at or before global_frame, earliest first,
+// and returns the start frame of the next one (UINT64_MAX when none is left).
+static uint64_t start_due_events(AudioEngine *engine, uint64_t global_frame) {
+    uint32_t candidates[MAX_COALESCE_CANDIDATES];
+    uint32_t candidate_count = 0;
+    EventStage *stage = &engine->stage;
+    while (stage->count > 0) {
+        if (stage->heap[0].start_frame > global_frame) {
+            return stage->heap[0].start_frame;
+        }
+        const QueuedEvent *queued = &stage->events[stage->heap[0].slot];
+        start_voice(engine, queued, global_frame, candidates, &candidate_count);
+        audio_epoch_release(&engine->held, queued->event.epoch); // a started voice holds its own
+        event_stage_pop(stage);
+    }
+    return UINT64_MAX;
+}
+
+// The target's buffer for bus, cleared over the live region the first time
+// anything mixes into it.
+static float *target_bus(RenderTarget *target, uint32_t bus, uint32_t bus_channels) {
+    uint32_t bit = 1u << bus;
+    if (!(target->live_buses & bit)) {
+        memset(target->bus[bus] + (size_t)target->live_offset * bus_channels, 0, sizeof(float) * target->live_frames * bus_channels);
+        target->live_buses |= bit;
+    }
+    return target->bus[bus];
+}
+
+// Fader gain of bus at offset frames into the current block.
+static inline float bus_gain_at(const AudioEngine *engine, uint32_t bus, uint32_t offset) {
+    float from = engine->bus_from[bus];
+    return from + (engine->bus_to[bus] - from) * (float)offset / (float)engine->block_frames;
+}
+
+// Accumulates frames of a voice's source (already enveloped by ramp) into
+// its sub-mix bus at offset, and into every send bus the voice feeds. The
+// buses are faded after the block; sends are post-fader, so the fader ramp
+// is folded into the send ramp here.
+static void voice_mix(const AudioEngine *engine,
+                      RenderTarget *target,
+                      const ActiveVoice *voice,
+                      uint32_t offset,
+                      const float *src,
+                      uint32_t frames,
+                      uint32_t src_channels,
+                      const MixRamp *ramp) {
+    const uint32_t channels = engine->bus_channels;
+    float *bus = target_bus(target, voice->bus, channels);
+    voice->mix_kernel(bus + (size_t)offset * channels, src, frames, src_channels, channels, ramp);
+    float fader0 = bus_gain_at(engine, voice->bus, offset);
+    float fader1 = bus_gain_at(engine, voice->bus, offset + frames);
+    for (int s = 0; s < AUDIO_SEND_COUNT; ++s) {
+        float level = voice->send[s];
+        if (level <= 0.0f || (fader0 == 0.0f && fader1 == 0.0f)) continue;
+        MixRamp send_ramp;
+        for (int c = 0; c < 2; ++c) {
+            float start = ramp->gain[c] * level * fader0;
+            float end = (ramp->gain[c] + ramp->step[c] * (float)frames) * level * fader1;
+            send_ramp.gain[c] = start;
+            send_ramp.step[c] = fader0 == fader1 ? ramp->step[c] * level * fader0 : (end - start) / (float)frames;
+        }
+        voice->send_kernel(target->send[s] + (size_t)offset * 2, src, frames, src_channels, 2, &send_ramp);
+    }
+}
+
+// Renders frames of sample from the fixed-point position through the
+// resampler, widening 16-bit data on the way.
+static inline uint64_t sample_resample(const AudioSample *sample,
+                                       ResampleQuality quality,
+                                       uint64_t position,
+                                       uint64_t increment,
+                                       float *dst,
+                                       uint32_t frames) {
+    if (sample->format == AUDIO_SAMPLE_S16) {
+        return resample_render_s16(quality, sample->data_s16, sample->frame_count, sample->channels, position, increment, dst, frames);
+    }
+    return resample_render(quality, sample->data, sample->frame_count, sample->channels, position, increment, dst, frames);
+}
+
+// Accumulates a span of a voice at offset through voice_mix and
+// advances its fixed-point position. Float voices sitting on whole frames
+// with a unit increment mix straight from the sample data; everything else
+// goes through the resampler into the engine scratch buffer first.
+static void mix_span(const AudioEngine *engine,
+                     RenderTarget *target,
+                     ActiveVoice *voice,
+                     uint32_t offset,
+                     uint32_t frames,
+                     const MixRamp *ramp) {
+    const AudioSample *sample = voice->sample;
+    const uint32_t src_channels = sample->channels;
+
+    if (sample->format == AUDIO_SAMPLE_F32 && voice->increment == RESAMPLE_ONE && (voice->position & (RESAMPLE_ONE - 1)) == 0) {
+        const float *src = sample->data + (size_t)(voice->position >> RESAMPLE_FRAC_BITS) * src_channels;
+        voice_mix(engine, target, voice, offset, src, frames, src_channels, ramp);
+        voice->position += (uint64_t)frames << RESAMPLE_FRAC_BITS;
+        return;
+    }
+
+    uint32_t done = 0;
+    while (done < frames) {
+        uint32_t n = frames - done;
+        if (n > AUDIO_MIX_SCRATCH_FRAMES) n = AUDIO_MIX_SCRATCH_FRAMES;
+        voice->position = sample_resample(sample, voice->resample_quality, voice->position, voice->increment, target->scratch, n);
+        MixRamp chunk_ramp = *ramp;
+        for (int c = 0; c < 2; ++c) {
+            chunk_ramp.gain[c] += ramp->step[c] * (float)done;
+        }
+        voice_mix(engine, target, voice, offset + done, target->scratch, n, src_channels, &chunk_ramp);
+        done += n;
+    }
+}
+
+// Builds the mix ramp for one block from the envelope at its two ends and
+// the voice's left/right gains, advancing any pending gain smoothing. The
+// caller must already have limited chunk to the smoothing window.
+static MixRamp voice_block_ramp(ActiveVoice *voice, double e0, double e1, uint32_t chunk) {
+    float g0[2] = {voice->gain[0], voice->gain[1]};
+    if (voice->smooth_frames > 0) {
+        float t = (float)chunk / (float)voice->smooth_frames;
+        for (int c = 0; c < 2; ++c) {
+            voice->gain[c] += (voice->target_gain[c] - voice->gain[c]) * t;
+        }
+        voice->smooth_frames -= chunk;
+    }
+    MixRamp ramp;
+    for (int c = 0; c < 2; ++c) {
+        float start = (float)e0 * g0[c];
+        float end = (float)e1 * voice->gain[c];
+        ramp.gain[c] = start;
+        ramp.step[c] = (end - start) / (float)chunk;
+    }
+    return ramp;
+}
+
+// Picks the next chunk (at most max_frames) over which the voice's gain is
+// a single linear ramp and returns that ramp. Flat envelope spans come back
+// whole; attack, release, steal fades and gain smoothing are stepped at
+// control rate.
+static MixRamp voice_next_ramp(ActiveVoice *voice, uint64_t frame, uint32_t max_frames, uint32_t *out_chunk) {
+    uint32_t chunk = max_frames;
+    if (voice->smooth_frames > 0) {
+        if (chunk > ENVELOPE_CONTROL_FRAMES) chunk = ENVELOPE_CONTROL_FRAMES;
+        if (chunk > voice->smooth_frames) chunk = voice->smooth_frames;
+    }
+    double e0 = 1.0;
+    double e1 = 1.0;
+    uint64_t flat = envelope_flat_frames(voice, frame);
+    if (flat > 0) {
+        if (flat < chunk) chunk = (uint32_t)flat;
+    } else {
+        if (chunk > ENVELOPE_CONTROL_FRAMES) chunk = ENVELOPE_CONTROL_FRAMES;
+        e0 = voice_envelope(voice, frame);
+        e1 = voice_envelope(voice, frame + chunk);
+    }
+    *out_chunk = chunk;
+    return voice_block_ramp(voice, e0, e1, chunk);
+}
+
+static bool voice_fade_done(const ActiveVoice *voice, uint64_t frame) {
+    return voice->fade_frames > 0 && frame >= voice->fade_start_frame + voice->fade_frames;
+}
+
+// Generates frames frames of the voice's un-enveloped source signal into
+// dst (interleaved, sample channels wide; mono for synths), zero-filling
+// past the end. Returns false when the voice ends within these frames.
+static bool render_voice_source(ActiveVoice *voice, uint64_t global_frame, float *dst, uint32_t frames) {
+    if (voice->is_synth) {
+        uint32_t pos = 0;
+        while (pos < frames) {
+            uint64_t frame = global_frame + pos;
+            if (voice->note_off_frame > 0 && frame >= voice->note_off_frame) {
+                synth_voice_release(&voice->synth);
+                voice->note_off_frame = 0;
+            }
+            if (!synth_voice_active(&voice->synth)) break;
+            uint32_t n = frames - pos;
+            if (voice->note_off_frame > frame && voice->note_off_frame - frame < n) {
+                n = (uint32_t)(voice->note_off_frame - frame);
             }
+            synth_voice_render(&voice->synth, dst + pos, n);
+            pos += n;
+        }
+        if (pos < frames) memset(dst + pos, 0, sizeof(float) * (frames - pos));
+        return synth_voice_active(&voice->synth) && !voice_fade_done(voice, global_frame + frames);
+    }
 
-            tail = next_index(tail);
-            atomic_store(&engine->event_tail, tail);
-            head = atomic_load(&engine->event_head);
+    const AudioSample *sample = voice->sample;
+    const uint32_t src_channels = sample->channels;
+    uint64_t remaining = voice_frames_remaining(voice, global_frame);
+    uint32_t n = remaining < frames ? (uint32_t)remaining : frames;
+    if (sample->format == AUDIO_SAMPLE_F32 && voice->increment == RESAMPLE_ONE && (voice->position & (RESAMPLE_ONE - 1)) == 0) {
+        const float *src = sample->data + (size_t)(voice->position >> RESAMPLE_FRAC_BITS) * src_channels;
+        memcpy(dst, src, sizeof(float) * (size_t)n * src_channels);
+        voice->position += (uint64_t)n << RESAMPLE_FRAC_BITS;
+    } else if (n > 0) {
+        voice->position = sample_resample(sample, voice->resample_quality, voice->position, voice->increment, dst, n);
+    }
+    if (n < frames) {
+        memset(dst + (size_t)n * src_channels, 0, sizeof(float) * (size_t)(frames - n) * src_channels);
+    }
+    return remaining > frames;
+}
+
+// Synth voices generate their own mono signal (ADSR included) into the
+// scratch buffer; only the steal fade and gain/pan are applied here.
+static bool render_synth_voice(const AudioEngine *engine, RenderTarget *target, ActiveVoice *voice, uint32_t offset, uint64_t global_frame, uint32_t frames) {
+    uint32_t pos = 0;
+    while (pos < frames) {
+        uint32_t n = frames - pos;
+        if (n > AUDIO_MIX_SCRATCH_FRAMES) n = AUDIO_MIX_SCRATCH_FRAMES;
+        bool alive = render_voice_source(voice, global_frame + pos, target->scratch, n);
+        uint32_t done = 0;
+        while (done < n) {
+            uint32_t chunk = 0;
+            MixRamp ramp = voice_next_ramp(voice, global_frame + pos + done, n - done, &chunk);
+            voice_mix(engine, target, voice, offset + pos + done, target->scratch + done, chunk, 1, &ramp);
+            done += chunk;
         }
+        if (!alive) return false;
+        pos += n;
+    }
+    return true;
+}
 
-        for (size_t v = 0; v < engine->voice_count;) {
-            ActiveVoice *voice = &engine->voices[v];
-            if (!voice->sample) {
-                engine->voices[v] = engine->voices[--engine->voice_count];
-                continue;
+// Renders one voice over a contiguous span of the block, starting at
+// offset, with no event boundaries inside it. Returns false once the voice
+// has finished and can be released.
+static bool render_voice(const AudioEngine *engine,
+                         RenderTarget *target,
+                         ActiveVoice *voice,
+                         uint32_t offset,
+                         uint64_t global_frame,
+                         uint32_t frames) {
+    if (voice->is_synth) return render_synth_voice(engine, target, voice, offset, global_frame, frames);
+    if (!voice->sample || voice->sample->frame_count == 0) return false;
+    uint64_t remaining = voice_frames_remaining(voice, global_frame);
+    uint32_t render_frames = remaining < frames ? (uint32_t)remaining : frames;
+
+    uint32_t pos = 0;
+    while (pos < render_frames) {
+        uint32_t chunk = 0;
+        MixRamp ramp = voice_next_ramp(voice, global_frame + pos, render_frames - pos, &chunk);
+        mix_span(engine, target, voice, offset + pos, chunk, &ramp);
+        pos += chunk;
+    }
+    return remaining > frames;
+}
+
+// Filtered voices are rendered in lockstep, one FILTER_BLOCK_FRAMES block
+// at a time: every voice writes its source into its filter-bank lanes, the
+// bank filters all lanes together (several voices per SIMD instruction),
+// then each voice mixes its filtered lanes with its envelope and gains.
+static void render_filtered_voices(AudioEngine *engine, uint32_t offset, uint64_t global_frame, uint32_t frames) {
+    VoicePool *pool = &engine->pool;
+    FilterBank *bank = &pool->filters;
+    RenderTarget *target = &engine->target;
+    float *scratch = target->scratch;
+
+    uint32_t pos = 0;
+    while (pos < frames && pool->filtered_count > 0) {
+        uint32_t n = frames - pos;
+        if (n > FILTER_BLOCK_FRAMES) n = FILTER_BLOCK_FRAMES;
+        uint64_t frame = global_frame + pos;
+
+        for (uint32_t v = 0; v < pool->active_count; ++v) {
+            uint32_t slot = pool->active[v];
+            ActiveVoice *voice = &pool->voices[slot];
+            if (!voice->filtered) continue;
+            voice->block_alive = render_voice_source(voice, frame, scratch, n);
+            uint32_t src_channels = voice->is_synth ? 1 : voice->sample->channels;
+            for (uint32_t ch = 0; ch < voice->filter_channels; ++ch) {
+                float *lane = bank->buffer + filter_bank_lane(bank, slot, ch);
+                for (uint32_t f = 0; f < n; ++f) {
+                    lane[(size_t)f * bank->lanes] = scratch[(size_t)f * src_channels + ch];
+                }
             }
+        }
+
+        bank->process(bank, n);
 
-            if (global_frame < voice->start_frame) {
+        for (uint32_t v = 0; v < pool->active_count;) {
+            uint32_t slot = pool->active[v];
+            ActiveVoice *voice = &pool->voices[slot];
+            if (!voice->filtered) {
                 ++v;
                 continue;
             }
+            const uint32_t lane_channels = voice->filter_channels;
+            for (uint32_t ch = 0; ch < lane_channels; ++ch) {
+                const float *lane = bank->buffer + filter_bank_lane(bank, slot, ch);
+                for (uint32_t f = 0; f < n; ++f) {
+                    scratch[(size_t)f * lane_channels + ch] = lane[(size_t)f * bank->lanes];
+                }
+            }
+            uint32_t done = 0;
+            while (done < n) {
+                uint32_t chunk = 0;
+                MixRamp ramp = voice_next_ramp(voice, frame + done, n - done, &chunk);
+                voice_mix(engine,
+                          target,
+                          voice,
+                          offset + pos + done,
+                          scratch + (size_t)done * lane_channels,
+                          chunk,
+                          lane_channels,
+                          &ramp);
+                done += chunk;
+            }
+            if (!voice->block_alive) {
+                voice_pool_release(pool, &engine->held, v);
+                continue;
+            }
+            ++v;
+        }
+        pos += n;
+    }
+}
+
+// Worker job: renders part `part` of the active list (filtered voices
+// excluded) into that part's target. Voices only record whether they are
+// still alive; the device thread releases them afterwards.
+static void render_voice_part(void *context, uint32_t part) {
+    AudioEngine *engine = (AudioEngine *)context;
+    const RenderJob *job = &engine->render_job;
+    VoicePool *pool = &engine->pool;
+    RenderTarget *target = part == 0 ? &engine->target : &engine->worker_targets[part - 1];
+    if (part > 0) {
+        // Helper targets only hold this span; the device thread sums them.
+        target->live_buses = 0;
+        target->live_offset = job->offset;
+        target->live_frames = job->frames;
+        for (int s = 0; s < AUDIO_SEND_COUNT; ++s) {
+            memset(target->send[s] + (size_t)job->offset * 2, 0, sizeof(float) * job->frames * 2);
+        }
+    }
+    const uint32_t parts = engine->workers.count + 1;
+    const uint32_t begin = (uint32_t)((uint64_t)job->voice_count * part / parts);
+    const uint32_t end = (uint32_t)((uint64_t)job->voice_count * (part + 1) / parts);
+    for (uint32_t v = begin; v < end; ++v) {
+        ActiveVoice *voice = &pool->voices[pool->active[v]];
+        if (voice->filtered) continue;
+        voice->block_alive = render_voice(engine, target, voice, job->offset, job->global_frame, job->frames);
+    }
+}
 
-            double offset = ((double)(global_frame - voice->start_frame)) * voice->playback_rate;
-            uint64_t offset_i = (uint64_t)offset;
+// Splits the unfiltered voices of one span across the render threads, sums
+// their partial outputs and send buses into the main target, then releases
+// the voices that finished.
+static void render_voices_parallel(AudioEngine *engine, uint32_t offset, uint64_t global_frame, uint32_t frames) {
+    VoicePool *pool = &engine->pool;
+    engine->render_job.global_frame = global_frame;
+    engine->render_job.offset = offset;
+    engine->render_job.frames = frames;
+    engine->render_job.voice_count = pool->active_count;
+    worker_pool_run(&engine->workers, render_voice_part, engine);
 
-            if (offset_i >= voice->sample->frame_count) {
-                engine->voices[v] = engine->voices[--engine->voice_count];
-                continue;
+    const uint32_t bus_channels = engine->bus_channels;
+    const size_t samples = (size_t)frames * bus_channels;
+    for (uint32_t w = 0; w < engine->workers.count; ++w) {
+        const RenderTarget *part = &engine->worker_targets[w];
+        for (uint32_t b = 0; b < AUDIO_BUS_COUNT; ++b) {
+            if (!(part->live_buses & (1u << b))) continue;
+            float *out = target_bus(&engine->target, b, bus_channels) + (size_t)offset * bus_channels;
+            const float *src = part->bus[b] + (size_t)offset * bus_channels;
+            for (size_t i = 0; i < samples; ++i) {
+                out[i] += src[i];
+            }
+        }
+        for (int s = 0; s < AUDIO_SEND_COUNT; ++s) {
+            float *bus = engine->target.send[s] + (size_t)offset * 2;
+            const float *part_bus = part->send[s] + (size_t)offset * 2;
+            for (uint32_t i = 0; i < frames * 2; ++i) {
+                bus[i] += part_bus[i];
             }
+        }
+    }
+
+    for (uint32_t v = 0; v < pool->active_count;) {
+        ActiveVoice *voice = &pool->voices[pool->active[v]];
+        if (!voice->filtered && !voice->block_alive) {
+            voice_pool_release(pool, &engine->held, v);
+            continue;
+        }
+        ++v;
+    }
+}
 
-            double amplitude = 1.0;
-            if (voice->is_pitched) {
-                uint64_t frames_since_start = global_frame - voice->start_frame;
+// Mute, solo and gain folded into one gain per bus. Mute wins over solo.
+static float bus_target_gain(const AudioEngine *engine, uint32_t bus, uint32_t mute, uint32_t solo) {
+    uint32_t bit = 1u << bus;
+    if ((mute & bit) || (solo != 0 && !(solo & bit))) return 0.0f;
+    return atomic_load_explicit(&engine->bus_gain[bus], memory_order_relaxed);
+}
 
-                if (voice->attack_frames > 0 && frames_since_start < voice->attack_frames) {
-                    amplitude *= (double)frames_since_start / (double)voice->attack_frames;
-                }
+// Reads the fader controls once per block: every bus ramps from where the
+// last block ended to the newly requested gain.
+static void update_bus_faders(AudioEngine *engine, uint32_t frames) {
+    uint32_t mute = atomic_load_explicit(&engine->bus_mute, memory_order_relaxed);
+    uint32_t solo = atomic_load_explicit(&engine->bus_solo, memory_order_relaxed);
+    for (uint32_t b = 0; b < AUDIO_BUS_COUNT; ++b) {
+        engine->bus_from[b] = engine->bus_to[b];
+        engine->bus_to[b] = bus_target_gain(engine, b, mute, solo);
+    }
+    engine->block_frames = frames;
+}
 
-                if (voice->note_off_frame > 0 && global_frame >= voice->note_off_frame) {
-                    uint64_t release_pos = global_frame - voice->note_off_frame;
-                    if (release_pos >= voice->release_frames) {
-                        engine->voices[v] = engine->voices[--engine->voice_count];
-                        continue;
+// Fades every bus that received audio this block into the master. Buses
+// with their own device outputs are faded in place first, so the copy
+// written to those channels is post-fader too.
+static void mix_buses(AudioEngine *engine, uint32_t frames) {
+    RenderTarget *target = &engine->target;
+    const uint32_t bus_channels = engine->bus_channels;
+    for (uint32_t b = 0; b < AUDIO_BUS_COUNT; ++b) {
+        if (!(target->live_buses & (1u << b))) continue;
+        float from = engine->bus_from[b];
+        float to = engine->bus_to[b];
+        MixRamp ramp = mix_ramp_uniform(from, (to - from) / (float)frames);
+        if (b >= 1 && b <= engine->bus_outputs) {
+            float *bus = target->bus[b];
+            if (from != 1.0f || to != 1.0f) {
+                for (uint32_t f = 0; f < frames; ++f) {
+                    float g = from + ramp.step[0] * (float)f;
+                    for (uint32_t c = 0; c < bus_channels; ++c) {
+                        bus[(size_t)f * bus_channels + c] *= g;
                     }
-                    double release_amp = 1.0 - ((double)release_pos / (double)voice->release_frames);
-                    amplitude *= release_amp;
                 }
             }
+            ramp = mix_ramp_uniform(1.0f, 0.0f);
+        } else if (from == 0.0f && to == 0.0f) {
+            continue;
+        }
+        engine->bus_kernel(target->out, target->bus[b], frames, bus_channels, engine->mix_channels, &ramp);
+    }
+}
+
+// With bus outputs the master is rendered into master_block; this
+// interleaves it into the device buffer as channels 0-1, followed by one
+// channel pair per chain bus.
+static void write_bus_outputs(AudioEngine *engine, float *out, uint32_t frames) {
+    const uint32_t channels = engine->channels;
+    const RenderTarget *target = &engine->target;
+    for (uint32_t f = 0; f < frames; ++f) {
+        float *frame = out + (size_t)f * channels;
+        frame[0] = engine->master_block[2 * f];
+        frame[1] = engine->master_block[2 * f + 1];
+        for (uint32_t b = 1; b <= engine->bus_outputs; ++b) {
+            bool live = (target->live_buses & (1u << b)) != 0;
+            frame[2 * b] = live ? target->bus[b][2 * f] : 0.0f;
+            frame[2 * b + 1] = live ? target->bus[b][2 * f + 1] : 0.0f;
+        }
+    }
+}
 
-            for (uint32_t ch = 0; ch < channels; ++ch) {
-                uint32_t sample_ch = ch % voice->sample->channels;
-                float s = voice->sample->data[offset_i * voice->sample->channels + sample_ch];
-                out[frame * channels + ch] += (float)(s * amplitude);
+// Runs the send buses over the block and adds their stereo returns to the
+// device channels (averaged for mono, by channel parity beyond stereo).
+static void mix_send_returns(AudioEngine *engine, uint32_t frames) {
+    float *ret = engine->fx_return;
+    memset(ret, 0, sizeof(float) * frames * 2);
+    if (engine->fx_clear_stage != FX_CLEAR_IDLE) return; // bypassed while their state is cleared
+    delay_fx_process(&engine->delay, engine->target.send[AUDIO_SEND_DELAY], ret, frames);
+    Convolver *conv = atomic_load_explicit(&engine->convolver, memory_order_acquire);
+    if (conv) {
+        convolver_process(conv, engine->target.send[AUDIO_SEND_REVERB], ret, frames);
+    } else {
+        reverb_fx_process(&engine->reverb, engine->target.send[AUDIO_SEND_REVERB], ret, frames);
+    }
+
+    const uint32_t channels = engine->mix_channels;
+    float *out = engine->target.out;
+    for (uint32_t f = 0; f < frames; ++f) {
+        if (channels == 1) {
+            out[f] += 0.5f * (ret[2 * f] + ret[2 * f + 1]);
+            continue;
+        }
+        for (uint32_t c = 0; c < channels; ++c) {
+            out[(size_t)f * channels + c] += ret[2 * f + (c & 1)];
+        }
+    }
+}
+
+// Renders one block of at most AUDIO_BLOCK_FRAMES into engine->target.
+// The block is split at the exact frames where queued events start, and
+// each voice is rendered across the whole span between two such boundaries.
+static void render_block(AudioEngine *engine, uint64_t block_frame, uint32_t frames) {
+    VoicePool *pool = &engine->pool;
+    for (int s = 0; s < AUDIO_SEND_COUNT; ++s) {
+        memset(engine->target.send[s], 0, sizeof(float) * frames * 2);
+    }
+    engine->target.live_buses = 0;
+    engine->target.live_offset = 0;
+    engine->target.live_frames = frames;
+    update_bus_faders(engine, frames);
+
+    uint32_t offset = 0;
+    while (offset < frames) {
+        uint64_t global_frame = block_frame + offset;
+        uint64_t next_event = start_due_events(engine, global_frame);
+        uint32_t span = frames - offset;
+        if (next_event - global_frame < span) {
+            span = (uint32_t)(next_event - global_frame);
+        }
+
+        if (engine->workers.count > 0 && pool->active_count - pool->filtered_count >= PARALLEL_MIN_VOICES) {
+            render_voices_parallel(engine, offset, global_frame, span);
+        } else {
+            for (uint32_t v = 0; v < pool->active_count;) {
+                ActiveVoice *voice = &pool->voices[pool->active[v]];
+                if (voice->filtered) {
+                    ++v;
+                    continue;
+                }
+                if (!render_voice(engine, &engine->target, voice, offset, global_frame, span)) {
+                    voice_pool_release(pool, &engine->held, v);
+                    continue;
+                }
+                ++v;
             }
-            ++v;
         }
+        if (pool->filtered_count > 0) {
+            render_filtered_voices(engine, offset, global_frame, span);
+        }
+        offset += span;
+    }
+
+    mix_buses(engine, frames);
+    mix_send_returns(engine, frames);
+}
+
+// Starts clearing the effect state. The delay lines and the convolver's
+// spectra can run to megabytes, so they are cleared over the following
+// periods by continue_effect_clear rather than all in this one; the limiter
+// is small and cleared now.
+static void clear_effect_state(AudioEngine *engine) {
+    engine->fx_clear_stage = FX_CLEAR_DELAY;
+    engine->fx_clear_cursor = 0;
+    master_limiter_clear(&engine->limiter);
+}
+
+static void continue_effect_clear(AudioEngine *engine) {
+    size_t budget = FX_CLEAR_SLICE_FLOATS;
+    while (engine->fx_clear_stage != FX_CLEAR_IDLE && budget > 0) {
+        bool done = true;
+        if (engine->fx_clear_stage == FX_CLEAR_DELAY) {
+            done = delay_fx_clear_step(&engine->delay, &engine->fx_clear_cursor, &budget);
+        } else if (engine->fx_clear_stage == FX_CLEAR_REVERB) {
+            done = reverb_fx_clear_step(&engine->reverb, &engine->fx_clear_cursor, &budget);
+        } else {
+            Convolver *conv = atomic_load_explicit(&engine->convolver, memory_order_acquire);
+            if (conv) done = convolver_clear_step(conv, &engine->fx_clear_cursor, &budget);
+        }
+        if (!done) break;
+        engine->fx_clear_cursor = 0;
+        engine->fx_clear_stage = engine->fx_clear_stage == FX_CLEAR_CONVOLVER ? FX_CLEAR_IDLE : engine->fx_clear_stage + 1;
+    }
+}
+
+// Renders one device period (or one offline chunk) into out.
+static void render_period(AudioEngine *engine, float *out, uint32_t frame_count) {
+    const uint32_t channels = engine->channels;
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    memset(out, 0, sizeof(float) * frame_count * channels);
+
+    if (atomic_exchange(&engine->panic, false)) {
+        voice_pool_reset(&engine->pool);
+        clear_effect_state(engine);
+        atomic_store_explicit(&engine->ring.tail, atomic_load_explicit(&engine->ring.head, memory_order_acquire), memory_order_release);
+        event_stage_reset(&engine->stage);
+        audio_epoch_holds_reset(&engine->held);
+    }
+    if (engine->fx_clear_stage != FX_CLEAR_IDLE) continue_effect_clear(engine);
+    uint64_t entered = audio_epoch_enter(&engine->epoch);
+    bool drained = drain_event_ring(engine);
+
+    uint64_t frame_cursor = atomic_load(&engine->frame_cursor);
+    uint32_t frame = 0;
+    uint32_t replaced = 0;
+    float min_gain = 1.0f;
+    while (frame < frame_count) {
+        uint32_t block = frame_count - frame;
+        if (block > AUDIO_BLOCK_FRAMES) block = AUDIO_BLOCK_FRAMES;
+        float *dst = out + (size_t)frame * channels;
+        if (engine->bus_outputs > 0) {
+            memset(engine->master_block, 0, sizeof(float) * block * 2);
+            engine->target.out = engine->master_block;
+        } else {
+            engine->target.out = dst;
+        }
+        render_block(engine, frame_cursor + frame, block);
+        replaced += master_limiter_process(&engine->limiter, engine->target.out, block);
+        if (engine->limiter.min_gain < min_gain) min_gain = engine->limiter.min_gain;
+        if (engine->bus_outputs > 0) write_bus_outputs(engine, dst, block);
+        frame += block;
     }
 
     atomic_store(&engine->frame_cursor, frame_cursor + frame_count);
+    // Events left in the ring were not looked at, so the epoch cannot move.
+    if (drained) audio_epoch_publish(&engine->epoch, audio_epoch_oldest(&engine->held, entered));
+
+    if (replaced > 0) {
+        // A NaN or Inf would otherwise circulate in the effect feedback
+        // paths forever.
+        audio_stats_add(&engine->stats.samples_sanitized, replaced);
+        clear_effect_state(engine);
+    }
+    if (min_gain < 0.999f) {
+        audio_stats_add(&engine->stats.limited_periods, 1);
+    }
+
+    struct timespec finished;
+    clock_gettime(CLOCK_MONOTONIC, &finished);
+    uint64_t elapsed = (uint64_t)((int64_t)(finished.tv_sec - started.tv_sec) * 1000000000LL + (finished.tv_nsec - started.tv_nsec));
+    uint64_t deadline = (uint64_t)frame_count * 1000000000ULL / engine->sample_rate;
+    audio_stats_record_period(&engine->stats, elapsed, deadline);
+    audio_stats_record_voices(&engine->stats, engine->pool.active_count);
 }
 
-bool audio_engine_init(AudioEngine *engine, uint32_t sample_rate, uint32_t channels) {
+static void audio_callback(ma_device *device, void *output, const void *input, ma_uint32 frame_count) {
+    (void)input;
+    AudioEngine *engine = (AudioEngine *)device->config.pUserData;
+    if (!engine->audio_thread_prepared) {
+        if (engine->flush_denormals) rt_flush_denormals();
+        engine->audio_thread_prepared = true;
+    }
+    // The backend counts underruns on this same thread.
+    if (device->xrunCount != engine->device_xruns_seen) {
+        audio_stats_add(&engine->stats.xruns, device->xrunCount - engine->device_xruns_seen);
+        engine->device_xruns_seen = device->xrunCount;
+    }
+    render_period(engine, (float *)output, frame_count);
+}
+
+AudioEngineConfig audio_engine_config_init(uint32_t sample_rate, uint32_t channels) {
+    AudioEngineConfig config;
+    config.backend = AUDIO_BACKEND_DEVICE;
+    config.output_path = NULL;
+    config.device_name = NULL;
+    config.period_frames = AUDIO_DEFAULT_PERIOD_FRAMES;
+    config.periods = 3;
+    config.latency_ms = 0.0;
+    config.sample_rate = sample_rate ? sample_rate : 48000;
+    config.channels = channels ? channels : 2;
+    config.resample_quality = RESAMPLE_CUBIC;
+    config.voice_capacity = AUDIO_DEFAULT_VOICES;
+    config.steal_policy = VOICE_STEAL_OLDEST;
+    config.tempo_bpm = 120.0;
+    config.delay_beats = 0.75;
+    config.delay_feedback = 0.45;
+    config.reverb_decay = 2.5;
+    config.reverb_impulse = NULL;
+    config.render_threads = 1;
+    config.event_capacity = AUDIO_DEFAULT_EVENT_CAPACITY;
+    config.realtime = rt_config_default();
+    config.master_ceiling_db = -1.0f;
+    config.bus_outputs = 0;
+    return config;
+}
+
+enum { IMPULSE_LOWPASS_HALF = 64 };
+
+// Windowed-sinc (Blackman) low-pass of interleaved frames into dst, cutoff
+// in cycles per frame. Used before decimating an impulse response so its
+// top octave does not fold back into the tail.
+static void impulse_lowpass(const float *src, float *dst, uint32_t frames, uint32_t channels, double cutoff) {
+    float taps[2 * IMPULSE_LOWPASS_HALF + 1];
+    double sum = 0.0;
+    for (int k = -IMPULSE_LOWPASS_HALF; k <= IMPULSE_LOWPASS_HALF; ++k) {
+        double x = 2.0 * cutoff * k;
+        double sinc = k == 0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+        double w = (double)(k + IMPULSE_LOWPASS_HALF) / (2.0 * IMPULSE_LOWPASS_HALF);
+        double window = 0.42 - 0.5 * cos(2.0 * M_PI * w) + 0.08 * cos(4.0 * M_PI * w);
+        taps[k + IMPULSE_LOWPASS_HALF] = (float)(sinc * window);
+        sum += sinc * window;
+    }
+    for (int k = 0; k <= 2 * IMPULSE_LOWPASS_HALF; ++k) {
+        taps[k] = (float)(taps[k] / sum); // unity gain at DC
+    }
+    for (uint32_t f = 0; f < frames; ++f) {
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+            float acc = 0.0f;
+            for (int k = -IMPULSE_LOWPASS_HALF; k <= IMPULSE_LOWPASS_HALF; ++k) {
+                int64_t i = (int64_t)f + k;
+                if (i < 0 || i >= (int64_t)frames) continue;
+                acc += taps[k + IMPULSE_LOWPASS_HALF] * src[(size_t)i * channels + ch];
+            }
+            dst[(size_t)f * channels + ch] = acc;
+        }
+    }
+}
+
+// Loads the impulse response, converts it to the engine rate, normalises
+// it to unit energy and runs every partition FFT, then hands the finished
+// convolver to the audio thread.
+static void *impulse_loader_thread(void *arg) {
+    AudioEngine *engine = (AudioEngine *)arg;
+    AudioSample ir;
+    if (!audio_sample_from_wav(engine->impulse_path, &ir)) {
+        fprintf(stderr, "Warning: could not load impulse response '%s' (keeping the built-in reverb)\n", engine->impulse_path);
+        return NULL;
+    }
+
+    const uint32_t channels = ir.channels;
+    const uint32_t max_frames = (uint32_t)(IMPULSE_MAX_SECONDS * (double)engine->sample_rate);
+    double ratio = 1.0;
+    if (ir.sample_rate > 0 && ir.sample_rate != engine->sample_rate) {
+        ratio = (double)ir.sample_rate / (double)engine->sample_rate;
+    }
+    uint32_t frames = (uint32_t)((double)ir.frame_count / ratio);
+    if (frames > max_frames) {
+        fprintf(stderr, "Warning: impulse response longer than %.0fs; truncating\n", IMPULSE_MAX_SECONDS);
+        frames = max_frames;
+    }
+    float *data = ir.data;
+    if (ratio != 1.0 && frames > 0) {
+        // Source frames the kept part reads, with room for the filter and
+        // interpolator taps past its end.
+        uint64_t reach = (uint64_t)((double)frames * ratio) + IMPULSE_LOWPASS_HALF + 4;
+        uint32_t source_frames = reach < ir.frame_count ? (uint32_t)reach : ir.frame_count;
+        data = (float *)malloc(sizeof(float) * (size_t)frames * channels);
+        // Going down in rate, everything above the new Nyquist is filtered
+        // out first; the cubic interpolator alone would alias it.
+        float *source = ir.data;
+        if (data && ratio > 1.0) {
+            source = (float *)malloc(sizeof(float) * (size_t)source_frames * channels);
+            if (source) impulse_lowpass(ir.data, source, source_frames, channels, 0.45 / ratio);
+        }
+        if (!data || !source) {
+            fprintf(stderr, "Warning: not enough memory to resample impulse response '%s'\n", engine->impulse_path);
+            free(data);
+            audio_sample_free(&ir);
+            return NULL;
+        }
+        resample_render(RESAMPLE_CUBIC, source, source_frames, channels, 0, resample_increment_from_rate(ratio), data, frames);
+        if (source != ir.data) free(source);
+    }
+    if (frames == 0) {
+        fprintf(stderr, "Warning: impulse response '%s' is empty at %u Hz (keeping the built-in reverb)\n",
+                engine->impulse_path, engine->sample_rate);
+        if (data != ir.data) free(data);
+        audio_sample_free(&ir);
+        return NULL;
+    }
+
+    double energy[2] = {0.0, 0.0};
+    for (uint32_t f = 0; f < frames; ++f) {
+        for (uint32_t ch = 0; ch < channels && ch < 2; ++ch) {
+            double x = data[(size_t)f * channels + ch];
+            energy[ch] += x * x;
+        }
+    }
+    double peak = energy[0] > energy[1] ? energy[0] : energy[1];
+    if (peak > 0.0) {
+        float scale = (float)(1.0 / sqrt(peak));
+        for (size_t i = 0; i < (size_t)frames * channels; ++i) {
+            data[i] *= scale;
+        }
+    }
+
+    Convolver *conv = (Convolver *)malloc(sizeof(Convolver));
+    if (conv && convolver_init(conv, data, frames, channels)) {
+        atomic_store_explicit(&engine->convolver, conv, memory_order_release);
+    } else {
+        fprintf(stderr, "Warning: not enough memory for impulse response '%s'\n", engine->impulse_path);
+        free(conv);
+    }
+    if (data != ir.data) free(data);
+    audio_sample_free(&ir);
+    return NULL;
+}
+
+static void engine_free_buffers(AudioEngine *engine) {
+    worker_pool_shutdown(&engine->workers);
+    free(engine->worker_targets);
+    free(engine->worker_buffers);
+    engine->worker_targets = NULL;
+    engine->worker_buffers = NULL;
+    if (engine->ir_thread_started) {
+        pthread_join(engine->ir_thread, NULL);
+        engine->ir_thread_started = false;
+    }
+    Convolver *conv = atomic_exchange(&engine->convolver, NULL);
+    if (conv) {
+        convolver_free(conv);
+        free(conv);
+    }
+    free(engine->impulse_path);
+    engine->impulse_path = NULL;
+    voice_pool_free(&engine->pool);
+    event_stage_free(&engine->stage);
+    event_ring_free(&engine->ring);
+    delay_fx_free(&engine->delay);
+    reverb_fx_free(&engine->reverb);
+    master_limiter_free(&engine->limiter);
+    audio_epoch_destroy(&engine->epoch);
+}
+
+// Gives every extra render thread its own bus, send and scratch buffers,
+// then starts the threads.
+static bool engine_init_workers(AudioEngine *engine, const AudioEngineConfig *config) {
+    uint32_t threads = config->render_threads > 0 ? config->render_threads : 1;
+    if (threads > WORKER_POOL_MAX + 1) threads = WORKER_POOL_MAX + 1;
+    uint32_t cpus = worker_pool_cpu_count();
+    if (threads > cpus) {
+        // Spinning helpers sharing a core only slow the callback down.
+        fprintf(stderr, "Warning: %u render threads requested but only %u CPUs online (using %u)\n", threads, cpus, cpus);
+        threads = cpus;
+    }
+    const uint32_t helpers = threads - 1;
+    if (helpers == 0) return true;
+
+    const size_t send_floats = (size_t)AUDIO_BLOCK_FRAMES * 2;
+    const size_t out_floats = AUDIO_BUS_COUNT * send_floats;
+    const size_t scratch_floats = (size_t)AUDIO_MIX_SCRATCH_FRAMES * AUDIO_MAX_SAMPLE_CHANNELS;
+    const size_t per_target = out_floats + AUDIO_SEND_COUNT * send_floats + scratch_floats;
+    engine->worker_targets = (RenderTarget *)calloc(helpers, sizeof(RenderTarget));
+    engine->worker_buffers = (float *)calloc(per_target * helpers, sizeof(float));
+    if (!engine->worker_targets || !engine->worker_buffers) return false;
+    for (uint32_t w = 0; w < helpers; ++w) {
+        float *base = engine->worker_buffers + per_target * w;
+        RenderTarget *target = &engine->worker_targets[w];
+        for (uint32_t b = 0; b < AUDIO_BUS_COUNT; ++b) {
+            target->bus[b] = base + send_floats * b;
+        }
+        for (int s = 0; s < AUDIO_SEND_COUNT; ++s) {
+            target->send[s] = base + out_floats + send_floats * (size_t)s;
+        }
+        target->scratch = base + out_floats + AUDIO_SEND_COUNT * send_floats;
+    }
+    worker_pool_init(&engine->workers, helpers, engine->flush_denormals ? &config->realtime : NULL);
+    return true;
+}
+
+// Sizes the send effects for the device rate. All effect memory is
+// allocated here so the callback never allocates.
+static bool engine_init_fx(AudioEngine *engine, const AudioEngineConfig *config) {
+    if (!delay_fx_init(&engine->delay, engine->sample_rate, DELAY_MAX_SECONDS)) return false;
+    double tempo = config->tempo_bpm > 0.0 ? config->tempo_bpm : 120.0;
+    double seconds = config->delay_beats * 60.0 / tempo;
+    if (seconds > DELAY_MAX_SECONDS) {
+        fprintf(stderr, "Warning: delay time %.2fs exceeds %.0fs; clamping\n", seconds, DELAY_MAX_SECONDS);
+    }
+    delay_fx_set(&engine->delay, seconds, engine->sample_rate, (float)config->delay_feedback);
+    if (!reverb_fx_init(&engine->reverb, engine->sample_rate, config->reverb_decay)) return false;
+    if (!master_limiter_init(&engine->limiter, engine->mix_channels, engine->sample_rate, config->master_ceiling_db)) return false;
+
+    if (config->reverb_impulse && config->reverb_impulse[0] != '\0') {
+        size_t len = strlen(config->reverb_impulse);
+        engine->impulse_path = (char *)malloc(len + 1);
+        if (!engine->impulse_path) return false;
+        memcpy(engine->impulse_path, config->reverb_impulse, len + 1);
+        if (pthread_create(&engine->ir_thread, NULL, impulse_loader_thread, engine) == 0) {
+            engine->ir_thread_started = true;
+        } else {
+            fprintf(stderr, "Warning: could not start impulse response loader\n");
+        }
+    }
+    return true;
+}
+
+// State shared by the device and offline engines, before any device exists.
+static bool engine_setup(AudioEngine *engine, const AudioEngineConfig *config) {
     memset(engine, 0, sizeof(*engine));
-    engine->sample_rate = sample_rate;
-    engine->channels = channels;
+    engine->sample_rate = config->sample_rate;
+    engine->bus_outputs = config->bus_outputs < AUDIO_MAX_CHAIN_BUSES ? config->bus_outputs : AUDIO_MAX_CHAIN_BUSES;
+    engine->channels = engine->bus_outputs > 0 ? 2 + 2 * engine->bus_outputs : config->channels;
+    engine->resample_quality = (config->resample_quality != RESAMPLE_DEFAULT) ? config->resample_quality : RESAMPLE_CUBIC;
     atomic_store(&engine->frame_cursor, 0);
-    atomic_store(&engine->event_head, 0);
-    atomic_store(&engine->event_tail, 0);
     atomic_store(&engine->panic, false);
+    atomic_store(&engine->convolver, NULL);
+    audio_stats_reset(&engine->stats);
+    audio_epoch_init(&engine->epoch);
+    audio_epoch_holds_reset(&engine->held);
+    for (int s = 0; s < AUDIO_SEND_COUNT; ++s) {
+        engine->target.send[s] = engine->send_bus[s];
+    }
+    engine->target.scratch = engine->mix_scratch;
+    for (uint32_t b = 0; b < AUDIO_BUS_COUNT; ++b) {
+        engine->target.bus[b] = engine->mix_bus[b];
+        atomic_store(&engine->bus_gain[b], 1.0f);
+        engine->bus_from[b] = 1.0f;
+        engine->bus_to[b] = 1.0f;
+    }
+    atomic_store(&engine->bus_mute, 0);
+    atomic_store(&engine->bus_solo, 0);
+    engine->steal_policy = config->steal_policy;
 
-    ma_device_config cfg = ma_device_config_init(channels, sample_rate);
+    if (!voice_pool_init(&engine->pool, config->voice_capacity)) {
+        fprintf(stderr, "Failed to allocate voice pool\n");
+        return false;
+    }
+    if (!event_ring_init(&engine->ring, config->event_capacity) ||
+        !event_stage_init(&engine->stage, engine->ring.capacity)) {
+        fprintf(stderr, "Failed to allocate event queue\n");
+        event_ring_free(&engine->ring);
+        voice_pool_free(&engine->pool);
+        return false;
+    }
+    resample_init();
+    return true;
+}
+
+// Everything sized from the final sample rate and channel count.
+static bool engine_finish_setup(AudioEngine *engine, const AudioEngineConfig *config) {
+    engine->steal_fade_frames = (uint64_t)((double)engine->sample_rate * STEAL_FADE_SECONDS);
+    if (engine->steal_fade_frames == 0) engine->steal_fade_frames = 1;
+    engine->gain_smooth_frames = (uint32_t)((double)engine->sample_rate * GAIN_SMOOTH_SECONDS);
+    if (engine->bus_outputs > 0) {
+        uint32_t pairs = engine->channels >= 4 ? (engine->channels - 2) / 2 : 0;
+        if (pairs < engine->bus_outputs) {
+            fprintf(stderr, "Warning: the device has %u channels; only %u bus outputs fit\n", engine->channels, pairs);
+            engine->bus_outputs = pairs;
+        }
+    }
+    engine->mix_channels = engine->bus_outputs > 0 ? 2 : engine->channels;
+    engine->bus_channels = engine->mix_channels == 1 ? 1 : 2;
+    mix_kernels_select(&engine->mix);
+    engine->bus_kernel = mix_kernel_for(&engine->mix, engine->bus_channels, engine->mix_channels);
+    if (!engine_init_fx(engine, config) || !engine_init_workers(engine, config)) {
+        fprintf(stderr, "Failed to allocate send effects or render threads\n");
+        return false;
+    }
+    return true;
+}
+
+bool audio_engine_init(AudioEngine *engine, const AudioEngineConfig *config) {
+    if (!engine || !config) return false;
+    if (!engine_setup(engine, config)) return false;
+
+    ma_device_config cfg = ma_device_config_init(engine->channels, engine->sample_rate);
     cfg.dataCallback = audio_callback;
     cfg.pUserData = engine;
+    cfg.pFilePath = config->output_path;
+    cfg.pDeviceName = config->device_name;
+    cfg.periods = config->periods >= 2 ? config->periods : 2;
+    cfg.periodSizeInFrames = config->period_frames;
+    if (config->latency_ms > 0.0) {
+        double frames = config->latency_ms * 0.001 * (double)engine->sample_rate / (double)cfg.periods;
+        cfg.periodSizeInFrames = frames > 16.0 ? (uint32_t)frames : 16;
+    }
+    if (cfg.periodSizeInFrames == 0) cfg.periodSizeInFrames = AUDIO_DEFAULT_PERIOD_FRAMES;
 
-    if (ma_context_init(NULL, 0, &engine->context) != 0) {
+    ma_backend backend = ma_backend_default;
+    if (config->backend == AUDIO_BACKEND_NULL) backend = ma_backend_null;
+    if (config->backend == AUDIO_BACKEND_FILE) backend = ma_backend_file;
+    if (ma_context_init(&backend, 1, &engine->context) != 0) {
         fprintf(stderr, "Failed to init audio context\n");
+        engine_free_buffers(engine);
         return false;
     }
     if (ma_device_init(&engine->context, &cfg, &engine->device) != 0) {
         fprintf(stderr, "Failed to init audio device\n");
         ma_context_uninit(&engine->context);
+        engine_free_buffers(engine);
         return false;
     }
     engine->sample_rate = engine->device.config.sampleRate;
     engine->channels = engine->device.config.channels;
+    engine->flush_denormals = config->realtime.enabled;
+    if (!engine_finish_setup(engine, config)) {
+        ma_device_uninit(&engine->device);
+        ma_context_uninit(&engine->context);
+        engine_free_buffers(engine);
+        return false;
+    }
+    // Lock before the device starts so everything the callback touches is
+    // resident from the first period.
+    if (config->realtime.enabled && config->realtime.lock_memory && !rt_lock_memory()) {
+        fprintf(stderr, "Warning: could not lock memory (raise the memlock limit or run with CAP_IPC_LOCK)\n");
+    }
     if (ma_device_start(&engine->device) != 0) {
         fprintf(stderr, "Failed to start audio device\n");
         ma_device_uninit(&engine->device);
         ma_context_uninit(&engine->context);
+        engine_free_buffers(engine);
+        return false;
+    }
+    if (config->realtime.enabled) {
+        pthread_t thread;
+        if (ma_device_get_thread(&engine->device, &thread) != 0) {
+            fprintf(stderr, "Warning: this audio backend manages its own thread priority\n");
+        } else if (!rt_promote_thread(thread, config->realtime.priority, config->realtime.cpu)) {
+            fprintf(stderr, "Warning: SCHED_FIFO priority %d refused (needs CAP_SYS_NICE or an rtprio limit); "
+                            "audio runs at normal priority\n", config->realtime.priority);
+        }
+    }
+    return true;
+}
+
+bool audio_engine_init_offline(AudioEngine *engine, const AudioEngineConfig *config) {
+    if (!engine || !config) return false;
+    if (!engine_setup(engine, config)) return false;
+    engine->offline = true;
+    if (!engine_finish_setup(engine, config)) {
+        engine_free_buffers(engine);
         return false;
     }
+    // Renders must be reproducible, so wait for the impulse response rather
+    // than starting on the built-in reverb.
+    if (engine->ir_thread_started) {
+        pthread_join(engine->ir_thread, NULL);
+        engine->ir_thread_started = false;
+    }
     return true;
 }
 
+void audio_engine_render(AudioEngine *engine, float *out, uint32_t frames) {
+    render_period(engine, out, frames);
+}
+
 void audio_engine_shutdown(AudioEngine *engine) {
-    ma_device_uninit(&engine->device);
-    ma_context_uninit(&engine->context);
+    if (!engine->offline) {
+        ma_device_uninit(&engine->device);
+        ma_context_uninit(&engine->context);
+    }
+    engine_free_buffers(engine);
 }
 
 bool audio_engine_queue(AudioEngine *engine, const AudioSample *sample, uint64_t start_frame) {
@@ -171,21 +1546,95 @@ bool audio_engine_queue_rate(AudioEngine *engine,
                             double playback_rate,
                             bool is_pitched,
                             uint64_t note_duration_frames) {
-    size_t head = atomic_load(&engine->event_head);
-    size_t next = next_index(head);
-    size_t tail = atomic_load(&engine->event_tail);
-    if (next == tail) {
-        return false; // queue full
-    }
-    engine->event_queue[head].sample = sample;
-    engine->event_queue[head].start_frame = start_frame;
-    engine->event_queue[head].playback_rate = (playback_rate > 0.0) ? playback_rate : 1.0;
-    engine->event_queue[head].is_pitched = is_pitched;
-    engine->event_queue[head].note_duration_frames = note_duration_frames;
-    atomic_store(&engine->event_head, next);
+    ScheduledEvent event = audio_scheduled_event_init(sample, start_frame);
+    event.playback_rate = playback_rate;
+    event.is_pitched = is_pitched;
+    event.note_duration_frames = note_duration_frames;
+    return audio_engine_queue_event(engine, &event);
+}
+
+ScheduledEvent audio_scheduled_event_init(const AudioSample *sample, uint64_t start_frame) {
+    ScheduledEvent event = {0};
+    event.sample = sample;
+    event.start_frame = start_frame;
+    event.playback_rate = 1.0;
+    event.resample_quality = RESAMPLE_DEFAULT;
+    event.gain = 1.0f;
+    event.pan = 0.5f;
+    return event;
+}
+
+// Constant-power pan scaled so the centre position is unity gain, which
+// keeps unpanned material at its previous level. Mono sources are placed in
+// the stereo field; wider sources are balanced, so one side is attenuated
+// and neither side is boosted.
+static void pan_channel_gains(const AudioEngine *engine, const ScheduledEvent *event, float out_gain[2]) {
+    float gain = event->gain > 0.0f ? event->gain : 0.0f;
+    if (engine->mix_channels < 2) {
+        out_gain[0] = gain;
+        out_gain[1] = gain;
+        return;
+    }
+    double pan = event->pan;
+    if (!(pan >= 0.0)) pan = 0.0; // also catches NaN
+    if (pan > 1.0) pan = 1.0;
+    double left = M_SQRT2 * cos(pan * M_PI * 0.5);
+    double right = M_SQRT2 * sin(pan * M_PI * 0.5);
+    if (event->sample && event->sample->channels > 1) {
+        if (left > 1.0) left = 1.0;
+        if (right > 1.0) right = 1.0;
+    }
+    out_gain[0] = gain * (float)left;
+    out_gain[1] = gain * (float)right;
+}
+
+bool audio_engine_queue_push(AudioEngine *engine, const ScheduledEvent *event) {
+    if (!engine || !event) return false;
+    EventRing *ring = &engine->ring;
+    if (ring->pending - ring->tail_cache >= ring->capacity) {
+        ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (ring->pending - ring->tail_cache >= ring->capacity) {
+            audio_stats_add(&engine->stats.events_rejected, 1);
+            return false; // queue full
+        }
+    }
+    QueuedEvent *queued = &ring->slots[ring->pending & ring->mask];
+    queued->event = *event;
+    if (queued->event.playback_rate <= 0.0) {
+        queued->event.playback_rate = 1.0;
+    }
+    pan_channel_gains(engine, event, queued->channel_gain);
+    queued->filtered = voice_filter_enabled(&event->filter);
+    if (queued->filtered) {
+        filter_coeffs_from_params(&event->filter, engine->sample_rate, queued->filter_coeffs);
+    }
+    ++ring->pending;
     return true;
 }
 
+void audio_engine_queue_commit(AudioEngine *engine) {
+    if (!engine) return;
+    EventRing *ring = &engine->ring;
+    // Stamped here rather than on push: a retire between push and commit
+    // must not count these events as already seen.
+    uint64_t stamp = audio_epoch_stamp(&engine->epoch);
+    for (uint64_t i = atomic_load_explicit(&ring->head, memory_order_relaxed); i != ring->pending; ++i) {
+        ring->slots[i & ring->mask].event.epoch = stamp;
+    }
+    atomic_store_explicit(&ring->head, ring->pending, memory_order_release);
+}
+
+bool audio_engine_queue_event(AudioEngine *engine, const ScheduledEvent *event) {
+    if (!audio_engine_queue_push(engine, event)) return false;
+    audio_engine_queue_commit(engine);
+    return true;
+}
+
+void audio_engine_stats(const AudioEngine *engine, AudioStatsSnapshot *out) {
+    audio_stats_snapshot(&engine->stats, out);
+    out->voice_capacity = engine->pool.capacity;
+}
+
 double audio_engine_time_seconds(const AudioEngine *engine) {
     uint64_t frames = atomic_load(&engine->frame_cursor);
     if (engine->sample_rate == 0) return 0.0;
@@ -196,16 +1645,83 @@ void audio_engine_panic(AudioEngine *engine) {
     atomic_store(&engine->panic, true);
 }
 
+void audio_engine_set_bus_mute(AudioEngine *engine, uint32_t bus, bool mute) {
+    if (!engine || bus >= AUDIO_BUS_COUNT) return;
+    if (mute) {
+        atomic_fetch_or(&engine->bus_mute, 1u << bus);
+    } else {
+        atomic_fetch_and(&engine->bus_mute, ~(1u << bus));
+    }
+}
+
+void audio_engine_set_bus_solo(AudioEngine *engine, uint32_t bus, bool solo) {
+    if (!engine || bus >= AUDIO_BUS_COUNT) return;
+    if (solo) {
+        atomic_fetch_or(&engine->bus_solo, 1u << bus);
+    } else {
+        atomic_fetch_and(&engine->bus_solo, ~(1u << bus));
+    }
+}
+
+void audio_engine_set_bus_gain(AudioEngine *engine, uint32_t bus, float gain) {
+    if (!engine || bus >= AUDIO_BUS_COUNT) return;
+    if (!(gain >= 0.0f)) gain = 0.0f; // also catches NaN
+    atomic_store(&engine->bus_gain[bus], gain);
+}
+
+void audio_engine_bus_state(const AudioEngine *engine, uint32_t bus, AudioBusState *out) {
+    memset(out, 0, sizeof(*out));
+    if (!engine || bus >= AUDIO_BUS_COUNT) return;
+    uint32_t mute = atomic_load(&engine->bus_mute);
+    uint32_t solo = atomic_load(&engine->bus_solo);
+    out->gain = atomic_load(&engine->bus_gain[bus]);
+    out->mute = (mute & (1u << bus)) != 0;
+    out->solo = (solo & (1u << bus)) != 0;
+    out->audible = bus_target_gain(engine, bus, mute, solo) > 0.0f;
+}
+
+bool audio_backend_from_name(const char *name, AudioBackend *out_backend) {
+    if (!name || !out_backend) return false;
+    if (strcmp(name, "miniaudio") == 0 || strcmp(name, "default") == 0 || strcmp(name, "device") == 0) {
+        *out_backend = AUDIO_BACKEND_DEVICE;
+    } else if (strcmp(name, "null") == 0 || strcmp(name, "simulated") == 0) {
+        *out_backend = AUDIO_BACKEND_NULL;
+    } else if (strcmp(name, "file") == 0) {
+        *out_backend = AUDIO_BACKEND_FILE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool audio_voice_steal_policy_from_name(const char *name, VoiceStealPolicy *out_policy) {
+    if (!name || !out_policy) return false;
+    if (strcmp(name, "oldest") == 0 || strcmp(name, "age") == 0) {
+        *out_policy = VOICE_STEAL_OLDEST;
+    } else if (strcmp(name, "quietest") == 0 || strcmp(name, "amplitude") == 0) {
+        *out_policy = VOICE_STEAL_QUIETEST;
+    } else if (strcmp(name, "priority") == 0) {
+        *out_policy = VOICE_STEAL_PRIORITY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 bool audio_sample_generate_sine(AudioSample *out_sample, double seconds, uint32_t sample_rate, double frequency) {
     if (!out_sample) return false;
+    memset(out_sample, 0, sizeof(*out_sample));
     uint32_t frames = (uint32_t)(seconds * (double)sample_rate);
-    float *data = (float *)malloc(sizeof(float) * frames);
+    float *data = (float *)rt_alloc_buffer(sizeof(float) * frames);
     if (!data) return false;
     for (uint32_t i = 0; i < frames; ++i) {
         double t = (double)i / (double)sample_rate;
         data[i] = (float)sin(2.0 * M_PI * frequency * t) * 0.4f;
     }
+    rt_lock_buffer(data, sizeof(float) * frames);
     out_sample->data = data;
+    out_sample->mapping = data;
+    out_sample->mapping_bytes = sizeof(float) * frames;
     out_sample->frame_count = frames;
     out_sample->channels = 1;
     out_sample->sample_rate = sample_rate;
@@ -216,7 +1732,32 @@ static uint32_t read_le32(const unsigned char *p) {
     return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
 }
 
+bool audio_sample_format_from_name(const char *name, AudioSampleFormat *out_format) {
+    if (!name || !out_format) return false;
+    if (strcmp(name, "float") == 0 || strcmp(name, "f32") == 0) {
+        *out_format = AUDIO_SAMPLE_F32;
+    } else if (strcmp(name, "int16") == 0 || strcmp(name, "s16") == 0) {
+        *out_format = AUDIO_SAMPLE_S16;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *audio_sample_format_name(AudioSampleFormat format) {
+    return format == AUDIO_SAMPLE_S16 ? "int16" : "float";
+}
+
+size_t audio_sample_bytes(const AudioSample *sample) {
+    size_t width = sample->format == AUDIO_SAMPLE_S16 ? sizeof(int16_t) : sizeof(float);
+    return (size_t)sample->frame_count * sample->channels * width;
+}
+
 bool audio_sample_from_wav(const char *path, AudioSample *out_sample) {
+    return audio_sample_from_wav_as(path, AUDIO_SAMPLE_F32, out_sample);
+}
+
+bool audio_sample_from_wav_as(const char *path, AudioSampleFormat format, AudioSample *out_sample) {
     if (!out_sample) return false;
     memset(out_sample, 0, sizeof(*out_sample));
 
@@ -240,7 +1781,7 @@ bool audio_sample_from_wav(const char *path, AudioSample *out_sample) {
     uint16_t bits_per_sample = header[34] | (header[35] << 8);
     uint32_t data_chunk_size = read_le32(header + 40);
 
-    if (audio_format != 1 || bits_per_sample != 16) {
+    if (audio_format != 1 || bits_per_sample != 16 || channels == 0 || channels > AUDIO_MAX_SAMPLE_CHANNELS) {
         fclose(f);
         return false;
     }
@@ -253,30 +1794,52 @@ bool audio_sample_from_wav(const char *path, AudioSample *out_sample) {
     }
 
     size_t frames = data_chunk_size / (channels * (bits_per_sample / 8));
-    int16_t *pcm16 = (int16_t *)malloc(data_chunk_size);
-    if (!pcm16) {
+    size_t total = frames * channels;
+    if (format == AUDIO_SAMPLE_S16) {
+        // The file is already in the storage format.
+        int16_t *pcm = (int16_t *)rt_alloc_buffer(sizeof(int16_t) * total);
+        if (!pcm || fread(pcm, sizeof(int16_t), total, f) != total) {
+            fclose(f);
+            rt_free_buffer(pcm, sizeof(int16_t) * total);
+            return false;
+        }
         fclose(f);
-        return false;
-    }
-    size_t read = fread(pcm16, 1, data_chunk_size, f);
-    fclose(f);
-    if (read != data_chunk_size) {
-        free(pcm16);
-        return false;
+        rt_lock_buffer(pcm, sizeof(int16_t) * total);
+        out_sample->data_s16 = pcm;
+        out_sample->mapping = pcm;
+        out_sample->mapping_bytes = sizeof(int16_t) * total;
+        out_sample->format = AUDIO_SAMPLE_S16;
+        out_sample->frame_count = (uint32_t)frames;
+        out_sample->channels = channels;
+        out_sample->sample_rate = sample_rate;
+        return true;
     }
-
-    float *data = (float *)malloc(sizeof(float) * frames * channels);
+    float *data = (float *)rt_alloc_buffer(sizeof(float) * total);
     if (!data) {
-        free(pcm16);
+        fclose(f);
         return false;
     }
-    for (size_t i = 0; i < frames * channels; ++i) {
-        data[i] = (float)pcm16[i] / 32768.0f;
+    // Converted through a small stack buffer rather than a second copy of
+    // the whole file.
+    int16_t pcm16[4096];
+    for (size_t done = 0; done < total;) {
+        size_t chunk = total - done < 4096 ? total - done : 4096;
+        if (fread(pcm16, sizeof(int16_t), chunk, f) != chunk) {
+            fclose(f);
+            rt_free_buffer(data, sizeof(float) * total);
+            return false;
+        }
+        for (size_t i = 0; i < chunk; ++i) {
+            data[done + i] = (float)pcm16[i] / 32768.0f;
+        }
+        done += chunk;
     }
-
-    free(pcm16);
+    fclose(f);
+    rt_lock_buffer(data, sizeof(float) * total);
 
     out_sample->data = data;
+    out_sample->mapping = data;
+    out_sample->mapping_bytes = sizeof(float) * total;
     out_sample->frame_count = (uint32_t)frames;
     out_sample->channels = channels;
     out_sample->sample_rate = sample_rate;
@@ -285,8 +1848,15 @@ bool audio_sample_from_wav(const char *path, AudioSample *out_sample) {
 
 void audio_sample_free(AudioSample *sample) {
     if (!sample) return;
-    free(sample->data);
+    if (sample->mapping) {
+        rt_free_buffer(sample->mapping, sample->mapping_bytes);
+    } else {
+        free(sample->data);
+    }
+    sample->mapping = NULL;
+    sample->mapping_bytes = 0;
     sample->data = NULL;
+    sample->format = AUDIO_SAMPLE_F32;
     sample->frame_count = 0;
     sample->channels = 0;
     sample->sample_rate = 0;
@@ -1,18 +1,95 @@
 #ifndef MUSIKA_AUDIO_H
 #define MUSIKA_AUDIO_H
 
+#include <pthread.h>
 #include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 #include "../third_party/miniaudio/miniaudio.h"
+#include "convolver.h"
+#include "epoch.h"
+#include "filter.h"
+#include "fx.h"
+#include "limiter.h"
+#include "mix.h"
+#include "resample.h"
+#include "rt.h"
+#include "stats.h"
+#include "synth.h"
+#include "workers.h"
+
+enum { AUDIO_MAX_SAMPLE_CHANNELS = 8 };
+enum { AUDIO_MIX_SCRATCH_FRAMES = 256 };
+enum { AUDIO_DEFAULT_VOICES = 64 };
+enum { AUDIO_BLOCK_FRAMES = 512 };
+enum { AUDIO_DEFAULT_PERIOD_FRAMES = 256 };
+enum { AUDIO_DEFAULT_EVENT_CAPACITY = 1024 };
+enum { AUDIO_MAX_EVENT_CAPACITY = 65536 };
+enum { AUDIO_CACHE_LINE = 64 };
+// Sub-mix buses: bus 0 carries steps outside any chain, bus n chain n.
+enum { AUDIO_MAX_CHAIN_BUSES = 16 };
+enum { AUDIO_BUS_COUNT = AUDIO_MAX_CHAIN_BUSES + 1 };
+
+// Global effect buses fed by per-voice send levels.
+typedef enum {
+    AUDIO_SEND_DELAY = 0,
+    AUDIO_SEND_REVERB,
+    AUDIO_SEND_COUNT,
+} AudioSend;
+
+typedef enum {
+    AUDIO_BACKEND_DEVICE = 0, // the platform's playback device
+    AUDIO_BACKEND_NULL,       // real-time paced, output discarded
+    AUDIO_BACKEND_FILE,       // real-time paced, output written to a WAV file
+} AudioBackend;
+
+typedef enum {
+    VOICE_STEAL_OLDEST = 0,
+    VOICE_STEAL_QUIETEST,
+    VOICE_STEAL_PRIORITY,
+} VoiceStealPolicy;
+
+// Where voices mix to: one block-sized buffer per sub-mix bus and the
+// stereo send bus inputs, plus resampler scratch. Render threads each own
+// one; only the audio thread's target has a master out. A bus buffer is
+// cleared over the live region the first time a voice mixes into it, so
+// idle buses cost nothing.
+typedef struct {
+    float *out; // master block, engine mix_channels wide
+    float *bus[AUDIO_BUS_COUNT];
+    uint32_t live_buses; // bit per bus holding audio in the live region
+    uint32_t live_offset;
+    uint32_t live_frames;
+    float *send[AUDIO_SEND_COUNT];
+    float *scratch; // AUDIO_MIX_SCRATCH_FRAMES * AUDIO_MAX_SAMPLE_CHANNELS
+} RenderTarget;
+
+// The span of the current block that render threads are working on.
+typedef struct {
+    uint64_t global_frame;
+    uint32_t offset;
+    uint32_t frames;
+    uint32_t voice_count;
+} RenderJob;
+
+typedef enum {
+    AUDIO_SAMPLE_F32 = 0,
+    AUDIO_SAMPLE_S16, // 16-bit PCM, widened to float as voices read it
+} AudioSampleFormat;
 
 typedef struct {
-    float *data;
+    union {
+        float *data;       // AUDIO_SAMPLE_F32
+        int16_t *data_s16; // AUDIO_SAMPLE_S16
+    };
+    AudioSampleFormat format;
     uint32_t frame_count;
     uint32_t channels;
     uint32_t sample_rate;
+    void *mapping;        // mapping data points into: a store file (pcmstore.h) or an rt_alloc_buffer
+    size_t mapping_bytes;
 } AudioSample;
 
 typedef struct {
@@ -21,38 +98,241 @@ typedef struct {
     double playback_rate;
     bool is_pitched;
     uint64_t note_duration_frames;
+    ResampleQuality resample_quality;
+    int priority; // higher keeps its voice longer under VOICE_STEAL_PRIORITY
+    float gain;
+    float pan; // 0 = left, 0.5 = centre, 1 = right
+    bool is_synth; // play synth instead of sample; note_duration_frames is the gate
+    SynthParams synth;
+    double frequency;
+    VoiceFilterParams filter;
+    float delay; // send level to the delay bus (0..1)
+    float room;  // send level to the reverb bus (0..1)
+    uint32_t bus; // sub-mix bus (0..AUDIO_BUS_COUNT-1)
+    uint64_t epoch; // set when committed; see AudioEpoch
 } ScheduledEvent;
 
+// Ring entry: the event plus its per-channel gains and filter coefficients,
+// computed when queued so the audio thread never evaluates the pan law or
+// designs filters.
+typedef struct {
+    ScheduledEvent event;
+    float channel_gain[2];
+    bool filtered;
+    SvfCoeffs filter_coeffs[FILTER_STAGES];
+} QueuedEvent;
+
+// Single-producer/single-consumer event ring. Indices count up forever and
+// are masked into the power-of-two slot array. Each side's index sits on its
+// own cache line; the producer also keeps a private copy of the tail there,
+// so it only reads the consumer's line when the ring looks full. Pushed
+// events stay invisible until a commit publishes the whole batch with one
+// release store of head.
+typedef struct {
+    _Alignas(AUDIO_CACHE_LINE) _Atomic uint64_t head; // published by the producer
+    uint64_t pending;    // producer: head plus events pushed but not committed
+    uint64_t tail_cache; // producer: last tail it read
+    _Alignas(AUDIO_CACHE_LINE) _Atomic uint64_t tail; // advanced by the consumer
+    _Alignas(AUDIO_CACHE_LINE) QueuedEvent *slots;
+    uint32_t capacity;
+    uint32_t mask;
+} EventRing;
+
+// Events the callback has taken off the ring but not yet started, kept in a
+// binary min-heap on (start_frame, arrival order) so they fire in time order
+// whatever order the transport queued them in. Storage is allocated at init.
+typedef struct {
+    uint64_t start_frame;
+    uint64_t seq;  // arrival order; keeps same-frame events FIFO
+    uint32_t slot; // index into EventStage.events
+} EventStageEntry;
+
+typedef struct {
+    QueuedEvent *events;
+    uint32_t *free_slots;
+    uint32_t free_count;
+    EventStageEntry *heap;
+    uint32_t count;
+    uint32_t capacity;
+    uint64_t next_seq;
+} EventStage;
+
 typedef struct {
     const AudioSample *sample;
     uint64_t start_frame;
     double playback_rate;
+    uint64_t position;  // 32.32 fixed-point source frame
+    uint64_t increment; // 32.32 source frames per output frame (rate and sample-rate ratio)
+    ResampleQuality resample_quality;
     bool is_pitched;
     uint64_t note_duration_frames;
     uint64_t note_off_frame;
     uint64_t attack_frames;
     uint64_t release_frames;
+    MixKernel mix_kernel;
+    MixKernel send_kernel; // source into the stereo send buses
+    uint32_t bus;
+    float send[AUDIO_SEND_COUNT];
+    float gain[2];        // current left/right gain
+    float target_gain[2]; // gain[] ramps linearly here over smooth_frames
+    uint32_t smooth_frames;
+    int priority;
+    uint64_t fade_start_frame; // stolen voices fade out from here
+    uint64_t fade_frames;      // 0 while the voice is not being stolen
+    uint32_t active_index;     // position in VoicePool.active
+    bool is_synth;
+    SynthParams synth_params; // patch and pitch the synth voice was started with
+    double synth_frequency;
+    SynthVoice synth;
+    bool filtered;            // source runs through the pool's filter bank
+    uint32_t filter_channels; // lanes used (1 or 2)
+    VoiceFilterParams filter;
+    bool block_alive;         // set while rendering a filtered block
+    uint64_t epoch;           // stamp of the event that started the voice
 } ActiveVoice;
 
+// Fixed-size voice storage allocated at init. Free slots sit on a stack so
+// allocation and release are O(1); sounding voices are tracked densely in
+// `active` for iteration. `capacity` voices may sound at once, plus a small
+// reserve that only voices fading out after being stolen may occupy.
+typedef struct {
+    ActiveVoice *voices;
+    uint32_t *free_slots;
+    uint32_t free_count;
+    uint32_t *active;
+    uint32_t active_count;
+    uint32_t fading_count;
+    uint32_t capacity;
+    uint32_t size;
+    FilterBank filters;
+    uint32_t filtered_count;
+} VoicePool;
+
+typedef struct {
+    AudioBackend backend;
+    const char *output_path; // AUDIO_BACKEND_FILE destination
+    const char *device_name; // ALSA PCM to open, or NULL for "default"
+    uint32_t period_frames;  // frames rendered per device period
+    uint32_t periods;        // periods in the device buffer
+    double latency_ms;       // when > 0, sets period_frames to fill this buffer
+    uint32_t sample_rate;
+    uint32_t channels;
+    ResampleQuality resample_quality;
+    uint32_t voice_capacity;
+    VoiceStealPolicy steal_policy;
+    double tempo_bpm;      // the delay time is in beats at this tempo
+    double delay_beats;
+    double delay_feedback;
+    double reverb_decay;   // seconds to fall by 60 dB
+    const char *reverb_impulse; // WAV impulse response for the reverb bus, or NULL
+    uint32_t render_threads;    // threads rendering voices, including the device thread
+    uint32_t event_capacity;    // ring slots, rounded up to a power of two
+    RealtimeConfig realtime;
+    float master_ceiling_db;    // master limiter ceiling in dBFS
+    uint32_t bus_outputs;       // chain buses given their own channel pair after the master pair
+} AudioEngineConfig;
+
+// Fader state of one sub-mix bus as last set from the control side.
+typedef struct {
+    float gain;
+    bool mute;
+    bool solo;
+    bool audible; // after mute and every bus's solo are applied
+} AudioBusState;
+
 typedef struct {
     ma_context context;
     ma_device device;
+    bool offline; // no device: driven by audio_engine_render
     uint32_t sample_rate;
     uint32_t channels;
+    ResampleQuality resample_quality;
 
     _Atomic uint64_t frame_cursor;
-    ScheduledEvent event_queue[1024];
-    _Atomic size_t event_head;
-    _Atomic size_t event_tail;
+    EventRing ring;
+    EventStage stage; // drained from the ring once per period
 
-    ActiveVoice voices[64];
-    size_t voice_count;
+    VoicePool pool;
+    VoiceStealPolicy steal_policy;
+    uint64_t steal_fade_frames;
+    uint32_t gain_smooth_frames;
     _Atomic bool panic;
+
+    AudioStats stats;
+    AudioEpoch epoch; // frees of sample data wait here until no voice or event can read it
+    AudioEpochHolds held; // stamps of staged events and voices, audio thread only
+    bool flush_denormals;       // real-time mode: set FTZ/DAZ on the first callback
+    bool audio_thread_prepared;
+    uint32_t device_xruns_seen; // backend underrun count already added to stats
+
+    MixKernels mix;
+    float mix_scratch[AUDIO_MIX_SCRATCH_FRAMES * AUDIO_MAX_SAMPLE_CHANNELS];
+
+    // The callback renders in blocks of at most AUDIO_BLOCK_FRAMES: voices
+    // mix into their sub-mix bus and their sends into the stereo send bus
+    // inputs, the buses are faded into target.out (the device buffer, or
+    // master_block with bus outputs), then each send adds its return.
+    RenderTarget target;
+    uint32_t mix_channels; // master width: channels, or 2 with bus outputs
+    uint32_t bus_channels; // 1 for a mono master, otherwise 2
+    uint32_t bus_outputs;  // buses 1..bus_outputs also go to device channels 2n, 2n+1
+    MixKernel bus_kernel;  // bus into the master
+    float mix_bus[AUDIO_BUS_COUNT][AUDIO_BLOCK_FRAMES * 2];
+    float master_block[AUDIO_BLOCK_FRAMES * 2];
+    float send_bus[AUDIO_SEND_COUNT][AUDIO_BLOCK_FRAMES * 2];
+    float fx_return[AUDIO_BLOCK_FRAMES * 2];
+    DelayFx delay;
+    ReverbFx reverb;
+    MasterLimiter limiter; // last stage on the master
+    // After a panic or a NaN/Inf the effect state is cleared a slice per
+    // period, with the sends bypassed until it is done. 0 when not clearing.
+    uint32_t fx_clear_stage;
+    size_t fx_clear_cursor;
+
+    // Bus faders. The control side sets these atomics at any time; the
+    // callback reads them once per block and ramps each bus from the gain it
+    // had at the end of the last block (bus_from) to the new one (bus_to).
+    _Atomic uint32_t bus_mute; // bit per bus
+    _Atomic uint32_t bus_solo;
+    _Atomic float bus_gain[AUDIO_BUS_COUNT];
+    float bus_from[AUDIO_BUS_COUNT];
+    float bus_to[AUDIO_BUS_COUNT];
+    uint32_t block_frames;
+
+    // Convolution reverb prepared by ir_thread; the reverb bus switches to
+    // it from the FDN once the pointer is published.
+    _Atomic(Convolver *) convolver;
+    char *impulse_path;
+    pthread_t ir_thread;
+    bool ir_thread_started;
+
+    // Optional render threads: each renders a share of the unfiltered voices
+    // into its own target, summed into target after every span.
+    WorkerPool workers;
+    RenderTarget *worker_targets;
+    float *worker_buffers;
+    RenderJob render_job;
 } AudioEngine;
 
-bool audio_engine_init(AudioEngine *engine, uint32_t sample_rate, uint32_t channels);
+AudioEngineConfig audio_engine_config_init(uint32_t sample_rate, uint32_t channels);
+bool audio_engine_init(AudioEngine *engine, const AudioEngineConfig *config);
 void audio_engine_shutdown(AudioEngine *engine);
+// Sets up the engine without opening a device; audio_engine_render then
+// advances it by any number of frames, as fast as the CPU allows.
+bool audio_engine_init_offline(AudioEngine *engine, const AudioEngineConfig *config);
+void audio_engine_render(AudioEngine *engine, float *out, uint32_t frames);
+
+// Copies the engine's counters (see AudioStats); safe from any thread.
+void audio_engine_stats(const AudioEngine *engine, AudioStatsSnapshot *out);
 
+ScheduledEvent audio_scheduled_event_init(const AudioSample *sample, uint64_t start_frame);
+// Queues and publishes one event; false when the ring is full.
+bool audio_engine_queue_event(AudioEngine *engine, const ScheduledEvent *event);
+// Batched queueing from the producer thread: push writes an event into the
+// ring without publishing it (false when the ring is full, in which case
+// nothing was written), commit publishes every pushed event at once.
+bool audio_engine_queue_push(AudioEngine *engine, const ScheduledEvent *event);
+void audio_engine_queue_commit(AudioEngine *engine);
 bool audio_engine_queue(AudioEngine *engine, const AudioSample *sample, uint64_t start_frame);
 bool audio_engine_queue_rate(AudioEngine *engine,
                             const AudioSample *sample,
@@ -61,9 +341,24 @@ bool audio_engine_queue_rate(AudioEngine *engine,
                             bool is_pitched,
                             uint64_t note_duration_frames);
 double audio_engine_time_seconds(const AudioEngine *engine);
+bool audio_backend_from_name(const char *name, AudioBackend *out_backend);
+bool audio_voice_steal_policy_from_name(const char *name, VoiceStealPolicy *out_policy);
 void audio_engine_panic(AudioEngine *engine);
+// Sub-mix bus faders, safe from any thread. Changes take effect at the next
+// block with a short ramp; voices on a silenced bus keep playing, so
+// unmuting lands in phase.
+void audio_engine_set_bus_mute(AudioEngine *engine, uint32_t bus, bool mute);
+void audio_engine_set_bus_solo(AudioEngine *engine, uint32_t bus, bool solo);
+void audio_engine_set_bus_gain(AudioEngine *engine, uint32_t bus, float gain);
+void audio_engine_bus_state(const AudioEngine *engine, uint32_t bus, AudioBusState *out);
 
 bool audio_sample_from_wav(const char *path, AudioSample *out_sample);
+// Loads a 16-bit WAV kept in the given storage format.
+bool audio_sample_from_wav_as(const char *path, AudioSampleFormat format, AudioSample *out_sample);
+bool audio_sample_format_from_name(const char *name, AudioSampleFormat *out_format);
+const char *audio_sample_format_name(AudioSampleFormat format);
+// Bytes of sample data.
+size_t audio_sample_bytes(const AudioSample *sample);
 bool audio_sample_generate_sine(AudioSample *out_sample, double seconds, uint32_t sample_rate, double frequency);
 void audio_sample_free(AudioSample *sample);
 
@@ -0,0 +1,237 @@
+#include "convolver.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static float twiddle_re[CONV_FFT_SIZE / 2];
+static float twiddle_im[CONV_FFT_SIZE / 2];
+static uint16_t bit_reverse[CONV_FFT_SIZE];
+static pthread_once_t fft_once = PTHREAD_ONCE_INIT;
+
+static void build_fft_tables(void) {
+    uint32_t bits = 0;
+    while ((1u << bits) < CONV_FFT_SIZE) ++bits;
+    for (uint32_t i = 0; i < CONV_FFT_SIZE; ++i) {
+        uint32_t r = 0;
+        for (uint32_t b = 0; b < bits; ++b) {
+            if (i & (1u << b)) r |= 1u << (bits - 1 - b);
+        }
+        bit_reverse[i] = (uint16_t)r;
+    }
+    for (uint32_t k = 0; k < CONV_FFT_SIZE / 2; ++k) {
+        double angle = -2.0 * M_PI * (double)k / (double)CONV_FFT_SIZE;
+        twiddle_re[k] = (float)cos(angle);
+        twiddle_im[k] = (float)sin(angle);
+    }
+}
+
+// In-place forward radix-2 FFT of size CONV_FFT_SIZE. The inverse is taken
+// by conjugating before and after.
+static void fft_forward(float *re, float *im) {
+    for (uint32_t i = 0; i < CONV_FFT_SIZE; ++i) {
+        uint32_t j = bit_reverse[i];
+        if (j > i) {
+            float t = re[i];
+            re[i] = re[j];
+            re[j] = t;
+            t = im[i];
+            im[i] = im[j];
+            im[j] = t;
+        }
+    }
+    for (uint32_t half = 1; half < CONV_FFT_SIZE; half <<= 1) {
+        uint32_t stride = CONV_FFT_SIZE / (half << 1);
+        for (uint32_t start = 0; start < CONV_FFT_SIZE; start += half << 1) {
+            for (uint32_t k = 0; k < half; ++k) {
+                float wr = twiddle_re[k * stride];
+                float wi = twiddle_im[k * stride];
+                uint32_t a = start + k;
+                uint32_t b = a + half;
+                float xr = re[b] * wr - im[b] * wi;
+                float xi = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - xr;
+                im[b] = im[a] - xi;
+                re[a] += xr;
+                im[a] += xi;
+            }
+        }
+    }
+}
+
+void convolver_free(Convolver *conv) {
+    for (int ch = 0; ch < 2; ++ch) {
+        free(conv->head[ch]);
+        free(conv->ir_re[ch]);
+        free(conv->ir_im[ch]);
+        free(conv->fdl_re[ch]);
+        free(conv->fdl_im[ch]);
+    }
+    memset(conv, 0, sizeof(*conv));
+}
+
+bool convolver_init(Convolver *conv, const float *ir, uint32_t frames, uint32_t channels) {
+    memset(conv, 0, sizeof(*conv));
+    if (!ir || frames == 0 || channels == 0) return false;
+    pthread_once(&fft_once, build_fft_tables);
+
+    conv->ir_channels = channels >= 2 ? 2 : 1;
+    conv->partitions = frames > CONV_PARTITION ? (frames - CONV_PARTITION + CONV_PARTITION - 1) / CONV_PARTITION : 0;
+    size_t spectra = (size_t)(conv->partitions > 0 ? conv->partitions : 1) * CONV_BINS;
+    for (uint32_t ch = 0; ch < 2; ++ch) {
+        if (ch < conv->ir_channels) {
+            conv->head[ch] = (float *)calloc(CONV_PARTITION, sizeof(float));
+            conv->ir_re[ch] = (float *)calloc(spectra, sizeof(float));
+            conv->ir_im[ch] = (float *)calloc(spectra, sizeof(float));
+            if (!conv->head[ch] || !conv->ir_re[ch] || !conv->ir_im[ch]) {
+                convolver_free(conv);
+                return false;
+            }
+        }
+        conv->fdl_re[ch] = (float *)calloc(spectra, sizeof(float));
+        conv->fdl_im[ch] = (float *)calloc(spectra, sizeof(float));
+        if (!conv->fdl_re[ch] || !conv->fdl_im[ch]) {
+            convolver_free(conv);
+            return false;
+        }
+    }
+
+    const float scale = 1.0f / (float)CONV_FFT_SIZE;
+    for (uint32_t ch = 0; ch < conv->ir_channels; ++ch) {
+        for (uint32_t k = 0; k < CONV_PARTITION && k < frames; ++k) {
+            conv->head[ch][CONV_PARTITION - 1 - k] = ir[(size_t)k * channels + ch];
+        }
+        for (uint32_t p = 0; p < conv->partitions; ++p) {
+            memset(conv->fft_re, 0, sizeof(conv->fft_re));
+            memset(conv->fft_im, 0, sizeof(conv->fft_im));
+            uint32_t first = (p + 1) * CONV_PARTITION;
+            for (uint32_t k = 0; k < CONV_PARTITION && first + k < frames; ++k) {
+                conv->fft_re[k] = ir[(size_t)(first + k) * channels + ch] * scale;
+            }
+            fft_forward(conv->fft_re, conv->fft_im);
+            memcpy(conv->ir_re[ch] + (size_t)p * CONV_BINS, conv->fft_re, sizeof(float) * CONV_BINS);
+            memcpy(conv->ir_im[ch] + (size_t)p * CONV_BINS, conv->fft_im, sizeof(float) * CONV_BINS);
+        }
+    }
+    return true;
+}
+
+void convolver_clear(Convolver *conv) {
+    size_t cursor = 0;
+    size_t budget = SIZE_MAX;
+    convolver_clear_step(conv, &cursor, &budget);
+}
+
+bool convolver_clear_step(Convolver *conv, size_t *cursor, size_t *budget) {
+    if (*cursor == 0) {
+        memset(conv->input, 0, sizeof(conv->input));
+        memset(conv->tail, 0, sizeof(conv->tail));
+        conv->fill = 0;
+        conv->fdl_pos = 0;
+    }
+    // The delay line as one run of floats: re then im, per channel.
+    size_t spectra = (size_t)(conv->partitions > 0 ? conv->partitions : 1) * CONV_BINS;
+    for (size_t part = *cursor / spectra; part < 4; ++part) {
+        float *line = (part & 1) ? conv->fdl_im[part >> 1] : conv->fdl_re[part >> 1];
+        size_t from = *cursor - part * spectra;
+        size_t n = spectra - from;
+        if (n > *budget) n = *budget;
+        memset(line + from, 0, sizeof(float) * n);
+        *cursor += n;
+        *budget -= n;
+        if (*cursor < (part + 1) * spectra) return false;
+    }
+    return true;
+}
+
+// Runs once per completed input partition: transforms the last two
+// partitions of input into the delay line, then multiplies the delay line
+// against the IR partitions to produce the tail for the next partition.
+static void convolver_advance(Convolver *conv) {
+    const uint32_t count = conv->partitions;
+    if (count > 0) {
+        conv->fdl_pos = conv->fdl_pos == 0 ? count - 1 : conv->fdl_pos - 1;
+    }
+    for (uint32_t ch = 0; ch < 2; ++ch) {
+        if (count > 0) {
+            memcpy(conv->fft_re, conv->input[ch], sizeof(conv->fft_re));
+            memset(conv->fft_im, 0, sizeof(conv->fft_im));
+            fft_forward(conv->fft_re, conv->fft_im);
+            memcpy(conv->fdl_re[ch] + (size_t)conv->fdl_pos * CONV_BINS, conv->fft_re, sizeof(float) * CONV_BINS);
+            memcpy(conv->fdl_im[ch] + (size_t)conv->fdl_pos * CONV_BINS, conv->fft_im, sizeof(float) * CONV_BINS);
+
+            // Spectrum of age a (0 = newest) meets IR partition a + 1.
+            const uint32_t ir_ch = conv->ir_channels > 1 ? ch : 0;
+            memset(conv->acc_re, 0, sizeof(conv->acc_re));
+            memset(conv->acc_im, 0, sizeof(conv->acc_im));
+            uint32_t slot = conv->fdl_pos;
+            for (uint32_t p = 0; p < count; ++p) {
+                const float *xr = conv->fdl_re[ch] + (size_t)slot * CONV_BINS;
+                const float *xi = conv->fdl_im[ch] + (size_t)slot * CONV_BINS;
+                const float *hr = conv->ir_re[ir_ch] + (size_t)p * CONV_BINS;
+                const float *hi = conv->ir_im[ir_ch] + (size_t)p * CONV_BINS;
+                float *restrict ar = conv->acc_re;
+                float *restrict ai = conv->acc_im;
+                for (uint32_t b = 0; b < CONV_BINS; ++b) {
+                    ar[b] += xr[b] * hr[b] - xi[b] * hi[b];
+                    ai[b] += xr[b] * hi[b] + xi[b] * hr[b];
+                }
+                if (++slot == count) slot = 0;
+            }
+
+            // Inverse FFT of the Hermitian spectrum via the conjugate.
+            for (uint32_t b = 0; b < CONV_BINS; ++b) {
+                conv->fft_re[b] = conv->acc_re[b];
+                conv->fft_im[b] = -conv->acc_im[b];
+            }
+            for (uint32_t b = CONV_BINS; b < CONV_FFT_SIZE; ++b) {
+                conv->fft_re[b] = conv->acc_re[CONV_FFT_SIZE - b];
+                conv->fft_im[b] = conv->acc_im[CONV_FFT_SIZE - b];
+            }
+            fft_forward(conv->fft_re, conv->fft_im);
+            memcpy(conv->tail[ch], conv->fft_re + CONV_PARTITION, sizeof(conv->tail[ch]));
+        }
+        memmove(conv->input[ch], conv->input[ch] + CONV_PARTITION, sizeof(float) * CONV_PARTITION);
+    }
+    conv->fill = 0;
+}
+
+void convolver_process(Convolver *conv, const float *input, float *out, uint32_t frames) {
+    uint32_t done = 0;
+    while (done < frames) {
+        uint32_t n = CONV_PARTITION - conv->fill;
+        if (n > frames - done) n = frames - done;
+        for (uint32_t ch = 0; ch < 2; ++ch) {
+            const float *head = conv->head[conv->ir_channels > 1 ? ch : 0];
+            float *x = conv->input[ch] + CONV_PARTITION;
+            for (uint32_t i = 0; i < n; ++i) {
+                x[conv->fill + i] = input[2 * (done + i) + ch];
+            }
+            for (uint32_t i = 0; i < n; ++i) {
+                uint32_t pos = conv->fill + i;
+                // x[pos - k] * h[k] over the head, with h stored reversed.
+                // Four partial sums keep the adds independent so they pipeline.
+                const float *window = x + pos + 1 - CONV_PARTITION;
+                float acc[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+                for (uint32_t k = 0; k < CONV_PARTITION; k += 4) {
+                    acc[0] += window[k] * head[k];
+                    acc[1] += window[k + 1] * head[k + 1];
+                    acc[2] += window[k + 2] * head[k + 2];
+                    acc[3] += window[k + 3] * head[k + 3];
+                }
+                out[2 * (done + i) + ch] += (acc[0] + acc[1]) + (acc[2] + acc[3]) + conv->tail[ch][pos];
+            }
+        }
+        conv->fill += n;
+        done += n;
+        if (conv->fill == CONV_PARTITION) {
+            convolver_advance(conv);
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef MUSIKA_CONVOLVER_H
+#define MUSIKA_CONVOLVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Uniformly partitioned overlap-save convolution with a zero-latency head.
+// The first CONV_PARTITION taps of the impulse response run as a direct
+// FIR; every later partition is multiplied in the frequency domain against
+// a delay line of input spectra, one FFT per partition of input. Because
+// those partitions are delayed by at least one partition, their output is
+// ready before it is needed and the convolver adds no latency.
+enum { CONV_PARTITION = 256, CONV_FFT_SIZE = 2 * CONV_PARTITION, CONV_BINS = CONV_PARTITION + 1 };
+
+typedef struct {
+    uint32_t ir_channels;     // 1 (shared by both inputs) or 2
+    uint32_t partitions;      // frequency-domain partitions after the head
+    float *head[2];           // first partition taps, reversed for the FIR
+    float *ir_re[2];          // [partition][bin] spectra, scaled by 1/N
+    float *ir_im[2];
+    float *fdl_re[2];         // [slot][bin] ring of past input spectra
+    float *fdl_im[2];
+    uint32_t fdl_pos;         // slot of the newest spectrum
+    float input[2][CONV_FFT_SIZE]; // previous partition then the current one
+    float tail[2][CONV_PARTITION]; // frequency-domain output for the current partition
+    uint32_t fill;            // frames of the current partition seen so far
+    float fft_re[CONV_FFT_SIZE];
+    float fft_im[CONV_FFT_SIZE];
+    float acc_re[CONV_BINS];
+    float acc_im[CONV_BINS];
+} Convolver;
+
+// Prepares the impulse response (frames frames of interleaved data with
+// channels channels; only the first two are used). Allocates and runs every
+// IR FFT, so call it off the audio thread.
+bool convolver_init(Convolver *conv, const float *ir, uint32_t frames, uint32_t channels);
+void convolver_free(Convolver *conv);
+void convolver_clear(Convolver *conv);
+// Clears the state a piece at a time, like delay_fx_clear_step.
+bool convolver_clear_step(Convolver *conv, size_t *cursor, size_t *budget);
+// Adds the convolution of the interleaved stereo input to out.
+void convolver_process(Convolver *conv, const float *input, float *out, uint32_t frames);
+
+#endif // MUSIKA_CONVOLVER_H
@@ -0,0 +1,137 @@
+#include "epoch.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void audio_epoch_init(AudioEpoch *epoch) {
+    atomic_store(&epoch->global, 1);
+    atomic_store(&epoch->reader, 1);
+    pthread_mutex_init(&epoch->lock, NULL);
+    epoch->retired = NULL;
+    epoch->retired_count = 0;
+    epoch->retired_capacity = 0;
+}
+
+void audio_epoch_destroy(AudioEpoch *epoch) {
+    for (size_t i = 0; i < epoch->retired_count; ++i) {
+        epoch->retired[i].free_fn(epoch->retired[i].ptr);
+    }
+    free(epoch->retired);
+    epoch->retired = NULL;
+    epoch->retired_count = 0;
+    epoch->retired_capacity = 0;
+    pthread_mutex_destroy(&epoch->lock);
+}
+
+// Lock held.
+static size_t collect_locked(AudioEpoch *epoch) {
+    uint64_t reader = atomic_load_explicit(&epoch->reader, memory_order_acquire);
+    size_t kept = 0;
+    size_t freed = 0;
+    for (size_t i = 0; i < epoch->retired_count; ++i) {
+        AudioRetired item = epoch->retired[i];
+        if (item.epoch < reader) {
+            item.free_fn(item.ptr);
+            freed++;
+        } else {
+            epoch->retired[kept++] = item;
+        }
+    }
+    epoch->retired_count = kept;
+    return freed;
+}
+
+void audio_epoch_retire(AudioEpoch *epoch, AudioEpochFreeFn free_fn, void *ptr) {
+    if (!ptr) return;
+    pthread_mutex_lock(&epoch->lock);
+    if (epoch->retired_count == epoch->retired_capacity) {
+        size_t capacity = epoch->retired_capacity ? epoch->retired_capacity * 2 : 64;
+        AudioRetired *grown = (AudioRetired *)realloc(epoch->retired, sizeof(AudioRetired) * capacity);
+        if (!grown) {
+            // Freeing now could pull memory from under the callback.
+            fprintf(stderr, "Warning: out of memory retiring audio data; leaking it\n");
+            pthread_mutex_unlock(&epoch->lock);
+            return;
+        }
+        epoch->retired = grown;
+        epoch->retired_capacity = capacity;
+    }
+    // Everything queued before this point carries a stamp at most the
+    // epoch recorded here; the increment tells the callback to catch up.
+    uint64_t retired_in = atomic_fetch_add(&epoch->global, 1);
+    epoch->retired[epoch->retired_count++] = (AudioRetired){free_fn, ptr, retired_in};
+    collect_locked(epoch);
+    pthread_mutex_unlock(&epoch->lock);
+}
+
+size_t audio_epoch_collect(AudioEpoch *epoch) {
+    pthread_mutex_lock(&epoch->lock);
+    size_t freed = epoch->retired_count > 0 ? collect_locked(epoch) : 0;
+    pthread_mutex_unlock(&epoch->lock);
+    return freed;
+}
+
+void audio_epoch_holds_reset(AudioEpochHolds *holds) {
+    holds->first = 0;
+    holds->used = 0;
+    holds->merged = 0;
+}
+
+// Entry a stamp is counted under: the newest one not newer than it.
+static uint32_t hold_index(const AudioEpochHolds *holds, uint64_t stamp, bool *found) {
+    for (uint32_t n = holds->used; n > 0; --n) {
+        uint32_t i = (holds->first + n - 1) % AUDIO_EPOCH_HOLD_SLOTS;
+        if (holds->epoch[i] <= stamp) {
+            *found = true;
+            return i;
+        }
+    }
+    *found = false;
+    return 0;
+}
+
+// Drops emptied entries, keeping the order.
+static void compact_holds(AudioEpochHolds *holds) {
+    uint32_t kept = 0;
+    for (uint32_t n = 0; n < holds->used; ++n) {
+        uint32_t from = (holds->first + n) % AUDIO_EPOCH_HOLD_SLOTS;
+        if (holds->count[from] == 0) continue;
+        uint32_t to = (holds->first + kept) % AUDIO_EPOCH_HOLD_SLOTS;
+        holds->epoch[to] = holds->epoch[from];
+        holds->count[to] = holds->count[from];
+        kept++;
+    }
+    holds->used = kept;
+}
+
+void audio_epoch_hold(AudioEpochHolds *holds, uint64_t stamp) {
+    bool found = false;
+    uint32_t i = hold_index(holds, stamp, &found);
+    bool newest = found && i == (holds->first + holds->used - 1) % AUDIO_EPOCH_HOLD_SLOTS;
+    if (found && (holds->epoch[i] == stamp || !newest || stamp <= holds->merged)) {
+        holds->count[i]++;
+        return;
+    }
+    if (holds->used == AUDIO_EPOCH_HOLD_SLOTS) compact_holds(holds);
+    if (holds->used == AUDIO_EPOCH_HOLD_SLOTS) {
+        i = (holds->first + holds->used - 1) % AUDIO_EPOCH_HOLD_SLOTS;
+        holds->count[i]++;
+        holds->merged = stamp;
+        return;
+    }
+    i = (holds->first + holds->used++) % AUDIO_EPOCH_HOLD_SLOTS;
+    holds->epoch[i] = stamp;
+    holds->count[i] = 1;
+}
+
+void audio_epoch_release(AudioEpochHolds *holds, uint64_t stamp) {
+    bool found = false;
+    uint32_t i = hold_index(holds, stamp, &found);
+    if (!found || holds->count[i] == 0) return;
+    holds->count[i]--;
+    while (holds->used > 0 && holds->count[holds->first] == 0) {
+        holds->first = (holds->first + 1) % AUDIO_EPOCH_HOLD_SLOTS;
+        holds->used--;
+    }
+}
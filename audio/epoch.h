@@ -0,0 +1,97 @@
+#ifndef MUSIKA_EPOCH_H
+#define MUSIKA_EPOCH_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Deferred reclamation of memory the audio thread may still read (samples
+// referenced by queued events and sounding voices).
+//
+// Control threads retire an object instead of freeing it: the retire bumps
+// the global epoch and records the epoch the object was retired in. Every
+// event is stamped with the global epoch when its batch is committed to the
+// ring, and a voice keeps its event's stamp. Once per period the callback publishes the
+// oldest stamp it still holds (or the epoch it started the period in, if
+// that is older), with a single store. A retired object is freed once that
+// published epoch has moved past its retire epoch: by then the audio thread
+// has seen every event committed before the retire, and none it holds is older.
+//
+// So an object may be retired only once every event that points at it has
+// been committed, and the commit must happen before the retire (same thread,
+// or ordered through a lock). Events pushed but not yet committed do not
+// protect anything.
+//
+// The callback never takes the lock and never frees anything.
+typedef void (*AudioEpochFreeFn)(void *ptr);
+
+typedef struct {
+    AudioEpochFreeFn free_fn;
+    void *ptr;
+    uint64_t epoch; // global epoch when retired
+} AudioRetired;
+
+typedef struct {
+    _Atomic uint64_t global;
+    _Alignas(64) _Atomic uint64_t reader; // written by the audio thread only
+    _Alignas(64) pthread_mutex_t lock;    // guards the retired list
+    AudioRetired *retired;
+    size_t retired_count;
+    size_t retired_capacity;
+} AudioEpoch;
+
+// The stamps the audio thread holds (staged events and sounding voices),
+// counted per epoch in ascending order so the oldest is known without
+// walking them. Stamps arrive in commit order, so a new one is never older
+// than the newest entry. When every entry is in use, new stamps are counted
+// under the newest entry: that only delays frees.
+enum { AUDIO_EPOCH_HOLD_SLOTS = 64 };
+
+typedef struct {
+    uint64_t epoch[AUDIO_EPOCH_HOLD_SLOTS];
+    uint32_t count[AUDIO_EPOCH_HOLD_SLOTS];
+    uint32_t first; // ring index of the oldest entry
+    uint32_t used;
+    uint64_t merged; // newest stamp counted under an older entry
+} AudioEpochHolds;
+
+void audio_epoch_init(AudioEpoch *epoch);
+// Frees everything still retired. Only once the audio thread has stopped.
+void audio_epoch_destroy(AudioEpoch *epoch);
+// Hands ptr over for free_fn to release once the audio thread is done with
+// it. Safe from any thread but the audio thread.
+void audio_epoch_retire(AudioEpoch *epoch, AudioEpochFreeFn free_fn, void *ptr);
+// Frees every retired object the audio thread has moved past; returns how
+// many. Called by control threads whenever convenient.
+size_t audio_epoch_collect(AudioEpoch *epoch);
+
+// Stamp for a batch of events the producer is about to commit.
+static inline uint64_t audio_epoch_stamp(const AudioEpoch *epoch) {
+    return atomic_load_explicit(&epoch->global, memory_order_relaxed);
+}
+
+// Audio thread, at the start of a period, before it takes events off the
+// ring: events queued before any retire it observes are visible after this.
+static inline uint64_t audio_epoch_enter(const AudioEpoch *epoch) {
+    return atomic_load_explicit(&epoch->global, memory_order_acquire);
+}
+
+// Audio thread only. hold/release must see the same stamps in pairs.
+void audio_epoch_holds_reset(AudioEpochHolds *holds);
+void audio_epoch_hold(AudioEpochHolds *holds, uint64_t stamp);
+void audio_epoch_release(AudioEpochHolds *holds, uint64_t stamp);
+// The oldest stamp held, or entered if that is older or nothing is held.
+static inline uint64_t audio_epoch_oldest(const AudioEpochHolds *holds, uint64_t entered) {
+    if (holds->used == 0) return entered;
+    uint64_t oldest = holds->epoch[holds->first];
+    return oldest < entered ? oldest : entered;
+}
+
+// Audio thread, at the end of a period: oldest is the smaller of the epoch
+// from audio_epoch_enter and every stamp still held.
+static inline void audio_epoch_publish(AudioEpoch *epoch, uint64_t oldest) {
+    atomic_store_explicit(&epoch->reader, oldest, memory_order_release);
+}
+
+#endif // MUSIKA_EPOCH_H
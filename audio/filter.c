@@ -0,0 +1,292 @@
+#include "filter.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FILTER_HAVE_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define FILTER_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+enum { COEFF_A1 = 0, COEFF_A2, COEFF_A3, COEFF_M0, COEFF_M1, COEFF_M2, COEFF_COUNT };
+enum { STATE_IC1 = 0, STATE_IC2, STATE_COUNT };
+
+static void svf_bypass(SvfCoeffs *c) {
+    c->a1 = 0.0f;
+    c->a2 = 0.0f;
+    c->a3 = 0.0f;
+    c->m0 = 1.0f;
+    c->m1 = 0.0f;
+    c->m2 = 0.0f;
+}
+
+static void svf_design(SvfCoeffs *c, float cutoff, float q, uint32_t sample_rate, bool highpass) {
+    double nyquist_guard = 0.45 * (double)sample_rate;
+    double fc = cutoff < 10.0f ? 10.0 : (double)cutoff;
+    if (fc > nyquist_guard) fc = nyquist_guard;
+    double k = 1.0 / (q > 0.1f ? (double)q : 0.1);
+    double g = tan(M_PI * fc / (double)sample_rate);
+    double a1 = 1.0 / (1.0 + g * (g + k));
+    c->a1 = (float)a1;
+    c->a2 = (float)(g * a1);
+    c->a3 = (float)(g * g * a1);
+    if (highpass) {
+        c->m0 = 1.0f;
+        c->m1 = (float)-k;
+        c->m2 = -1.0f;
+    } else {
+        c->m0 = 0.0f;
+        c->m1 = 0.0f;
+        c->m2 = 1.0f;
+    }
+}
+
+void filter_coeffs_from_params(const VoiceFilterParams *params, uint32_t sample_rate, SvfCoeffs stages[FILTER_STAGES]) {
+    float q = params->resonance > 0.0f ? params->resonance : 0.707f;
+    if (params->hpf > 0.0f) {
+        svf_design(&stages[0], params->hpf, q, sample_rate, true);
+    } else {
+        svf_bypass(&stages[0]);
+    }
+    if (params->lpf > 0.0f) {
+        svf_design(&stages[1], params->lpf, q, sample_rate, false);
+    } else {
+        svf_bypass(&stages[1]);
+    }
+}
+
+static inline float *coeff_row(FilterBank *bank, int stage, int which) {
+    return bank->coeffs + ((size_t)stage * COEFF_COUNT + (size_t)which) * bank->lanes;
+}
+
+static inline float *state_row(FilterBank *bank, int stage, int which) {
+    return bank->state + ((size_t)stage * STATE_COUNT + (size_t)which) * bank->lanes;
+}
+
+// --- Portable scalar path ---
+
+static void filter_process_scalar(FilterBank *bank, uint32_t frames) {
+    const uint32_t lanes = bank->lanes;
+    for (uint32_t group = 0; group < lanes / 4; ++group) {
+        if (bank->group_active[group] == 0) continue;
+        for (uint32_t lane = group * 4; lane < group * 4 + 4; ++lane) {
+            for (int s = 0; s < FILTER_STAGES; ++s) {
+                const float a1 = coeff_row(bank, s, COEFF_A1)[lane];
+                const float a2 = coeff_row(bank, s, COEFF_A2)[lane];
+                const float a3 = coeff_row(bank, s, COEFF_A3)[lane];
+                const float m0 = coeff_row(bank, s, COEFF_M0)[lane];
+                const float m1 = coeff_row(bank, s, COEFF_M1)[lane];
+                const float m2 = coeff_row(bank, s, COEFF_M2)[lane];
+                float ic1 = state_row(bank, s, STATE_IC1)[lane];
+                float ic2 = state_row(bank, s, STATE_IC2)[lane];
+                for (uint32_t f = 0; f < frames; ++f) {
+                    float *x = bank->buffer + (size_t)f * lanes + lane;
+                    float v3 = *x - ic2;
+                    float v1 = a1 * ic1 + a2 * v3;
+                    float v2 = ic2 + a2 * ic1 + a3 * v3;
+                    ic1 = 2.0f * v1 - ic1;
+                    ic2 = 2.0f * v2 - ic2;
+                    *x = m0 * *x + m1 * v1 + m2 * v2;
+                }
+                state_row(bank, s, STATE_IC1)[lane] = ic1;
+                state_row(bank, s, STATE_IC2)[lane] = ic2;
+            }
+        }
+    }
+}
+
+// --- x86 SSE2 (4 lanes) / AVX (8 lanes) ---
+
+#if defined(FILTER_HAVE_X86)
+
+#define FILTER_TARGET(isa) __attribute__((target(isa)))
+
+FILTER_TARGET("sse2")
+static void filter_process_sse2(FilterBank *bank, uint32_t frames) {
+    const uint32_t lanes = bank->lanes;
+    const __m128 two = _mm_set1_ps(2.0f);
+    for (uint32_t group = 0; group < lanes / 4; ++group) {
+        if (bank->group_active[group] == 0) continue;
+        const uint32_t base = group * 4;
+        for (int s = 0; s < FILTER_STAGES; ++s) {
+            const __m128 a1 = _mm_loadu_ps(coeff_row(bank, s, COEFF_A1) + base);
+            const __m128 a2 = _mm_loadu_ps(coeff_row(bank, s, COEFF_A2) + base);
+            const __m128 a3 = _mm_loadu_ps(coeff_row(bank, s, COEFF_A3) + base);
+            const __m128 m0 = _mm_loadu_ps(coeff_row(bank, s, COEFF_M0) + base);
+            const __m128 m1 = _mm_loadu_ps(coeff_row(bank, s, COEFF_M1) + base);
+            const __m128 m2 = _mm_loadu_ps(coeff_row(bank, s, COEFF_M2) + base);
+            __m128 ic1 = _mm_loadu_ps(state_row(bank, s, STATE_IC1) + base);
+            __m128 ic2 = _mm_loadu_ps(state_row(bank, s, STATE_IC2) + base);
+            for (uint32_t f = 0; f < frames; ++f) {
+                float *px = bank->buffer + (size_t)f * lanes + base;
+                __m128 x = _mm_loadu_ps(px);
+                __m128 v3 = _mm_sub_ps(x, ic2);
+                __m128 v1 = _mm_add_ps(_mm_mul_ps(a1, ic1), _mm_mul_ps(a2, v3));
+                __m128 v2 = _mm_add_ps(ic2, _mm_add_ps(_mm_mul_ps(a2, ic1), _mm_mul_ps(a3, v3)));
+                ic1 = _mm_sub_ps(_mm_mul_ps(two, v1), ic1);
+                ic2 = _mm_sub_ps(_mm_mul_ps(two, v2), ic2);
+                __m128 y = _mm_add_ps(_mm_mul_ps(m0, x), _mm_add_ps(_mm_mul_ps(m1, v1), _mm_mul_ps(m2, v2)));
+                _mm_storeu_ps(px, y);
+            }
+            _mm_storeu_ps(state_row(bank, s, STATE_IC1) + base, ic1);
+            _mm_storeu_ps(state_row(bank, s, STATE_IC2) + base, ic2);
+        }
+    }
+}
+
+FILTER_TARGET("avx")
+static void filter_process_avx(FilterBank *bank, uint32_t frames) {
+    const uint32_t lanes = bank->lanes;
+    const __m256 two = _mm256_set1_ps(2.0f);
+    for (uint32_t group = 0; group < lanes / 8; ++group) {
+        if (bank->group_active[2 * group] == 0 && bank->group_active[2 * group + 1] == 0) continue;
+        const uint32_t base = group * 8;
+        for (int s = 0; s < FILTER_STAGES; ++s) {
+            const __m256 a1 = _mm256_loadu_ps(coeff_row(bank, s, COEFF_A1) + base);
+            const __m256 a2 = _mm256_loadu_ps(coeff_row(bank, s, COEFF_A2) + base);
+            const __m256 a3 = _mm256_loadu_ps(coeff_row(bank, s, COEFF_A3) + base);
+            const __m256 m0 = _mm256_loadu_ps(coeff_row(bank, s, COEFF_M0) + base);
+            const __m256 m1 = _mm256_loadu_ps(coeff_row(bank, s, COEFF_M1) + base);
+            const __m256 m2 = _mm256_loadu_ps(coeff_row(bank, s, COEFF_M2) + base);
+            __m256 ic1 = _mm256_loadu_ps(state_row(bank, s, STATE_IC1) + base);
+            __m256 ic2 = _mm256_loadu_ps(state_row(bank, s, STATE_IC2) + base);
+            for (uint32_t f = 0; f < frames; ++f) {
+                float *px = bank->buffer + (size_t)f * lanes + base;
+                __m256 x = _mm256_loadu_ps(px);
+                __m256 v3 = _mm256_sub_ps(x, ic2);
+                __m256 v1 = _mm256_add_ps(_mm256_mul_ps(a1, ic1), _mm256_mul_ps(a2, v3));
+                __m256 v2 = _mm256_add_ps(ic2, _mm256_add_ps(_mm256_mul_ps(a2, ic1), _mm256_mul_ps(a3, v3)));
+                ic1 = _mm256_sub_ps(_mm256_mul_ps(two, v1), ic1);
+                ic2 = _mm256_sub_ps(_mm256_mul_ps(two, v2), ic2);
+                __m256 y = _mm256_add_ps(_mm256_mul_ps(m0, x), _mm256_add_ps(_mm256_mul_ps(m1, v1), _mm256_mul_ps(m2, v2)));
+                _mm256_storeu_ps(px, y);
+            }
+            _mm256_storeu_ps(state_row(bank, s, STATE_IC1) + base, ic1);
+            _mm256_storeu_ps(state_row(bank, s, STATE_IC2) + base, ic2);
+        }
+    }
+}
+
+#endif // FILTER_HAVE_X86
+
+// --- ARM NEON (4 lanes) ---
+
+#if defined(FILTER_HAVE_NEON)
+
+static void filter_process_neon(FilterBank *bank, uint32_t frames) {
+    const uint32_t lanes = bank->lanes;
+    const float32x4_t two = vdupq_n_f32(2.0f);
+    for (uint32_t group = 0; group < lanes / 4; ++group) {
+        if (bank->group_active[group] == 0) continue;
+        const uint32_t base = group * 4;
+        for (int s = 0; s < FILTER_STAGES; ++s) {
+            const float32x4_t a1 = vld1q_f32(coeff_row(bank, s, COEFF_A1) + base);
+            const float32x4_t a2 = vld1q_f32(coeff_row(bank, s, COEFF_A2) + base);
+            const float32x4_t a3 = vld1q_f32(coeff_row(bank, s, COEFF_A3) + base);
+            const float32x4_t m0 = vld1q_f32(coeff_row(bank, s, COEFF_M0) + base);
+            const float32x4_t m1 = vld1q_f32(coeff_row(bank, s, COEFF_M1) + base);
+            const float32x4_t m2 = vld1q_f32(coeff_row(bank, s, COEFF_M2) + base);
+            float32x4_t ic1 = vld1q_f32(state_row(bank, s, STATE_IC1) + base);
+            float32x4_t ic2 = vld1q_f32(state_row(bank, s, STATE_IC2) + base);
+            for (uint32_t f = 0; f < frames; ++f) {
+                float *px = bank->buffer + (size_t)f * lanes + base;
+                float32x4_t x = vld1q_f32(px);
+                float32x4_t v3 = vsubq_f32(x, ic2);
+                float32x4_t v1 = vaddq_f32(vmulq_f32(a1, ic1), vmulq_f32(a2, v3));
+                float32x4_t v2 = vaddq_f32(ic2, vaddq_f32(vmulq_f32(a2, ic1), vmulq_f32(a3, v3)));
+                ic1 = vsubq_f32(vmulq_f32(two, v1), ic1);
+                ic2 = vsubq_f32(vmulq_f32(two, v2), ic2);
+                float32x4_t y = vaddq_f32(vmulq_f32(m0, x), vaddq_f32(vmulq_f32(m1, v1), vmulq_f32(m2, v2)));
+                vst1q_f32(px, y);
+            }
+            vst1q_f32(state_row(bank, s, STATE_IC1) + base, ic1);
+            vst1q_f32(state_row(bank, s, STATE_IC2) + base, ic2);
+        }
+    }
+}
+
+#endif // FILTER_HAVE_NEON
+
+static void filter_bank_select(FilterBank *bank) {
+    bank->process = filter_process_scalar;
+    bank->isa = "scalar";
+#if defined(FILTER_HAVE_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        bank->process = filter_process_sse2;
+        bank->isa = "sse2";
+    }
+    if (__builtin_cpu_supports("avx")) {
+        bank->process = filter_process_avx;
+        bank->isa = "avx";
+    }
+#elif defined(FILTER_HAVE_NEON)
+    bank->process = filter_process_neon;
+    bank->isa = "neon";
+#endif
+}
+
+bool filter_bank_init(FilterBank *bank, uint32_t slots) {
+    memset(bank, 0, sizeof(*bank));
+    bank->stride = (slots + 7u) & ~7u;
+    bank->lanes = bank->stride * FILTER_LANES_PER_SLOT;
+    bank->coeffs = (float *)calloc((size_t)FILTER_STAGES * COEFF_COUNT * bank->lanes, sizeof(float));
+    bank->state = (float *)calloc((size_t)FILTER_STAGES * STATE_COUNT * bank->lanes, sizeof(float));
+    bank->buffer = (float *)calloc((size_t)FILTER_BLOCK_FRAMES * bank->lanes, sizeof(float));
+    bank->group_active = (uint16_t *)calloc(bank->lanes / 4, sizeof(uint16_t));
+    if (!bank->coeffs || !bank->state || !bank->buffer || !bank->group_active) {
+        filter_bank_free(bank);
+        return false;
+    }
+    // Idle lanes pass their (unused) input straight through.
+    SvfCoeffs bypass[FILTER_STAGES];
+    svf_bypass(&bypass[0]);
+    svf_bypass(&bypass[1]);
+    for (uint32_t lane = 0; lane < bank->lanes; ++lane) {
+        filter_bank_attach(bank, lane, bypass);
+        filter_bank_detach(bank, lane);
+    }
+    filter_bank_select(bank);
+    return true;
+}
+
+void filter_bank_free(FilterBank *bank) {
+    free(bank->coeffs);
+    free(bank->state);
+    free(bank->buffer);
+    free(bank->group_active);
+    memset(bank, 0, sizeof(*bank));
+}
+
+void filter_bank_reset(FilterBank *bank) {
+    memset(bank->group_active, 0, sizeof(uint16_t) * (bank->lanes / 4));
+}
+
+void filter_bank_attach(FilterBank *bank, uint32_t lane, const SvfCoeffs stages[FILTER_STAGES]) {
+    for (int s = 0; s < FILTER_STAGES; ++s) {
+        coeff_row(bank, s, COEFF_A1)[lane] = stages[s].a1;
+        coeff_row(bank, s, COEFF_A2)[lane] = stages[s].a2;
+        coeff_row(bank, s, COEFF_A3)[lane] = stages[s].a3;
+        coeff_row(bank, s, COEFF_M0)[lane] = stages[s].m0;
+        coeff_row(bank, s, COEFF_M1)[lane] = stages[s].m1;
+        coeff_row(bank, s, COEFF_M2)[lane] = stages[s].m2;
+        state_row(bank, s, STATE_IC1)[lane] = 0.0f;
+        state_row(bank, s, STATE_IC2)[lane] = 0.0f;
+    }
+    bank->group_active[lane / 4]++;
+}
+
+void filter_bank_detach(FilterBank *bank, uint32_t lane) {
+    if (bank->group_active[lane / 4] > 0) {
+        bank->group_active[lane / 4]--;
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef MUSIKA_FILTER_H
+#define MUSIKA_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+enum { FILTER_BLOCK_FRAMES = 64 };
+enum { FILTER_STAGES = 2 }; // high-pass then low-pass
+enum { FILTER_LANES_PER_SLOT = 2 };
+
+// Per-event filter settings. A cutoff of 0 disables that stage.
+typedef struct {
+    float lpf;
+    float hpf;
+    float resonance; // Q shared by both stages
+} VoiceFilterParams;
+
+static inline bool voice_filter_enabled(const VoiceFilterParams *params) {
+    return params->lpf > 0.0f || params->hpf > 0.0f;
+}
+
+// One state-variable filter stage (Simper/Cytomic trapezoidal form). The
+// output mixes input, band and low: y = m0 * x + m1 * band + m2 * low.
+typedef struct {
+    float a1;
+    float a2;
+    float a3;
+    float m0;
+    float m1;
+    float m2;
+} SvfCoeffs;
+
+// Fills stages[] for params (bypassed stages pass the input through).
+// Called when an event is queued, never per frame.
+void filter_coeffs_from_params(const VoiceFilterParams *params, uint32_t sample_rate, SvfCoeffs stages[FILTER_STAGES]);
+
+typedef struct FilterBank FilterBank;
+typedef void (*FilterBankProcess)(FilterBank *bank, uint32_t frames);
+
+// Structure-of-arrays filter state for every voice slot. Lanes are laid out
+// channel-major (lane = channel * stride + slot) so neighbouring lanes are
+// neighbouring voices and one SIMD register filters 4 (SSE2/NEON) or 8
+// (AVX) voices at once. Voices write their source block into `buffer`
+// (frame-major, `lanes` floats per frame), process() filters it in place.
+struct FilterBank {
+    float *coeffs;           // [FILTER_STAGES][6][lanes]
+    float *state;            // [FILTER_STAGES][2][lanes]
+    float *buffer;           // [FILTER_BLOCK_FRAMES][lanes]
+    uint16_t *group_active;  // active lanes per group of 4
+    uint32_t stride;         // slots rounded up to a multiple of 8
+    uint32_t lanes;
+    FilterBankProcess process;
+    const char *isa;
+};
+
+bool filter_bank_init(FilterBank *bank, uint32_t slots);
+void filter_bank_free(FilterBank *bank);
+void filter_bank_reset(FilterBank *bank);
+// Loads coefficients into a lane and clears its state.
+void filter_bank_attach(FilterBank *bank, uint32_t lane, const SvfCoeffs stages[FILTER_STAGES]);
+void filter_bank_detach(FilterBank *bank, uint32_t lane);
+
+static inline uint32_t filter_bank_lane(const FilterBank *bank, uint32_t slot, uint32_t channel) {
+    return channel * bank->stride + slot;
+}
+
+#endif // MUSIKA_FILTER_H
@@ -0,0 +1,181 @@
+#include "fx.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Mutually prime line lengths (milliseconds) so echoes do not pile up on
+// the same frames.
+static const double REVERB_LINE_MS[REVERB_LINES] = {29.7, 37.1, 41.1, 43.7, 53.3, 59.9, 67.3, 73.1};
+
+bool delay_fx_init(DelayFx *fx, uint32_t sample_rate, double max_seconds) {
+    memset(fx, 0, sizeof(*fx));
+    fx->length = (uint32_t)(max_seconds * (double)sample_rate) + 1;
+    for (int ch = 0; ch < 2; ++ch) {
+        fx->buffer[ch] = (float *)calloc(fx->length, sizeof(float));
+        if (!fx->buffer[ch]) {
+            delay_fx_free(fx);
+            return false;
+        }
+    }
+    fx->delay = fx->length - 1;
+    fx->damping = 0.3f;
+    return true;
+}
+
+void delay_fx_free(DelayFx *fx) {
+    free(fx->buffer[0]);
+    free(fx->buffer[1]);
+    memset(fx, 0, sizeof(*fx));
+}
+
+void delay_fx_set(DelayFx *fx, double seconds, uint32_t sample_rate, float feedback) {
+    double frames = seconds * (double)sample_rate;
+    if (frames < 1.0) frames = 1.0;
+    if (frames > (double)(fx->length - 1)) frames = (double)(fx->length - 1);
+    fx->delay = (uint32_t)frames;
+    if (feedback < 0.0f) feedback = 0.0f;
+    if (feedback > 0.95f) feedback = 0.95f;
+    fx->feedback = feedback;
+}
+
+// Clears the part of the state held in buf, which starts base floats into
+// it, from *cursor on within *budget. Returns true once buf is clear.
+static bool clear_part(float *buf, size_t len, size_t base, size_t *cursor, size_t *budget) {
+    if (*cursor >= base + len) return true;
+    size_t from = *cursor - base;
+    size_t n = len - from;
+    if (n > *budget) n = *budget;
+    memset(buf + from, 0, sizeof(float) * n);
+    *cursor += n;
+    *budget -= n;
+    return *cursor == base + len;
+}
+
+void delay_fx_clear(DelayFx *fx) {
+    size_t cursor = 0;
+    size_t budget = SIZE_MAX;
+    delay_fx_clear_step(fx, &cursor, &budget);
+}
+
+bool delay_fx_clear_step(DelayFx *fx, size_t *cursor, size_t *budget) {
+    if (*cursor == 0) {
+        fx->lowpass[0] = 0.0f;
+        fx->lowpass[1] = 0.0f;
+    }
+    for (int ch = 0; ch < 2; ++ch) {
+        if (!clear_part(fx->buffer[ch], fx->length, (size_t)ch * fx->length, cursor, budget)) return false;
+    }
+    return true;
+}
+
+void delay_fx_process(DelayFx *fx, const float *input, float *out, uint32_t frames) {
+    const uint32_t length = fx->length;
+    const float keep = fx->damping;
+    const float take = 1.0f - fx->damping;
+    uint32_t write = fx->write_pos;
+    uint32_t read = (write + length - fx->delay) % length;
+    for (uint32_t i = 0; i < frames; ++i) {
+        for (int ch = 0; ch < 2; ++ch) {
+            float delayed = fx->buffer[ch][read];
+            fx->lowpass[ch] = take * delayed + keep * fx->lowpass[ch];
+            fx->buffer[ch][write] = input[2 * i + ch] + fx->lowpass[ch] * fx->feedback;
+            out[2 * i + ch] += delayed;
+        }
+        if (++write == length) write = 0;
+        if (++read == length) read = 0;
+    }
+    fx->write_pos = write;
+}
+
+bool reverb_fx_init(ReverbFx *fx, uint32_t sample_rate, double decay_seconds) {
+    memset(fx, 0, sizeof(*fx));
+    if (decay_seconds < 0.1) decay_seconds = 0.1;
+    for (int i = 0; i < REVERB_LINES; ++i) {
+        fx->length[i] = (uint32_t)(REVERB_LINE_MS[i] * 0.001 * (double)sample_rate) + 1;
+        fx->lines[i] = (float *)calloc(fx->length[i], sizeof(float));
+        if (!fx->lines[i]) {
+            reverb_fx_free(fx);
+            return false;
+        }
+        // -60 dB after decay_seconds: each pass through a line of n frames
+        // loses 60 * n / (decay * rate) dB.
+        double seconds = (double)fx->length[i] / (double)sample_rate;
+        fx->gain[i] = (float)pow(10.0, -3.0 * seconds / decay_seconds);
+    }
+    fx->damping = 0.35f;
+    return true;
+}
+
+void reverb_fx_free(ReverbFx *fx) {
+    for (int i = 0; i < REVERB_LINES; ++i) {
+        free(fx->lines[i]);
+    }
+    memset(fx, 0, sizeof(*fx));
+}
+
+void reverb_fx_clear(ReverbFx *fx) {
+    size_t cursor = 0;
+    size_t budget = SIZE_MAX;
+    reverb_fx_clear_step(fx, &cursor, &budget);
+}
+
+bool reverb_fx_clear_step(ReverbFx *fx, size_t *cursor, size_t *budget) {
+    if (*cursor == 0) {
+        for (int i = 0; i < REVERB_LINES; ++i) fx->lowpass[i] = 0.0f;
+    }
+    size_t base = 0;
+    for (int i = 0; i < REVERB_LINES; ++i) {
+        if (!clear_part(fx->lines[i], fx->length[i], base, cursor, budget)) return false;
+        base += fx->length[i];
+    }
+    return true;
+}
+
+// In-place 8-point fast Walsh-Hadamard transform, scaled to stay lossless.
+static inline void hadamard8(float *x) {
+    for (int span = 1; span < REVERB_LINES; span <<= 1) {
+        for (int i = 0; i < REVERB_LINES; i += span << 1) {
+            for (int j = i; j < i + span; ++j) {
+                float a = x[j];
+                float b = x[j + span];
+                x[j] = a + b;
+                x[j + span] = a - b;
+            }
+        }
+    }
+    const float scale = 0.35355339f; // 1 / sqrt(8)
+    for (int i = 0; i < REVERB_LINES; ++i) {
+        x[i] *= scale;
+    }
+}
+
+void reverb_fx_process(ReverbFx *fx, const float *input, float *out, uint32_t frames) {
+    const float keep = fx->damping;
+    const float take = 1.0f - fx->damping;
+    const float out_scale = 0.5f;
+    for (uint32_t n = 0; n < frames; ++n) {
+        float taps[REVERB_LINES];
+        for (int i = 0; i < REVERB_LINES; ++i) {
+            float delayed = fx->lines[i][fx->pos[i]];
+            fx->lowpass[i] = take * delayed + keep * fx->lowpass[i];
+            taps[i] = fx->lowpass[i] * fx->gain[i];
+        }
+        float left = 0.0f;
+        float right = 0.0f;
+        for (int i = 0; i < REVERB_LINES; i += 2) {
+            left += taps[i];
+            right += taps[i + 1];
+        }
+        out[2 * n] += left * out_scale;
+        out[2 * n + 1] += right * out_scale;
+
+        hadamard8(taps);
+        for (int i = 0; i < REVERB_LINES; ++i) {
+            float in = input[2 * n + (i & 1)];
+            fx->lines[i][fx->pos[i]] = taps[i] + in;
+            if (++fx->pos[i] == fx->length[i]) fx->pos[i] = 0;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef MUSIKA_FX_H
+#define MUSIKA_FX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum { REVERB_LINES = 8 };
+
+// Stereo feedback delay with a one-pole low-pass in the feedback path so
+// repeats darken as they decay. Buffers are allocated once at init.
+typedef struct {
+    float *buffer[2];
+    uint32_t length;    // allocated frames per channel
+    uint32_t delay;     // current delay in frames (< length)
+    uint32_t write_pos;
+    float feedback;
+    float damping;      // 0 = bright, 1 = dark
+    float lowpass[2];
+} DelayFx;
+
+// Eight-line feedback delay network reverb: a Hadamard matrix mixes the
+// lines, each line has a decay gain derived from the RT60 time and a
+// one-pole damping filter. Left input feeds the even lines, right input the
+// odd ones, and the outputs are tapped the same way.
+typedef struct {
+    float *lines[REVERB_LINES];
+    uint32_t length[REVERB_LINES];
+    uint32_t pos[REVERB_LINES];
+    float gain[REVERB_LINES];
+    float lowpass[REVERB_LINES];
+    float damping;
+} ReverbFx;
+
+bool delay_fx_init(DelayFx *fx, uint32_t sample_rate, double max_seconds);
+void delay_fx_free(DelayFx *fx);
+void delay_fx_set(DelayFx *fx, double seconds, uint32_t sample_rate, float feedback);
+void delay_fx_clear(DelayFx *fx);
+// Clears the state a piece at a time: at most *budget floats from *cursor
+// on (0 to start), taken off *budget. Returns true once all of it is clear.
+bool delay_fx_clear_step(DelayFx *fx, size_t *cursor, size_t *budget);
+// Adds the delayed signal of the interleaved stereo input to out.
+void delay_fx_process(DelayFx *fx, const float *input, float *out, uint32_t frames);
+
+bool reverb_fx_init(ReverbFx *fx, uint32_t sample_rate, double decay_seconds);
+void reverb_fx_free(ReverbFx *fx);
+void reverb_fx_clear(ReverbFx *fx);
+bool reverb_fx_clear_step(ReverbFx *fx, size_t *cursor, size_t *budget);
+// Adds the reverberated interleaved stereo input to out.
+void reverb_fx_process(ReverbFx *fx, const float *input, float *out, uint32_t frames);
+
+#endif // MUSIKA_FX_H
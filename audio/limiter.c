@@ -0,0 +1,131 @@
+#include "limiter.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const double LOOKAHEAD_SECONDS = 0.0015;
+static const double RELEASE_SECONDS = 0.08;
+// Samples below this are treated as denormal residue and zeroed.
+static const float SILENCE_FLOOR = 1e-30f;
+
+bool master_limiter_init(MasterLimiter *lim, uint32_t channels, uint32_t sample_rate, float ceiling_db) {
+    memset(lim, 0, sizeof(*lim));
+    if (ceiling_db > -0.1f) ceiling_db = -0.1f; // leave the soft clipper some room below full scale
+    lim->channels = channels > 0 ? channels : 1;
+    lim->lookahead = (uint32_t)(LOOKAHEAD_SECONDS * (double)sample_rate);
+    if (lim->lookahead < 1) lim->lookahead = 1;
+    lim->ceiling = powf(10.0f, ceiling_db / 20.0f);
+    lim->release = (float)(1.0 - exp(-1.0 / (RELEASE_SECONDS * (double)sample_rate)));
+    lim->delay = (float *)malloc(sizeof(float) * lim->lookahead * lim->channels);
+    lim->box = (float *)malloc(sizeof(float) * lim->lookahead);
+    lim->queue_gain = (float *)malloc(sizeof(float) * (lim->lookahead + 1));
+    lim->queue_frame = (uint64_t *)malloc(sizeof(uint64_t) * (lim->lookahead + 1));
+    if (!lim->delay || !lim->box || !lim->queue_gain || !lim->queue_frame) {
+        master_limiter_free(lim);
+        return false;
+    }
+    master_limiter_clear(lim);
+    return true;
+}
+
+void master_limiter_free(MasterLimiter *lim) {
+    free(lim->delay);
+    free(lim->box);
+    free(lim->queue_gain);
+    free(lim->queue_frame);
+    memset(lim, 0, sizeof(*lim));
+}
+
+void master_limiter_clear(MasterLimiter *lim) {
+    memset(lim->delay, 0, sizeof(float) * lim->lookahead * lim->channels);
+    for (uint32_t i = 0; i < lim->lookahead; ++i) {
+        lim->box[i] = 1.0f;
+    }
+    lim->box_sum = (double)lim->lookahead;
+    lim->queue_head = 0;
+    lim->queue_count = 0;
+    lim->pos = 0;
+    lim->frame = 0;
+    lim->envelope = 1.0f;
+    lim->min_gain = 1.0f;
+}
+
+static inline float soft_clip(float x, float knee) {
+    float a = fabsf(x);
+    if (a <= knee) return x;
+    float room = 1.0f - knee;
+    float y = knee + room * tanhf((a - knee) / room);
+    return x < 0.0f ? -y : y;
+}
+
+uint32_t master_limiter_process(MasterLimiter *lim, float *buf, uint32_t frames) {
+    const uint32_t channels = lim->channels;
+    const uint32_t window = lim->lookahead + 1;
+    const float ceiling = lim->ceiling;
+    const double inv_lookahead = 1.0 / (double)lim->lookahead;
+    uint32_t replaced = 0;
+    float min_gain = 1.0f;
+
+    for (uint32_t f = 0; f < frames; ++f) {
+        float *x = buf + (size_t)f * channels;
+        float peak = 0.0f;
+        for (uint32_t c = 0; c < channels; ++c) {
+            float v = x[c];
+            float a = fabsf(v);
+            if (!isfinite(v)) {
+                v = 0.0f;
+                a = 0.0f;
+                ++replaced;
+            } else if (a < SILENCE_FLOOR) {
+                v = 0.0f;
+                a = 0.0f;
+            }
+            x[c] = v;
+            if (a > peak) peak = a;
+        }
+        float need = peak > ceiling ? ceiling / peak : 1.0f;
+
+        // Sliding minimum of `need` over the last lookahead + 1 frames.
+        // Entries that left the window go first, so the push below always
+        // has a free slot and never overwrites the head.
+        while (lim->queue_count > 0 && lim->queue_frame[lim->queue_head] + window <= lim->frame) {
+            lim->queue_head = (lim->queue_head + 1) % window;
+            lim->queue_count--;
+        }
+        while (lim->queue_count > 0) {
+            uint32_t back = (lim->queue_head + lim->queue_count - 1) % window;
+            if (lim->queue_gain[back] < need) break;
+            lim->queue_count--;
+        }
+        assert(lim->queue_count < window);
+        uint32_t slot = (lim->queue_head + lim->queue_count) % window;
+        lim->queue_gain[slot] = need;
+        lim->queue_frame[slot] = lim->frame;
+        lim->queue_count++;
+        float target = lim->queue_gain[lim->queue_head];
+
+        if (target < lim->envelope) {
+            lim->envelope = target;
+        } else {
+            lim->envelope += (target - lim->envelope) * lim->release;
+        }
+        lim->box_sum += (double)lim->envelope - (double)lim->box[lim->pos];
+        lim->box[lim->pos] = lim->envelope;
+        float gain = (float)(lim->box_sum * inv_lookahead);
+        if (gain > 1.0f) gain = 1.0f;
+        if (gain < min_gain) min_gain = gain;
+
+        float *delayed = lim->delay + (size_t)lim->pos * channels;
+        for (uint32_t c = 0; c < channels; ++c) {
+            float out = delayed[c] * gain;
+            delayed[c] = x[c];
+            x[c] = soft_clip(out, ceiling);
+        }
+        lim->pos = (lim->pos + 1 == lim->lookahead) ? 0 : lim->pos + 1;
+        lim->frame++;
+    }
+    lim->min_gain = min_gain;
+    return replaced;
+}
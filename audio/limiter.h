@@ -0,0 +1,42 @@
+#ifndef MUSIKA_LIMITER_H
+#define MUSIKA_LIMITER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Master bus protection, run on the whole device buffer after everything
+// else: NaN/Inf and denormal samples are zeroed, a lookahead peak limiter
+// holds the interleaved output under the ceiling, and a soft clipper above
+// the ceiling catches anything left so the output never reaches full scale.
+//
+// The limiter delays the signal by `lookahead` frames. The gain needed by
+// each frame goes through a sliding minimum over lookahead + 1 frames
+// (a monotonic queue, O(1) per frame), recovers with an exponential release,
+// and is then averaged over lookahead frames, so the gain has fully reached
+// a peak's level by the time the delayed peak comes out, without clicks.
+typedef struct {
+    uint32_t channels;
+    uint32_t lookahead;
+    float ceiling;
+    float release;      // per-frame recovery step toward unity gain
+    float *delay;       // lookahead frames, interleaved
+    float *box;         // lookahead gain values being averaged
+    double box_sum;
+    float *queue_gain;  // sliding-minimum queue, lookahead + 1 entries
+    uint64_t *queue_frame;
+    uint32_t queue_head;
+    uint32_t queue_count;
+    uint32_t pos;
+    uint64_t frame;
+    float envelope;
+    float min_gain;     // lowest gain applied during the last process call
+} MasterLimiter;
+
+bool master_limiter_init(MasterLimiter *lim, uint32_t channels, uint32_t sample_rate, float ceiling_db);
+void master_limiter_free(MasterLimiter *lim);
+void master_limiter_clear(MasterLimiter *lim);
+// Processes interleaved buf in place and returns how many non-finite
+// samples were replaced with silence.
+uint32_t master_limiter_process(MasterLimiter *lim, float *buf, uint32_t frames);
+
+#endif // MUSIKA_LIMITER_H
@@ -0,0 +1,367 @@
+#include "mix.h"
+
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MIX_HAVE_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MIX_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+// --- Portable scalar kernels ---
+
+static void mix_mono_to_mono_scalar(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    (void)src_channels;
+    (void)dst_channels;
+    const float g = ramp->gain[0];
+    const float s = ramp->step[0];
+    for (uint32_t i = 0; i < frames; ++i) {
+        out[i] += src[i] * (g + s * (float)i);
+    }
+}
+
+static void mix_mono_to_stereo_scalar(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    (void)src_channels;
+    (void)dst_channels;
+    for (uint32_t i = 0; i < frames; ++i) {
+        out[2 * i] += src[i] * (ramp->gain[0] + ramp->step[0] * (float)i);
+        out[2 * i + 1] += src[i] * (ramp->gain[1] + ramp->step[1] * (float)i);
+    }
+}
+
+static void mix_stereo_to_mono_scalar(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    (void)src_channels;
+    (void)dst_channels;
+    const float g = ramp->gain[0];
+    const float s = ramp->step[0];
+    for (uint32_t i = 0; i < frames; ++i) {
+        out[i] += src[2 * i] * (g + s * (float)i);
+    }
+}
+
+static void mix_stereo_to_stereo_scalar(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    (void)src_channels;
+    (void)dst_channels;
+    for (uint32_t i = 0; i < frames; ++i) {
+        out[2 * i] += src[2 * i] * (ramp->gain[0] + ramp->step[0] * (float)i);
+        out[2 * i + 1] += src[2 * i + 1] * (ramp->gain[1] + ramp->step[1] * (float)i);
+    }
+}
+
+static void mix_generic_scalar(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    for (uint32_t i = 0; i < frames; ++i) {
+        for (uint32_t ch = 0; ch < dst_channels; ++ch) {
+            float g = ramp->gain[ch & 1] + ramp->step[ch & 1] * (float)i;
+            out[i * dst_channels + ch] += src[i * src_channels + (ch % src_channels)] * g;
+        }
+    }
+}
+
+// --- x86 SSE2 / AVX2 kernels ---
+// The ramp is evaluated as gain + step * index for every lane (rather than
+// accumulated) so all ISAs produce the same values as the scalar tail.
+
+#if defined(MIX_HAVE_X86)
+
+#define MIX_TARGET(isa) __attribute__((target(isa)))
+
+MIX_TARGET("sse2")
+static void mix_mono_to_mono_sse2(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 g = _mm_set1_ps(ramp->gain[0]);
+    const __m128 s = _mm_set1_ps(ramp->step[0]);
+    uint32_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        __m128 idx = _mm_add_ps(_mm_set1_ps((float)i), lanes);
+        __m128 gain = _mm_add_ps(g, _mm_mul_ps(s, idx));
+        __m128 o = _mm_loadu_ps(out + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(o, _mm_mul_ps(_mm_loadu_ps(src + i), gain)));
+    }
+    if (i < frames) {
+        MixRamp tail = *ramp;
+        tail.gain[0] += tail.step[0] * (float)i;
+        mix_mono_to_mono_scalar(out + i, src + i, frames - i, src_channels, dst_channels, &tail);
+    }
+}
+
+MIX_TARGET("sse2")
+static void mix_mono_to_stereo_sse2(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    const __m128 lanes_lo = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+    const __m128 lanes_hi = _mm_setr_ps(2.0f, 2.0f, 3.0f, 3.0f);
+    const __m128 g = _mm_setr_ps(ramp->gain[0], ramp->gain[1], ramp->gain[0], ramp->gain[1]);
+    const __m128 s = _mm_setr_ps(ramp->step[0], ramp->step[1], ramp->step[0], ramp->step[1]);
+    uint32_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        __m128 base = _mm_set1_ps((float)i);
+        __m128 gain_lo = _mm_add_ps(g, _mm_mul_ps(s, _mm_add_ps(base, lanes_lo)));
+        __m128 gain_hi = _mm_add_ps(g, _mm_mul_ps(s, _mm_add_ps(base, lanes_hi)));
+        __m128 x = _mm_loadu_ps(src + i);
+        __m128 lo = _mm_unpacklo_ps(x, x);
+        __m128 hi = _mm_unpackhi_ps(x, x);
+        float *o = out + 2 * i;
+        _mm_storeu_ps(o, _mm_add_ps(_mm_loadu_ps(o), _mm_mul_ps(lo, gain_lo)));
+        _mm_storeu_ps(o + 4, _mm_add_ps(_mm_loadu_ps(o + 4), _mm_mul_ps(hi, gain_hi)));
+    }
+    if (i < frames) {
+        MixRamp tail = *ramp;
+        tail.gain[0] += tail.step[0] * (float)i;
+        tail.gain[1] += tail.step[1] * (float)i;
+        mix_mono_to_stereo_scalar(out + 2 * i, src + i, frames - i, src_channels, dst_channels, &tail);
+    }
+}
+
+MIX_TARGET("sse2")
+static void mix_stereo_to_mono_sse2(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 g = _mm_set1_ps(ramp->gain[0]);
+    const __m128 s = _mm_set1_ps(ramp->step[0]);
+    uint32_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        __m128 idx = _mm_add_ps(_mm_set1_ps((float)i), lanes);
+        __m128 gain = _mm_add_ps(g, _mm_mul_ps(s, idx));
+        __m128 a = _mm_loadu_ps(src + 2 * i);
+        __m128 b = _mm_loadu_ps(src + 2 * i + 4);
+        __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 o = _mm_loadu_ps(out + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(o, _mm_mul_ps(left, gain)));
+    }
+    if (i < frames) {
+        MixRamp tail = *ramp;
+        tail.gain[0] += tail.step[0] * (float)i;
+        mix_stereo_to_mono_scalar(out + i, src + 2 * i, frames - i, src_channels, dst_channels, &tail);
+    }
+}
+
+MIX_TARGET("sse2")
+static void mix_stereo_to_stereo_sse2(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    const __m128 lanes = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+    const __m128 g = _mm_setr_ps(ramp->gain[0], ramp->gain[1], ramp->gain[0], ramp->gain[1]);
+    const __m128 s = _mm_setr_ps(ramp->step[0], ramp->step[1], ramp->step[0], ramp->step[1]);
+    uint32_t i = 0;
+    for (; i + 2 <= frames; i += 2) {
+        __m128 idx = _mm_add_ps(_mm_set1_ps((float)i), lanes);
+        __m128 gain = _mm_add_ps(g, _mm_mul_ps(s, idx));
+        float *o = out + 2 * i;
+        _mm_storeu_ps(o, _mm_add_ps(_mm_loadu_ps(o), _mm_mul_ps(_mm_loadu_ps(src + 2 * i), gain)));
+    }
+    if (i < frames) {
+        MixRamp tail = *ramp;
+        tail.gain[0] += tail.step[0] * (float)i;
+        tail.gain[1] += tail.step[1] * (float)i;
+        mix_stereo_to_stereo_scalar(out + 2 * i, src + 2 * i, frames - i, src_channels, dst_channels, &tail);
+    }
+}
+
+MIX_TARGET("avx2")
+static void mix_mono_to_mono_avx2(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    const __m256 lanes = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256 g = _mm256_set1_ps(ramp->gain[0]);
+    const __m256 s = _mm256_set1_ps(ramp->step[0]);
+    uint32_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        __m256 idx = _mm256_add_ps(_mm256_set1_ps((float)i), lanes);
+        __m256 gain = _mm256_add_ps(g, _mm256_mul_ps(s, idx));
+        __m256 o = _mm256_loadu_ps(out + i);
+        _mm256_storeu_ps(out + i, _mm256_add_ps(o, _mm256_mul_ps(_mm256_loadu_ps(src + i), gain)));
+    }
+    if (i < frames) {
+        MixRamp tail = *ramp;
+        tail.gain[0] += tail.step[0] * (float)i;
+        mix_mono_to_mono_scalar(out + i, src + i, frames - i, src_channels, dst_channels, &tail);
+    }
+}
+
+MIX_TARGET("avx2")
+static void mix_mono_to_stereo_avx2(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    const __m256 lanes_lo = _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f);
+    const __m256 lanes_hi = _mm256_setr_ps(4.0f, 4.0f, 5.0f, 5.0f, 6.0f, 6.0f, 7.0f, 7.0f);
+    const __m256 g = _mm256_setr_ps(ramp->gain[0], ramp->gain[1], ramp->gain[0], ramp->gain[1],
+                                    ramp->gain[0], ramp->gain[1], ramp->gain[0], ramp->gain[1]);
+    const __m256 s = _mm256_setr_ps(ramp->step[0], ramp->step[1], ramp->step[0], ramp->step[1],
+                                    ramp->step[0], ramp->step[1], ramp->step[0], ramp->step[1]);
+    uint32_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        __m256 base = _mm256_set1_ps((float)i);
+        __m256 gain_lo = _mm256_add_ps(g, _mm256_mul_ps(s, _mm256_add_ps(base, lanes_lo)));
+        __m256 gain_hi = _mm256_add_ps(g, _mm256_mul_ps(s, _mm256_add_ps(base, lanes_hi)));
+        __m256 x = _mm256_loadu_ps(src + i);
+        __m256 lo = _mm256_unpacklo_ps(x, x);
+        __m256 hi = _mm256_unpackhi_ps(x, x);
+        __m256 first = _mm256_permute2f128_ps(lo, hi, 0x20);
+        __m256 second = _mm256_permute2f128_ps(lo, hi, 0x31);
+        float *o = out + 2 * i;
+        _mm256_storeu_ps(o, _mm256_add_ps(_mm256_loadu_ps(o), _mm256_mul_ps(first, gain_lo)));
+        _mm256_storeu_ps(o + 8, _mm256_add_ps(_mm256_loadu_ps(o + 8), _mm256_mul_ps(second, gain_hi)));
+    }
+    if (i < frames) {
+        MixRamp tail = *ramp;
+        tail.gain[0] += tail.step[0] * (float)i;
+        tail.gain[1] += tail.step[1] * (float)i;
+        mix_mono_to_stereo_scalar(out + 2 * i, src + i, frames - i, src_channels, dst_channels, &tail);
+    }
+}
+
+MIX_TARGET("avx2")
+static void mix_stereo_to_mono_avx2(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    const __m256 lanes = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256 g = _mm256_set1_ps(ramp->gain[0]);
+    const __m256 s = _mm256_set1_ps(ramp->step[0]);
+    uint32_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        __m256 idx = _mm256_add_ps(_mm256_set1_ps((float)i), lanes);
+        __m256 gain = _mm256_add_ps(g, _mm256_mul_ps(s, idx));
+        __m256 a = _mm256_loadu_ps(src + 2 * i);
+        __m256 b = _mm256_loadu_ps(src + 2 * i + 8);
+        // [L0 L1 L4 L5 | L2 L3 L6 L7] -> [L0 .. L7]
+        __m256 mixed = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 left = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(mixed), _MM_SHUFFLE(3, 1, 2, 0)));
+        __m256 o = _mm256_loadu_ps(out + i);
+        _mm256_storeu_ps(out + i, _mm256_add_ps(o, _mm256_mul_ps(left, gain)));
+    }
+    if (i < frames) {
+        MixRamp tail = *ramp;
+        tail.gain[0] += tail.step[0] * (float)i;
+        mix_stereo_to_mono_scalar(out + i, src + 2 * i, frames - i, src_channels, dst_channels, &tail);
+    }
+}
+
+MIX_TARGET("avx2")
+static void mix_stereo_to_stereo_avx2(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    const __m256 lanes = _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f);
+    const __m256 g = _mm256_setr_ps(ramp->gain[0], ramp->gain[1], ramp->gain[0], ramp->gain[1],
+                                    ramp->gain[0], ramp->gain[1], ramp->gain[0], ramp->gain[1]);
+    const __m256 s = _mm256_setr_ps(ramp->step[0], ramp->step[1], ramp->step[0], ramp->step[1],
+                                    ramp->step[0], ramp->step[1], ramp->step[0], ramp->step[1]);
+    uint32_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        __m256 idx = _mm256_add_ps(_mm256_set1_ps((float)i), lanes);
+        __m256 gain = _mm256_add_ps(g, _mm256_mul_ps(s, idx));
+        float *o = out + 2 * i;
+        _mm256_storeu_ps(o, _mm256_add_ps(_mm256_loadu_ps(o), _mm256_mul_ps(_mm256_loadu_ps(src + 2 * i), gain)));
+    }
+    if (i < frames) {
+        MixRamp tail = *ramp;
+        tail.gain[0] += tail.step[0] * (float)i;
+        tail.gain[1] += tail.step[1] * (float)i;
+        mix_stereo_to_stereo_scalar(out + 2 * i, src + 2 * i, frames - i, src_channels, dst_channels, &tail);
+    }
+}
+
+#endif // MIX_HAVE_X86
+
+// --- ARM NEON kernels ---
+
+#if defined(MIX_HAVE_NEON)
+
+static inline float32x4_t neon_ramp(float gain, float step, uint32_t i) {
+    static const float lanes_data[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+    float32x4_t idx = vaddq_f32(vdupq_n_f32((float)i), vld1q_f32(lanes_data));
+    return vaddq_f32(vdupq_n_f32(gain), vmulq_f32(vdupq_n_f32(step), idx));
+}
+
+static void mix_mono_to_mono_neon(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    uint32_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        float32x4_t gain = neon_ramp(ramp->gain[0], ramp->step[0], i);
+        vst1q_f32(out + i, vaddq_f32(vld1q_f32(out + i), vmulq_f32(vld1q_f32(src + i), gain)));
+    }
+    if (i < frames) {
+        MixRamp tail = *ramp;
+        tail.gain[0] += tail.step[0] * (float)i;
+        mix_mono_to_mono_scalar(out + i, src + i, frames - i, src_channels, dst_channels, &tail);
+    }
+}
+
+static void mix_mono_to_stereo_neon(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    uint32_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        float32x4_t x = vld1q_f32(src + i);
+        float32x4x2_t o = vld2q_f32(out + 2 * i);
+        o.val[0] = vaddq_f32(o.val[0], vmulq_f32(x, neon_ramp(ramp->gain[0], ramp->step[0], i)));
+        o.val[1] = vaddq_f32(o.val[1], vmulq_f32(x, neon_ramp(ramp->gain[1], ramp->step[1], i)));
+        vst2q_f32(out + 2 * i, o);
+    }
+    if (i < frames) {
+        MixRamp tail = *ramp;
+        tail.gain[0] += tail.step[0] * (float)i;
+        tail.gain[1] += tail.step[1] * (float)i;
+        mix_mono_to_stereo_scalar(out + 2 * i, src + i, frames - i, src_channels, dst_channels, &tail);
+    }
+}
+
+static void mix_stereo_to_mono_neon(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    uint32_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        float32x4x2_t x = vld2q_f32(src + 2 * i);
+        float32x4_t gain = neon_ramp(ramp->gain[0], ramp->step[0], i);
+        vst1q_f32(out + i, vaddq_f32(vld1q_f32(out + i), vmulq_f32(x.val[0], gain)));
+    }
+    if (i < frames) {
+        MixRamp tail = *ramp;
+        tail.gain[0] += tail.step[0] * (float)i;
+        mix_stereo_to_mono_scalar(out + i, src + 2 * i, frames - i, src_channels, dst_channels, &tail);
+    }
+}
+
+static void mix_stereo_to_stereo_neon(float *out, const float *src, uint32_t frames, uint32_t src_channels, uint32_t dst_channels, const MixRamp *ramp) {
+    uint32_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        float32x4x2_t x = vld2q_f32(src + 2 * i);
+        float32x4x2_t o = vld2q_f32(out + 2 * i);
+        o.val[0] = vaddq_f32(o.val[0], vmulq_f32(x.val[0], neon_ramp(ramp->gain[0], ramp->step[0], i)));
+        o.val[1] = vaddq_f32(o.val[1], vmulq_f32(x.val[1], neon_ramp(ramp->gain[1], ramp->step[1], i)));
+        vst2q_f32(out + 2 * i, o);
+    }
+    if (i < frames) {
+        MixRamp tail = *ramp;
+        tail.gain[0] += tail.step[0] * (float)i;
+        tail.gain[1] += tail.step[1] * (float)i;
+        mix_stereo_to_stereo_scalar(out + 2 * i, src + 2 * i, frames - i, src_channels, dst_channels, &tail);
+    }
+}
+
+#endif // MIX_HAVE_NEON
+
+void mix_kernels_select(MixKernels *kernels) {
+    if (!kernels) return;
+    kernels->mono_to_mono = mix_mono_to_mono_scalar;
+    kernels->mono_to_stereo = mix_mono_to_stereo_scalar;
+    kernels->stereo_to_mono = mix_stereo_to_mono_scalar;
+    kernels->stereo_to_stereo = mix_stereo_to_stereo_scalar;
+    kernels->generic = mix_generic_scalar;
+    kernels->isa = "scalar";
+
+#if defined(MIX_HAVE_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        kernels->mono_to_mono = mix_mono_to_mono_sse2;
+        kernels->mono_to_stereo = mix_mono_to_stereo_sse2;
+        kernels->stereo_to_mono = mix_stereo_to_mono_sse2;
+        kernels->stereo_to_stereo = mix_stereo_to_stereo_sse2;
+        kernels->isa = "sse2";
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        kernels->mono_to_mono = mix_mono_to_mono_avx2;
+        kernels->mono_to_stereo = mix_mono_to_stereo_avx2;
+        kernels->stereo_to_mono = mix_stereo_to_mono_avx2;
+        kernels->stereo_to_stereo = mix_stereo_to_stereo_avx2;
+        kernels->isa = "avx2";
+    }
+#elif defined(MIX_HAVE_NEON)
+    kernels->mono_to_mono = mix_mono_to_mono_neon;
+    kernels->mono_to_stereo = mix_mono_to_stereo_neon;
+    kernels->stereo_to_mono = mix_stereo_to_mono_neon;
+    kernels->stereo_to_stereo = mix_stereo_to_stereo_neon;
+    kernels->isa = "neon";
+#endif
+}
+
+MixKernel mix_kernel_for(const MixKernels *kernels, uint32_t src_channels, uint32_t dst_channels) {
+    if (src_channels == 1 && dst_channels == 1) return kernels->mono_to_mono;
+    if (src_channels == 1 && dst_channels == 2) return kernels->mono_to_stereo;
+    if (src_channels == 2 && dst_channels == 1) return kernels->stereo_to_mono;
+    if (src_channels == 2 && dst_channels == 2) return kernels->stereo_to_stereo;
+    return kernels->generic;
+}
@@ -0,0 +1,45 @@
+#ifndef MUSIKA_MIX_H
+#define MUSIKA_MIX_H
+
+#include <stdint.h>
+
+// Linear gain ramp applied while accumulating a source block into the mix.
+// Index 0 drives the left (or only) output channel, index 1 the right one;
+// outputs beyond stereo reuse the pair by channel parity.
+typedef struct {
+    float gain[2];
+    float step[2];
+} MixRamp;
+
+// Accumulates frames of interleaved src (src_channels wide) into interleaved
+// out (dst_channels wide): out[f][c] += src[f][c % src_channels] * gain(f, c).
+typedef void (*MixKernel)(float *out,
+                          const float *src,
+                          uint32_t frames,
+                          uint32_t src_channels,
+                          uint32_t dst_channels,
+                          const MixRamp *ramp);
+
+typedef struct {
+    MixKernel mono_to_mono;
+    MixKernel mono_to_stereo;
+    MixKernel stereo_to_mono;
+    MixKernel stereo_to_stereo;
+    MixKernel generic;
+    const char *isa;
+} MixKernels;
+
+// Picks the widest kernel set the running CPU supports.
+void mix_kernels_select(MixKernels *kernels);
+MixKernel mix_kernel_for(const MixKernels *kernels, uint32_t src_channels, uint32_t dst_channels);
+
+static inline MixRamp mix_ramp_uniform(float gain, float step) {
+    MixRamp ramp;
+    ramp.gain[0] = gain;
+    ramp.gain[1] = gain;
+    ramp.step[0] = step;
+    ramp.step[1] = step;
+    return ramp;
+}
+
+#endif // MUSIKA_MIX_H
@@ -0,0 +1,102 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "pcmstore.h"
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "rt.h"
+
+static const char pcm_store_magic[8] = {'M', 'S', 'K', 'P', 'C', 'M', '\0', '\0'};
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t format; // AudioSampleFormat
+    uint32_t channels;
+    uint32_t sample_rate;
+    uint64_t frame_count;
+    uint64_t source_size;
+    int64_t source_mtime_ns;
+    uint8_t reserved[16];
+} PcmStoreHeader;
+
+_Static_assert(sizeof(PcmStoreHeader) == PCM_STORE_HEADER_BYTES, "PCM store header must stay 64 bytes");
+
+bool pcm_store_source_of(const char *path, PcmStoreSource *out) {
+    struct stat st;
+    if (!path || stat(path, &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    out->size = (uint64_t)st.st_size;
+    out->mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+bool pcm_store_map(const char *path, const PcmStoreSource *source, AudioSampleFormat format, AudioSample *out) {
+    memset(out, 0, sizeof(*out));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < PCM_STORE_HEADER_BYTES) {
+        close(fd);
+        return false;
+    }
+    size_t bytes = (size_t)st.st_size;
+    void *map = mmap(NULL, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    const PcmStoreHeader *header = (const PcmStoreHeader *)map;
+    bool valid = memcmp(header->magic, pcm_store_magic, sizeof(pcm_store_magic)) == 0 &&
+                 header->version == PCM_STORE_VERSION && header->format == (uint32_t)format &&
+                 header->channels > 0 && header->channels <= AUDIO_MAX_SAMPLE_CHANNELS &&
+                 header->frame_count > 0 && header->frame_count <= UINT32_MAX &&
+                 header->source_size == source->size && header->source_mtime_ns == source->mtime_ns &&
+                 bytes == PCM_STORE_HEADER_BYTES + header->frame_count * header->channels *
+                              (format == AUDIO_SAMPLE_S16 ? sizeof(int16_t) : sizeof(float));
+    if (!valid) {
+        munmap(map, bytes);
+        return false;
+    }
+    out->data = (float *)((char *)map + PCM_STORE_HEADER_BYTES); // the union's other member aliases it
+    out->format = format;
+    out->frame_count = (uint32_t)header->frame_count;
+    out->channels = header->channels;
+    out->sample_rate = header->sample_rate;
+    out->mapping = map;
+    out->mapping_bytes = bytes;
+    // Fault the pages in now so the audio thread never waits on the disk.
+    rt_lock_buffer(out->data, bytes - PCM_STORE_HEADER_BYTES);
+    return true;
+}
+
+bool pcm_store_write(const char *path, const PcmStoreSource *source, const AudioSample *sample) {
+    static _Atomic unsigned long counter;
+    if (!path || !sample || !sample->data || sample->frame_count == 0) return false;
+    PcmStoreHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, pcm_store_magic, sizeof(pcm_store_magic));
+    header.version = PCM_STORE_VERSION;
+    header.format = (uint32_t)sample->format;
+    header.channels = sample->channels;
+    header.sample_rate = sample->sample_rate;
+    header.frame_count = sample->frame_count;
+    header.source_size = source->size;
+    header.source_mtime_ns = source->mtime_ns;
+
+    char tmp[1024];
+    unsigned long n = atomic_fetch_add(&counter, 1);
+    if (snprintf(tmp, sizeof(tmp), "%s.%ld.%lu.tmp", path, (long)getpid(), n) >= (int)sizeof(tmp)) return false;
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return false;
+    size_t bytes = audio_sample_bytes(sample);
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(sample->data, 1, bytes, f) == bytes;
+    ok = fclose(f) == 0 && ok;
+    if (ok && rename(tmp, path) != 0) ok = false;
+    if (!ok) remove(tmp);
+    return ok;
+}
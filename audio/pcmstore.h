@@ -0,0 +1,32 @@
+#ifndef MUSIKA_PCMSTORE_H
+#define MUSIKA_PCMSTORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "audio.h"
+
+// Decoded samples kept on disk in the layout AudioSample uses, so a later
+// load maps the file read-only instead of decoding it. A file is a 64-byte
+// header followed by the interleaved frames, float or int16. Processes that
+// map the same file share its pages through the page cache.
+enum { PCM_STORE_VERSION = 1 };
+enum { PCM_STORE_HEADER_BYTES = 64 };
+
+// Identifies the file a sample was decoded from, so a changed source is
+// decoded again rather than served stale.
+typedef struct {
+    uint64_t size;
+    int64_t mtime_ns;
+} PcmStoreSource;
+
+bool pcm_store_source_of(const char *path, PcmStoreSource *out);
+// Maps path into out if it holds a sample decoded from source in format.
+// out->data then points into the read-only mapping; audio_sample_free
+// unmaps it.
+bool pcm_store_map(const char *path, const PcmStoreSource *source, AudioSampleFormat format, AudioSample *out);
+// Writes sample to path through a temporary file renamed into place, so a
+// concurrent reader sees either no file or a complete one.
+bool pcm_store_write(const char *path, const PcmStoreSource *source, const AudioSample *sample);
+
+#endif // MUSIKA_PCMSTORE_H
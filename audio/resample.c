@@ -0,0 +1,295 @@
+#include "resample.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <pthread.h>
+#include <stddef.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Polyphase windowed-sinc: 16 taps, 256 phases with linear interpolation
+// between neighbouring phases. Extra tables with lower cutoffs band-limit
+// voices that are pitched up (increment above 1) so they do not alias.
+enum { SINC_TAPS = 16, SINC_HALF = SINC_TAPS / 2, SINC_PHASES = 256, SINC_TABLES = 4 };
+_Static_assert(SINC_PHASES == 256, "render_sinc selects phases from the top 8 fraction bits");
+
+static float sinc_tables[SINC_TABLES][SINC_PHASES + 1][SINC_TAPS];
+static pthread_once_t sinc_once = PTHREAD_ONCE_INIT;
+
+static double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    double half = x * 0.5;
+    for (int k = 1; k < 32; ++k) {
+        term *= (half / (double)k) * (half / (double)k);
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+static void build_sinc_tables(void) {
+    const double beta = 8.0;
+    const double norm = bessel_i0(beta);
+    for (int t = 0; t < SINC_TABLES; ++t) {
+        double cutoff = 0.95 / (double)(t + 1);
+        for (int p = 0; p <= SINC_PHASES; ++p) {
+            double frac = (double)p / (double)SINC_PHASES;
+            double coeffs[SINC_TAPS];
+            double sum = 0.0;
+            for (int k = 0; k < SINC_TAPS; ++k) {
+                double x = (double)(k - (SINC_HALF - 1)) - frac;
+                double r = x / (double)SINC_HALF;
+                double window = (fabs(r) <= 1.0) ? bessel_i0(beta * sqrt(1.0 - r * r)) / norm : 0.0;
+                double y = cutoff * x;
+                double sinc = (fabs(y) < 1e-9) ? 1.0 : sin(M_PI * y) / (M_PI * y);
+                coeffs[k] = cutoff * sinc * window;
+                sum += coeffs[k];
+            }
+            for (int k = 0; k < SINC_TAPS; ++k) {
+                sinc_tables[t][p][k] = (float)(coeffs[k] / sum);
+            }
+        }
+    }
+}
+
+void resample_init(void) {
+    pthread_once(&sinc_once, build_sinc_tables);
+}
+
+static bool equals_ci(const char *a, const char *b) {
+    while (*a && *b) {
+        if (tolower((unsigned char)*a) != tolower((unsigned char)*b)) return false;
+        ++a;
+        ++b;
+    }
+    return *a == '\0' && *b == '\0';
+}
+
+bool resample_quality_from_name(const char *name, ResampleQuality *out_quality) {
+    if (!name || !out_quality) return false;
+    if (equals_ci(name, "nearest") || equals_ci(name, "none")) {
+        *out_quality = RESAMPLE_NEAREST;
+    } else if (equals_ci(name, "linear")) {
+        *out_quality = RESAMPLE_LINEAR;
+    } else if (equals_ci(name, "cubic") || equals_ci(name, "hermite")) {
+        *out_quality = RESAMPLE_CUBIC;
+    } else if (equals_ci(name, "sinc")) {
+        *out_quality = RESAMPLE_SINC;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *resample_quality_name(ResampleQuality quality) {
+    switch (quality) {
+        case RESAMPLE_NEAREST: return "nearest";
+        case RESAMPLE_LINEAR: return "linear";
+        case RESAMPLE_CUBIC: return "cubic";
+        case RESAMPLE_SINC: return "sinc";
+        default: return "default";
+    }
+}
+
+static inline float tap(const float *data, uint32_t frame_count, uint32_t channels, int64_t idx, uint32_t ch) {
+    if (idx < 0 || idx >= (int64_t)frame_count) return 0.0f;
+    return data[(size_t)idx * channels + ch];
+}
+
+static inline float frac_of(uint64_t position) {
+    return (float)(uint32_t)position * (1.0f / 4294967296.0f);
+}
+
+static uint64_t render_nearest(const float *data, uint32_t frame_count, uint32_t channels, uint64_t position, uint64_t increment, float *dst, uint32_t frames) {
+    for (uint32_t i = 0; i < frames; ++i, position += increment) {
+        int64_t idx = (int64_t)(position >> RESAMPLE_FRAC_BITS);
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+            dst[i * channels + ch] = tap(data, frame_count, channels, idx, ch);
+        }
+    }
+    return position;
+}
+
+static uint64_t render_linear(const float *data, uint32_t frame_count, uint32_t channels, uint64_t position, uint64_t increment, float *dst, uint32_t frames) {
+    for (uint32_t i = 0; i < frames; ++i, position += increment) {
+        int64_t idx = (int64_t)(position >> RESAMPLE_FRAC_BITS);
+        float f = frac_of(position);
+        if (idx + 1 < (int64_t)frame_count) {
+            const float *x = data + (size_t)idx * channels;
+            for (uint32_t ch = 0; ch < channels; ++ch) {
+                float a = x[ch];
+                float b = x[channels + ch];
+                dst[i * channels + ch] = a + f * (b - a);
+            }
+            continue;
+        }
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+            float a = tap(data, frame_count, channels, idx, ch);
+            float b = tap(data, frame_count, channels, idx + 1, ch);
+            dst[i * channels + ch] = a + f * (b - a);
+        }
+    }
+    return position;
+}
+
+static inline float hermite(float xm1, float x0, float x1, float x2, float f) {
+    float c1 = 0.5f * (x1 - xm1);
+    float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+    float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+    return ((c3 * f + c2) * f + c1) * f + x0;
+}
+
+static uint64_t render_cubic(const float *data, uint32_t frame_count, uint32_t channels, uint64_t position, uint64_t increment, float *dst, uint32_t frames) {
+    for (uint32_t i = 0; i < frames; ++i, position += increment) {
+        int64_t idx = (int64_t)(position >> RESAMPLE_FRAC_BITS);
+        float f = frac_of(position);
+        if (idx >= 1 && idx + 2 < (int64_t)frame_count) {
+            const float *x = data + (size_t)(idx - 1) * channels;
+            for (uint32_t ch = 0; ch < channels; ++ch) {
+                dst[i * channels + ch] = hermite(x[ch], x[channels + ch], x[2 * channels + ch], x[3 * channels + ch], f);
+            }
+            continue;
+        }
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+            dst[i * channels + ch] = hermite(tap(data, frame_count, channels, idx - 1, ch),
+                                             tap(data, frame_count, channels, idx, ch),
+                                             tap(data, frame_count, channels, idx + 1, ch),
+                                             tap(data, frame_count, channels, idx + 2, ch),
+                                             f);
+        }
+    }
+    return position;
+}
+
+static uint64_t render_sinc(const float *data, uint32_t frame_count, uint32_t channels, uint64_t position, uint64_t increment, float *dst, uint32_t frames) {
+    // Table t cuts off at 0.95 / (t + 1). Between two integer ratios blend
+    // the neighbouring tables so the combined passband tracks 0.95 / ratio.
+    int table = 0;
+    float mix = 0.0f;
+    if (increment > RESAMPLE_ONE) {
+        double ratio = (double)increment / (double)RESAMPLE_ONE;
+        if (ratio >= (double)SINC_TABLES) {
+            table = SINC_TABLES - 1;
+        } else {
+            double lower = floor(ratio);
+            table = (int)lower - 1;
+            mix = (float)((lower + 1.0) * (ratio - lower) / ratio);
+        }
+    }
+    int blend = mix > 0.0f ? table + 1 : table;
+    for (uint32_t i = 0; i < frames; ++i, position += increment) {
+        int64_t idx = (int64_t)(position >> RESAMPLE_FRAC_BITS);
+        // Top 8 fraction bits pick the phase row, the remaining 24 blend rows.
+        uint32_t frac = (uint32_t)position;
+        uint32_t p = frac >> 24;
+        float pf = (float)(frac & 0xFFFFFFu) * (1.0f / 16777216.0f);
+        const float *r0 = sinc_tables[table][p];
+        const float *r1 = sinc_tables[table][p + 1];
+        const float *b0 = sinc_tables[blend][p];
+        const float *b1 = sinc_tables[blend][p + 1];
+        float coeffs[SINC_TAPS];
+        for (int k = 0; k < SINC_TAPS; ++k) {
+            float a = r0[k] + pf * (r1[k] - r0[k]);
+            float b = b0[k] + pf * (b1[k] - b0[k]);
+            coeffs[k] = a + mix * (b - a);
+        }
+
+        int64_t first = idx - (SINC_HALF - 1);
+        if (first >= 0 && first + SINC_TAPS <= (int64_t)frame_count) {
+            const float *x = data + (size_t)first * channels;
+            for (uint32_t ch = 0; ch < channels; ++ch) {
+                float acc = 0.0f;
+                for (int k = 0; k < SINC_TAPS; ++k) {
+                    acc += x[(size_t)k * channels + ch] * coeffs[k];
+                }
+                dst[i * channels + ch] = acc;
+            }
+            continue;
+        }
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+            float acc = 0.0f;
+            for (int k = 0; k < SINC_TAPS; ++k) {
+                acc += tap(data, frame_count, channels, first + k, ch) * coeffs[k];
+            }
+            dst[i * channels + ch] = acc;
+        }
+    }
+    return position;
+}
+
+uint64_t resample_render(ResampleQuality quality,
+                         const float *data,
+                         uint32_t frame_count,
+                         uint32_t channels,
+                         uint64_t position,
+                         uint64_t increment,
+                         float *dst,
+                         uint32_t frames) {
+    switch (quality) {
+        case RESAMPLE_NEAREST:
+            return render_nearest(data, frame_count, channels, position, increment, dst, frames);
+        case RESAMPLE_LINEAR:
+            return render_linear(data, frame_count, channels, position, increment, dst, frames);
+        case RESAMPLE_SINC:
+            return render_sinc(data, frame_count, channels, position, increment, dst, frames);
+        case RESAMPLE_CUBIC:
+        default:
+            return render_cubic(data, frame_count, channels, position, increment, dst, frames);
+    }
+}
+
+// Widens the source frames the interpolator will touch into a float window
+// on the stack, then runs the float renderer over the window. Frames outside
+// the sample are zero in the window just as tap() reads them, so the output
+// is exactly what the float renderer gives for the same data.
+uint64_t resample_render_s16(ResampleQuality quality,
+                             const int16_t *data,
+                             uint32_t frame_count,
+                             uint32_t channels,
+                             uint64_t position,
+                             uint64_t increment,
+                             float *dst,
+                             uint32_t frames) {
+    const float scale = 1.0f / 32768.0f;
+    int64_t idx = (int64_t)(position >> RESAMPLE_FRAC_BITS);
+    if (increment == RESAMPLE_ONE && (uint32_t)position == 0 && idx + (int64_t)frames <= (int64_t)frame_count) {
+        const int16_t *src = data + (size_t)idx * channels;
+        for (size_t i = 0; i < (size_t)frames * channels; ++i) {
+            dst[i] = (float)src[i] * scale;
+        }
+        return position + ((uint64_t)frames << RESAMPLE_FRAC_BITS);
+    }
+
+    float window[RESAMPLE_S16_WINDOW];
+    const int64_t window_frames = RESAMPLE_S16_WINDOW / channels;
+    // Widest reach of any interpolator around a position's frame.
+    const int64_t reach_before = SINC_HALF;
+    const int64_t reach_after = SINC_HALF + 1;
+    while (frames > 0) {
+        int64_t first = (int64_t)(position >> RESAMPLE_FRAC_BITS) - reach_before;
+        uint64_t room = (uint64_t)(window_frames - reach_before - reach_after - 2) << RESAMPLE_FRAC_BITS;
+        uint64_t fit = 1 + room / increment;
+        uint32_t n = fit < frames ? (uint32_t)fit : frames;
+        int64_t last = (int64_t)((position + (uint64_t)(n - 1) * increment) >> RESAMPLE_FRAC_BITS) + reach_after;
+        int64_t count = last - first + 1;
+        for (int64_t f = 0; f < count; ++f) {
+            int64_t src_frame = first + f;
+            float *w = window + (size_t)f * channels;
+            if (src_frame < 0 || src_frame >= (int64_t)frame_count) {
+                for (uint32_t ch = 0; ch < channels; ++ch) w[ch] = 0.0f;
+                continue;
+            }
+            const int16_t *x = data + (size_t)src_frame * channels;
+            for (uint32_t ch = 0; ch < channels; ++ch) w[ch] = (float)x[ch] * scale;
+        }
+        uint64_t local = position - ((uint64_t)first << RESAMPLE_FRAC_BITS);
+        resample_render(quality, window, (uint32_t)count, channels, local, increment, dst, n);
+        position += (uint64_t)n * increment;
+        dst += (size_t)n * channels;
+        frames -= n;
+    }
+    return position;
+}
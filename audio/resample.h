@@ -0,0 +1,58 @@
+#ifndef MUSIKA_RESAMPLE_H
+#define MUSIKA_RESAMPLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Source positions and increments are 32.32 fixed point: the high word is
+// the source frame, the low word the fraction that feeds the interpolator.
+#define RESAMPLE_FRAC_BITS 32
+#define RESAMPLE_ONE ((uint64_t)1 << RESAMPLE_FRAC_BITS)
+
+typedef enum {
+    RESAMPLE_DEFAULT = 0, // defer to the engine-wide setting
+    RESAMPLE_NEAREST,
+    RESAMPLE_LINEAR,
+    RESAMPLE_CUBIC,
+    RESAMPLE_SINC,
+} ResampleQuality;
+
+// Builds the windowed-sinc polyphase tables. Safe to call more than once.
+void resample_init(void);
+
+bool resample_quality_from_name(const char *name, ResampleQuality *out_quality);
+const char *resample_quality_name(ResampleQuality quality);
+
+static inline uint64_t resample_increment_from_rate(double rate) {
+    if (rate <= 0.0) return RESAMPLE_ONE;
+    if (rate > 65536.0) rate = 65536.0;
+    uint64_t increment = (uint64_t)(rate * (double)RESAMPLE_ONE + 0.5);
+    return increment > 0 ? increment : 1;
+}
+
+// Reads frames output frames from interleaved data (frame_count frames of
+// channels samples) starting at the fixed-point source position and
+// advancing by increment per output frame. Taps outside the sample read as
+// silence. Returns the position after the last frame.
+uint64_t resample_render(ResampleQuality quality,
+                         const float *data,
+                         uint32_t frame_count,
+                         uint32_t channels,
+                         uint64_t position,
+                         uint64_t increment,
+                         float *dst,
+                         uint32_t frames);
+
+// The same for 16-bit sources, widened to float as they are read. channels
+// must be at most RESAMPLE_S16_WINDOW / 32.
+enum { RESAMPLE_S16_WINDOW = 4096 }; // floats of widened source kept on the stack
+uint64_t resample_render_s16(ResampleQuality quality,
+                             const int16_t *data,
+                             uint32_t frame_count,
+                             uint32_t channels,
+                             uint64_t position,
+                             uint64_t increment,
+                             float *dst,
+                             uint32_t frames);
+
+#endif // MUSIKA_RESAMPLE_H
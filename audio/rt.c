@@ -0,0 +1,97 @@
+#define _GNU_SOURCE
+#include "rt.h"
+
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+static atomic_bool lock_buffers;
+
+RealtimeConfig rt_config_default(void) {
+    RealtimeConfig config;
+    config.enabled = false;
+    config.priority = 70;
+    config.cpu = -1;
+    config.lock_memory = true;
+    return config;
+}
+
+bool rt_promote_thread(pthread_t thread, int priority, int cpu) {
+#ifdef __linux__
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (pthread_setaffinity_np(thread, sizeof(set), &set) != 0) {
+            fprintf(stderr, "Warning: could not pin the audio thread to CPU %d\n", cpu);
+        }
+    }
+#else
+    (void)cpu;
+#endif
+    int lo = sched_get_priority_min(SCHED_FIFO);
+    int hi = sched_get_priority_max(SCHED_FIFO);
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority < lo ? lo : (priority > hi ? hi : priority);
+    return pthread_setschedparam(thread, SCHED_FIFO, &param) == 0;
+}
+
+void rt_flush_denormals(void) {
+#if defined(__SSE__)
+    _mm_setcsr(_mm_getcsr() | 0x8040); // FTZ (bit 15) | DAZ (bit 6)
+#elif defined(__aarch64__)
+    uint64_t fpcr;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr | (1ull << 24))); // FZ
+#endif
+}
+
+bool rt_lock_memory(void) {
+    // MCL_FUTURE makes later allocations fail once the memlock limit is
+    // reached, so it is only requested when there is no limit.
+    int flags = MCL_CURRENT;
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur == RLIM_INFINITY) {
+        flags |= MCL_FUTURE;
+    }
+    bool ok = mlockall(flags) == 0;
+    atomic_store(&lock_buffers, true);
+    return ok;
+}
+
+void *rt_alloc_buffer(size_t bytes) {
+    if (bytes == 0) bytes = 1;
+    void *data = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return data == MAP_FAILED ? NULL : data;
+}
+
+void rt_free_buffer(void *data, size_t bytes) {
+    if (data) munmap(data, bytes ? bytes : 1);
+}
+
+void rt_lock_buffer(const void *data, size_t bytes) {
+    if (!data || bytes == 0) return;
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0) page = 4096;
+    const volatile unsigned char *p = (const volatile unsigned char *)data;
+    for (size_t offset = 0; offset < bytes; offset += (size_t)page) {
+        (void)p[offset];
+    }
+    (void)p[bytes - 1];
+    if (atomic_load(&lock_buffers) && mlock(data, bytes) != 0) {
+        static atomic_bool warned;
+        if (!atomic_exchange(&warned, true)) {
+            fprintf(stderr, "Warning: could not lock sample memory (raise the memlock limit)\n");
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef MUSIKA_RT_H
+#define MUSIKA_RT_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Opt-in real-time mode for the audio thread. Every step is best effort:
+// without the privileges for one of them Musika warns and keeps going.
+typedef struct {
+    bool enabled;
+    int priority;     // SCHED_FIFO priority of the audio thread (1..99)
+    int cpu;          // CPU to pin the audio thread to, or -1 to leave it
+    bool lock_memory; // mlockall and lock every decoded sample
+} RealtimeConfig;
+
+RealtimeConfig rt_config_default(void);
+// Applies SCHED_FIFO at priority and, when cpu >= 0, pins thread to cpu.
+// Returns false if the scheduling policy was refused.
+bool rt_promote_thread(pthread_t thread, int priority, int cpu);
+// Sets flush-to-zero and denormals-are-zero on the calling thread, so decaying
+// filters and reverb tails never drop into slow denormal arithmetic.
+void rt_flush_denormals(void);
+// Locks the process's current pages (and future ones when the memlock limit
+// allows) and makes rt_lock_buffer lock sample buffers from now on.
+bool rt_lock_memory(void);
+// Faults in every page of a freshly decoded buffer and, after rt_lock_memory,
+// locks it so the callback never page-faults on a sample it has not played
+// for a while. mlock does not nest and outlives free(), so only lock memory
+// that is unmapped when it is released: rt_alloc_buffer buffers or file
+// mappings.
+void rt_lock_buffer(const void *data, size_t bytes);
+// Page-aligned anonymous mapping for a buffer that may be locked; NULL on
+// failure. rt_free_buffer unmaps it, taking any lock with it.
+void *rt_alloc_buffer(size_t bytes);
+void rt_free_buffer(void *data, size_t bytes);
+
+#endif // MUSIKA_RT_H
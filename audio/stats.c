@@ -0,0 +1,120 @@
+#include "stats.h"
+
+#include <string.h>
+
+void audio_stats_reset(AudioStats *stats) {
+    atomic_store(&stats->periods, 0);
+    atomic_store(&stats->callback_ns_total, 0);
+    atomic_store(&stats->callback_ns_min, UINT64_MAX);
+    atomic_store(&stats->callback_ns_max, 0);
+    atomic_store(&stats->deadline_ns, 0);
+    for (int i = 0; i < AUDIO_STATS_LOAD_BUCKETS; ++i) {
+        atomic_store(&stats->load_histogram[i], 0);
+    }
+    atomic_store(&stats->voices_active, 0);
+    atomic_store(&stats->voices_peak, 0);
+    atomic_store(&stats->voices_stolen, 0);
+    atomic_store(&stats->voices_dropped, 0);
+    atomic_store(&stats->events_late, 0);
+    atomic_store(&stats->xruns, 0);
+    atomic_store(&stats->limited_periods, 0);
+    atomic_store(&stats->samples_sanitized, 0);
+    atomic_store(&stats->events_rejected, 0);
+}
+
+// Single writer, so plain load/store pairs are enough for min and max.
+void audio_stats_record_period(AudioStats *stats, uint64_t elapsed_ns, uint64_t deadline_ns) {
+    audio_stats_add(&stats->periods, 1);
+    audio_stats_add(&stats->callback_ns_total, elapsed_ns);
+    if (elapsed_ns < atomic_load_explicit(&stats->callback_ns_min, memory_order_relaxed)) {
+        atomic_store_explicit(&stats->callback_ns_min, elapsed_ns, memory_order_relaxed);
+    }
+    if (elapsed_ns > atomic_load_explicit(&stats->callback_ns_max, memory_order_relaxed)) {
+        atomic_store_explicit(&stats->callback_ns_max, elapsed_ns, memory_order_relaxed);
+    }
+    atomic_store_explicit(&stats->deadline_ns, deadline_ns, memory_order_relaxed);
+    uint64_t bucket = deadline_ns > 0 ? elapsed_ns * 100 / deadline_ns : AUDIO_STATS_LOAD_MAX;
+    if (bucket > AUDIO_STATS_LOAD_MAX) bucket = AUDIO_STATS_LOAD_MAX;
+    audio_stats_add(&stats->load_histogram[bucket], 1);
+}
+
+void audio_stats_record_voices(AudioStats *stats, uint32_t active) {
+    atomic_store_explicit(&stats->voices_active, active, memory_order_relaxed);
+    if (active > atomic_load_explicit(&stats->voices_peak, memory_order_relaxed)) {
+        atomic_store_explicit(&stats->voices_peak, active, memory_order_relaxed);
+    }
+}
+
+void audio_stats_snapshot(const AudioStats *stats, AudioStatsSnapshot *out) {
+    memset(out, 0, sizeof(*out));
+    out->periods = atomic_load_explicit(&stats->periods, memory_order_relaxed);
+    out->callback_ns_total = atomic_load_explicit(&stats->callback_ns_total, memory_order_relaxed);
+    out->callback_ns_min = atomic_load_explicit(&stats->callback_ns_min, memory_order_relaxed);
+    out->callback_ns_max = atomic_load_explicit(&stats->callback_ns_max, memory_order_relaxed);
+    out->deadline_ns = atomic_load_explicit(&stats->deadline_ns, memory_order_relaxed);
+    for (int i = 0; i < AUDIO_STATS_LOAD_BUCKETS; ++i) {
+        out->load_histogram[i] = atomic_load_explicit(&stats->load_histogram[i], memory_order_relaxed);
+    }
+    out->voices_active = atomic_load_explicit(&stats->voices_active, memory_order_relaxed);
+    out->voices_peak = atomic_load_explicit(&stats->voices_peak, memory_order_relaxed);
+    out->voices_stolen = atomic_load_explicit(&stats->voices_stolen, memory_order_relaxed);
+    out->voices_dropped = atomic_load_explicit(&stats->voices_dropped, memory_order_relaxed);
+    out->events_late = atomic_load_explicit(&stats->events_late, memory_order_relaxed);
+    out->xruns = atomic_load_explicit(&stats->xruns, memory_order_relaxed);
+    out->limited_periods = atomic_load_explicit(&stats->limited_periods, memory_order_relaxed);
+    out->samples_sanitized = atomic_load_explicit(&stats->samples_sanitized, memory_order_relaxed);
+    out->events_rejected = atomic_load_explicit(&stats->events_rejected, memory_order_relaxed);
+}
+
+void audio_stats_delta(const AudioStatsSnapshot *now, const AudioStatsSnapshot *before, AudioStatsSnapshot *out) {
+    *out = *now;
+    out->periods = now->periods - before->periods;
+    out->callback_ns_total = now->callback_ns_total - before->callback_ns_total;
+    for (int i = 0; i < AUDIO_STATS_LOAD_BUCKETS; ++i) {
+        out->load_histogram[i] = now->load_histogram[i] - before->load_histogram[i];
+    }
+    out->voices_stolen = now->voices_stolen - before->voices_stolen;
+    out->voices_dropped = now->voices_dropped - before->voices_dropped;
+    out->events_late = now->events_late - before->events_late;
+    out->xruns = now->xruns - before->xruns;
+    out->limited_periods = now->limited_periods - before->limited_periods;
+    out->samples_sanitized = now->samples_sanitized - before->samples_sanitized;
+    out->events_rejected = now->events_rejected - before->events_rejected;
+}
+
+// Smallest load bucket (percent of deadline) holding the 99th percentile.
+static int load_p99(const AudioStatsSnapshot *snap) {
+    uint64_t target = snap->periods - snap->periods / 100;
+    uint64_t seen = 0;
+    for (int i = 0; i < AUDIO_STATS_LOAD_BUCKETS; ++i) {
+        seen += snap->load_histogram[i];
+        if (seen >= target) return i;
+    }
+    return AUDIO_STATS_LOAD_MAX;
+}
+
+void audio_stats_print(const AudioStatsSnapshot *snap, FILE *out) {
+    if (snap->periods == 0) {
+        fprintf(out, "Callback      : no periods rendered yet\n");
+    } else {
+        double deadline_ms = (double)snap->deadline_ns * 1e-6;
+        double avg_ms = (double)snap->callback_ns_total / (double)snap->periods * 1e-6;
+        double min_ms = (double)snap->callback_ns_min * 1e-6;
+        double max_ms = (double)snap->callback_ns_max * 1e-6;
+        int p99 = load_p99(snap);
+        double pct = deadline_ms > 0.0 ? 100.0 / deadline_ms : 0.0;
+        fprintf(out, "Callback      : %llu periods of %.2f ms\n", (unsigned long long)snap->periods, deadline_ms);
+        fprintf(out, "  time        : min %.3f  avg %.3f  p99 %s%.3f  max %.3f ms\n",
+                min_ms, avg_ms, p99 >= AUDIO_STATS_LOAD_MAX ? ">" : "", (double)p99 * deadline_ms / 100.0, max_ms);
+        fprintf(out, "  load        : min %.0f%%  avg %.0f%%  p99 %s%d%%  max %.0f%% of deadline\n",
+                min_ms * pct, avg_ms * pct, p99 >= AUDIO_STATS_LOAD_MAX ? ">" : "", p99, max_ms * pct);
+    }
+    fprintf(out, "Voices        : %u active, peak %u of %u; %llu stolen, %llu dropped\n",
+            snap->voices_active, snap->voices_peak, snap->voice_capacity,
+            (unsigned long long)snap->voices_stolen, (unsigned long long)snap->voices_dropped);
+    fprintf(out, "Events        : %llu late, %llu refused by a full queue\n",
+            (unsigned long long)snap->events_late, (unsigned long long)snap->events_rejected);
+    fprintf(out, "Master        : limiting in %llu periods, %llu bad samples silenced\n",
+            (unsigned long long)snap->limited_periods, (unsigned long long)snap->samples_sanitized);
+    fprintf(out, "Device        : %llu underruns\n", (unsigned long long)snap->xruns);
+}
@@ -0,0 +1,73 @@
+#ifndef MUSIKA_STATS_H
+#define MUSIKA_STATS_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Callback load histogram: one bucket per percent of the period deadline,
+// the last bucket collects everything at or above AUDIO_STATS_LOAD_MAX %.
+enum { AUDIO_STATS_LOAD_MAX = 200 };
+enum { AUDIO_STATS_LOAD_BUCKETS = AUDIO_STATS_LOAD_MAX + 1 };
+
+// Engine counters shared between threads without locks. Each field has a
+// single writer (noted below) using relaxed atomics; readers take a snapshot
+// that is consistent per field, not across fields. The field the transport
+// writes sits on its own cache line so it never contends with the callback.
+typedef struct {
+    // Audio thread.
+    _Atomic uint64_t periods;
+    _Atomic uint64_t callback_ns_total;
+    _Atomic uint64_t callback_ns_min;
+    _Atomic uint64_t callback_ns_max;
+    _Atomic uint64_t deadline_ns; // length of the last period
+    _Atomic uint64_t load_histogram[AUDIO_STATS_LOAD_BUCKETS];
+    _Atomic uint32_t voices_active;
+    _Atomic uint32_t voices_peak;
+    _Atomic uint64_t voices_stolen;
+    _Atomic uint64_t voices_dropped; // no voice could be freed for an event
+    _Atomic uint64_t events_late;    // started after their start_frame had passed
+    _Atomic uint64_t xruns;          // device underruns reported by the backend
+    _Atomic uint64_t limited_periods;   // periods where the master limiter reduced gain
+    _Atomic uint64_t samples_sanitized; // NaN/Inf output samples replaced with silence
+
+    // Transport (producer) thread.
+    _Alignas(64) _Atomic uint64_t events_rejected; // pushes refused by a full ring
+} AudioStats;
+
+// Plain copy of the counters; deltas between two snapshots describe the
+// interval between them.
+typedef struct {
+    uint64_t periods;
+    uint64_t callback_ns_total;
+    uint64_t callback_ns_min;
+    uint64_t callback_ns_max;
+    uint64_t deadline_ns;
+    uint64_t load_histogram[AUDIO_STATS_LOAD_BUCKETS];
+    uint32_t voices_active;
+    uint32_t voices_peak;
+    uint32_t voice_capacity;
+    uint64_t voices_stolen;
+    uint64_t voices_dropped;
+    uint64_t events_late;
+    uint64_t xruns;
+    uint64_t limited_periods;
+    uint64_t samples_sanitized;
+    uint64_t events_rejected;
+} AudioStatsSnapshot;
+
+void audio_stats_reset(AudioStats *stats);
+// Records one callback that took elapsed_ns to render a deadline_ns period.
+void audio_stats_record_period(AudioStats *stats, uint64_t elapsed_ns, uint64_t deadline_ns);
+void audio_stats_record_voices(AudioStats *stats, uint32_t active);
+void audio_stats_snapshot(const AudioStats *stats, AudioStatsSnapshot *out);
+// Counters and histogram of now minus before. Min/max are not subtractable,
+// so the delta keeps now's values for those.
+void audio_stats_delta(const AudioStatsSnapshot *now, const AudioStatsSnapshot *before, AudioStatsSnapshot *out);
+void audio_stats_print(const AudioStatsSnapshot *snap, FILE *out);
+
+static inline void audio_stats_add(_Atomic uint64_t *counter, uint64_t n) {
+    atomic_fetch_add_explicit(counter, n, memory_order_relaxed);
+}
+
+#endif // MUSIKA_STATS_H
@@ -0,0 +1,171 @@
+#include "synth.h"
+
+#include <ctype.h>
+#include <stddef.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static const float SYNTH_OUTPUT_LEVEL = 0.35f;
+
+SynthParams synth_params_init(SynthWaveform waveform) {
+    SynthParams params;
+    params.waveform = waveform;
+    params.attack = 0.005f;
+    params.decay = 0.1f;
+    params.sustain = 0.7f;
+    params.release = 0.1f;
+    return params;
+}
+
+static bool equals_ci(const char *a, const char *b) {
+    while (*a && *b) {
+        if (tolower((unsigned char)*a) != tolower((unsigned char)*b)) return false;
+        ++a;
+        ++b;
+    }
+    return *a == '\0' && *b == '\0';
+}
+
+bool synth_waveform_from_name(const char *name, SynthWaveform *out_waveform) {
+    if (!name || !out_waveform) return false;
+    if (equals_ci(name, "saw") || equals_ci(name, "sawtooth")) {
+        *out_waveform = SYNTH_SAW;
+    } else if (equals_ci(name, "square")) {
+        *out_waveform = SYNTH_SQUARE;
+    } else if (equals_ci(name, "triangle") || equals_ci(name, "tri")) {
+        *out_waveform = SYNTH_TRIANGLE;
+    } else if (equals_ci(name, "sine")) {
+        *out_waveform = SYNTH_SINE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool synth_params_equal(const SynthParams *a, const SynthParams *b) {
+    return a->waveform == b->waveform &&
+           a->attack == b->attack &&
+           a->decay == b->decay &&
+           a->sustain == b->sustain &&
+           a->release == b->release;
+}
+
+static float seconds_to_frames(float seconds, uint32_t sample_rate) {
+    float frames = seconds * (float)sample_rate;
+    return frames >= 1.0f ? frames : 1.0f;
+}
+
+void synth_voice_start(SynthVoice *voice, const SynthParams *params, double frequency, uint32_t sample_rate) {
+    double inc = frequency / (double)sample_rate;
+    if (inc < 0.0) inc = 0.0;
+    if (inc > 0.45) inc = 0.45;
+
+    voice->waveform = params->waveform;
+    voice->phase = 0.0;
+    voice->phase_inc = inc;
+    voice->triangle = -1.0f;
+
+    float sustain = params->sustain;
+    if (sustain < 0.0f) sustain = 0.0f;
+    if (sustain > 1.0f) sustain = 1.0f;
+    voice->env_stage = SYNTH_ENV_ATTACK;
+    voice->env_level = 0.0f;
+    voice->attack_step = 1.0f / seconds_to_frames(params->attack, sample_rate);
+    voice->decay_step = (1.0f - sustain) / seconds_to_frames(params->decay, sample_rate);
+    voice->sustain = sustain;
+    voice->release_frames = seconds_to_frames(params->release, sample_rate);
+    voice->release_step = 0.0f;
+}
+
+void synth_voice_release(SynthVoice *voice) {
+    if (voice->env_stage == SYNTH_ENV_IDLE || voice->env_stage == SYNTH_ENV_RELEASE) return;
+    voice->env_stage = SYNTH_ENV_RELEASE;
+    voice->release_step = voice->env_level / voice->release_frames;
+}
+
+bool synth_voice_active(const SynthVoice *voice) {
+    return voice->env_stage != SYNTH_ENV_IDLE;
+}
+
+// Residual that removes the step discontinuity of a naive waveform at t = 0.
+static inline float poly_blep(double t, double dt) {
+    if (t < dt) {
+        t /= dt;
+        return (float)(t + t - t * t - 1.0);
+    }
+    if (t > 1.0 - dt) {
+        t = (t - 1.0) / dt;
+        return (float)(t * t + t + t + 1.0);
+    }
+    return 0.0f;
+}
+
+static inline float square_sample(double phase, double dt) {
+    float value = phase < 0.5 ? 1.0f : -1.0f;
+    double shifted = phase + 0.5;
+    if (shifted >= 1.0) shifted -= 1.0;
+    return value + poly_blep(phase, dt) - poly_blep(shifted, dt);
+}
+
+static inline float envelope_next(SynthVoice *voice) {
+    switch (voice->env_stage) {
+        case SYNTH_ENV_ATTACK:
+            voice->env_level += voice->attack_step;
+            if (voice->env_level >= 1.0f) {
+                voice->env_level = 1.0f;
+                voice->env_stage = SYNTH_ENV_DECAY;
+            }
+            break;
+        case SYNTH_ENV_DECAY:
+            voice->env_level -= voice->decay_step;
+            if (voice->env_level <= voice->sustain) {
+                voice->env_level = voice->sustain;
+                voice->env_stage = SYNTH_ENV_SUSTAIN;
+            }
+            break;
+        case SYNTH_ENV_RELEASE:
+            voice->env_level -= voice->release_step;
+            if (voice->env_level <= 0.0f) {
+                voice->env_level = 0.0f;
+                voice->env_stage = SYNTH_ENV_IDLE;
+            }
+            break;
+        case SYNTH_ENV_SUSTAIN:
+        case SYNTH_ENV_IDLE:
+        default:
+            break;
+    }
+    return voice->env_level;
+}
+
+void synth_voice_render(SynthVoice *voice, float *dst, uint32_t frames) {
+    const double dt = voice->phase_inc;
+    double phase = voice->phase;
+    for (uint32_t i = 0; i < frames; ++i) {
+        float osc;
+        switch (voice->waveform) {
+            case SYNTH_SQUARE:
+                osc = square_sample(phase, dt);
+                break;
+            case SYNTH_TRIANGLE:
+                // Integrating the band-limited square keeps the corners soft.
+                voice->triangle = (float)(4.0 * dt) * square_sample(phase, dt) + (1.0f - (float)dt) * voice->triangle;
+                osc = voice->triangle;
+                break;
+            case SYNTH_SINE:
+                osc = (float)sin(2.0 * M_PI * phase);
+                break;
+            case SYNTH_SAW:
+            default:
+                osc = (float)(2.0 * phase - 1.0) - poly_blep(phase, dt);
+                break;
+        }
+        phase += dt;
+        if (phase >= 1.0) phase -= 1.0;
+
+        dst[i] = osc * envelope_next(voice) * SYNTH_OUTPUT_LEVEL;
+    }
+    voice->phase = phase;
+}
@@ -0,0 +1,64 @@
+#ifndef MUSIKA_SYNTH_H
+#define MUSIKA_SYNTH_H
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    SYNTH_SAW = 0,
+    SYNTH_SQUARE,
+    SYNTH_TRIANGLE,
+    SYNTH_SINE,
+} SynthWaveform;
+
+// Patch settings carried by each synth event. Times are in seconds.
+typedef struct {
+    SynthWaveform waveform;
+    float attack;
+    float decay;
+    float sustain; // level 0..1
+    float release;
+} SynthParams;
+
+typedef enum {
+    SYNTH_ENV_IDLE = 0,
+    SYNTH_ENV_ATTACK,
+    SYNTH_ENV_DECAY,
+    SYNTH_ENV_SUSTAIN,
+    SYNTH_ENV_RELEASE,
+} SynthEnvStage;
+
+// Running state of one synth voice: oscillator and ADSR. Filtering is done
+// by the engine's per-voice filter bank, shared with sample voices.
+typedef struct {
+    SynthWaveform waveform;
+    double phase;     // 0..1
+    double phase_inc; // cycles per frame
+    float triangle;   // leaky integrator turning the square into a triangle
+
+    SynthEnvStage env_stage;
+    float env_level;
+    float attack_step;
+    float decay_step;
+    float sustain;
+    float release_frames;
+    float release_step;
+} SynthVoice;
+
+SynthParams synth_params_init(SynthWaveform waveform);
+bool synth_waveform_from_name(const char *name, SynthWaveform *out_waveform);
+bool synth_params_equal(const SynthParams *a, const SynthParams *b);
+
+void synth_voice_start(SynthVoice *voice, const SynthParams *params, double frequency, uint32_t sample_rate);
+// Moves the envelope into its release stage from whatever level it reached.
+void synth_voice_release(SynthVoice *voice);
+bool synth_voice_active(const SynthVoice *voice);
+// Writes frames mono samples (oscillator times envelope) to dst.
+void synth_voice_render(SynthVoice *voice, float *dst, uint32_t frames);
+
+static inline double synth_frequency_from_midi(int midi_note) {
+    return 440.0 * pow(2.0, ((double)midi_note - 69.0) / 12.0);
+}
+
+#endif // MUSIKA_SYNTH_H
@@ -0,0 +1,152 @@
+#include "wav.h"
+
+#include <math.h>
+#include <string.h>
+
+enum { WAV_CONVERT_SAMPLES = 4096 };
+
+static uint32_t bytes_per_sample(WavFormat format) {
+    switch (format) {
+        case WAV_PCM24: return 3;
+        case WAV_FLOAT32: return 4;
+        case WAV_PCM16:
+        default: return 2;
+    }
+}
+
+static void put_le16(unsigned char *p, uint16_t v) {
+    p[0] = (unsigned char)(v & 0xFF);
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static void put_le32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char)(v & 0xFF);
+    p[1] = (unsigned char)((v >> 8) & 0xFF);
+    p[2] = (unsigned char)((v >> 16) & 0xFF);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+bool wav_format_from_name(const char *name, WavFormat *out_format) {
+    if (!name || !out_format) return false;
+    if (strcmp(name, "16") == 0 || strcmp(name, "pcm16") == 0) {
+        *out_format = WAV_PCM16;
+    } else if (strcmp(name, "24") == 0 || strcmp(name, "pcm24") == 0) {
+        *out_format = WAV_PCM24;
+    } else if (strcmp(name, "float") == 0 || strcmp(name, "f32") == 0 || strcmp(name, "32f") == 0) {
+        *out_format = WAV_FLOAT32;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Builds the RIFF header for data_bytes of audio. Float files carry the
+// extended fmt chunk and a fact chunk as the spec requires.
+static uint32_t build_header(const WavWriter *writer, uint32_t data_bytes, unsigned char *h) {
+    const uint32_t sample_rate = writer->sample_rate;
+    const bool is_float = writer->format == WAV_FLOAT32;
+    const uint32_t sample_bytes = bytes_per_sample(writer->format);
+    const uint32_t fmt_size = is_float ? 18 : 16;
+    const uint32_t header_bytes = 12 + 8 + fmt_size + (is_float ? 12 : 0) + 8;
+    uint32_t p = 0;
+    memcpy(h + p, "RIFF", 4);
+    put_le32(h + p + 4, header_bytes - 8 + data_bytes);
+    memcpy(h + p + 8, "WAVE", 4);
+    p += 12;
+    memcpy(h + p, "fmt ", 4);
+    put_le32(h + p + 4, fmt_size);
+    put_le16(h + p + 8, is_float ? 3 : 1);
+    put_le16(h + p + 10, (uint16_t)writer->channels);
+    put_le32(h + p + 12, sample_rate);
+    put_le32(h + p + 16, sample_rate * writer->channels * sample_bytes);
+    put_le16(h + p + 20, (uint16_t)(writer->channels * sample_bytes));
+    put_le16(h + p + 22, (uint16_t)(sample_bytes * 8));
+    if (is_float) put_le16(h + p + 24, 0);
+    p += 8 + fmt_size;
+    if (is_float) {
+        memcpy(h + p, "fact", 4);
+        put_le32(h + p + 4, 4);
+        put_le32(h + p + 8, data_bytes / (writer->channels * sample_bytes));
+        p += 12;
+    }
+    memcpy(h + p, "data", 4);
+    put_le32(h + p + 4, data_bytes);
+    return header_bytes;
+}
+
+bool wav_writer_open(WavWriter *writer, const char *path, uint32_t sample_rate, uint32_t channels, WavFormat format) {
+    memset(writer, 0, sizeof(*writer));
+    if (!path || channels == 0 || sample_rate == 0) return false;
+    writer->file = fopen(path, "wb");
+    if (!writer->file) return false;
+    writer->sample_rate = sample_rate;
+    writer->channels = channels;
+    writer->format = format;
+    unsigned char header[64];
+    writer->header_bytes = build_header(writer, 0, header);
+    if (fwrite(header, 1, writer->header_bytes, writer->file) != writer->header_bytes) {
+        fclose(writer->file);
+        writer->file = NULL;
+        return false;
+    }
+    return true;
+}
+
+static inline float clamp_unit(float x) {
+    if (!(x > -1.0f)) return x != x ? 0.0f : -1.0f; // NaN becomes silence
+    if (x > 1.0f) return 1.0f;
+    return x;
+}
+
+bool wav_writer_write(WavWriter *writer, const float *data, uint32_t frames) {
+    if (!writer->file || writer->failed) return false;
+    const uint32_t sample_bytes = bytes_per_sample(writer->format);
+    unsigned char buffer[WAV_CONVERT_SAMPLES * 4];
+    size_t total = (size_t)frames * writer->channels;
+    size_t done = 0;
+    while (done < total) {
+        size_t n = total - done;
+        if (n > WAV_CONVERT_SAMPLES) n = WAV_CONVERT_SAMPLES;
+        for (size_t i = 0; i < n; ++i) {
+            float x = data[done + i];
+            unsigned char *p = buffer + i * sample_bytes;
+            if (writer->format == WAV_FLOAT32) {
+                uint32_t bits;
+                memcpy(&bits, &x, sizeof(bits));
+                put_le32(p, bits);
+            } else if (writer->format == WAV_PCM24) {
+                int32_t v = (int32_t)lrintf(clamp_unit(x) * 8388607.0f);
+                p[0] = (unsigned char)(v & 0xFF);
+                p[1] = (unsigned char)((v >> 8) & 0xFF);
+                p[2] = (unsigned char)((v >> 16) & 0xFF);
+            } else {
+                int32_t v = (int32_t)lrintf(clamp_unit(x) * 32767.0f);
+                put_le16(p, (uint16_t)(int16_t)v);
+            }
+        }
+        if (fwrite(buffer, sample_bytes, n, writer->file) != n) {
+            writer->failed = true;
+            return false;
+        }
+        done += n;
+    }
+    writer->frames += frames;
+    return true;
+}
+
+bool wav_writer_close(WavWriter *writer) {
+    if (!writer->file) return false;
+    bool ok = !writer->failed;
+    uint64_t data_bytes = writer->frames * writer->channels * bytes_per_sample(writer->format);
+    if (data_bytes > UINT32_MAX - 64) {
+        ok = false; // too long for a RIFF header
+    } else {
+        unsigned char header[64];
+        build_header(writer, (uint32_t)data_bytes, header);
+        ok = ok && fseek(writer->file, 0, SEEK_SET) == 0 &&
+             fwrite(header, 1, writer->header_bytes, writer->file) == writer->header_bytes;
+    }
+    if (fclose(writer->file) != 0) ok = false;
+    writer->file = NULL;
+    return ok;
+}
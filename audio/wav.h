@@ -0,0 +1,32 @@
+#ifndef MUSIKA_WAV_H
+#define MUSIKA_WAV_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum {
+    WAV_PCM16 = 0,
+    WAV_PCM24,
+    WAV_FLOAT32,
+} WavFormat;
+
+// Streams interleaved float frames to a WAV file. The header is written with
+// placeholder sizes on open and patched on close.
+typedef struct {
+    FILE *file;
+    uint32_t sample_rate;
+    uint32_t channels;
+    WavFormat format;
+    uint64_t frames;
+    uint32_t header_bytes;
+    bool failed;
+} WavWriter;
+
+bool wav_format_from_name(const char *name, WavFormat *out_format);
+bool wav_writer_open(WavWriter *writer, const char *path, uint32_t sample_rate, uint32_t channels, WavFormat format);
+bool wav_writer_write(WavWriter *writer, const float *data, uint32_t frames);
+// Finalises the header and closes the file; returns false if any write failed.
+bool wav_writer_close(WavWriter *writer);
+
+#endif // MUSIKA_WAV_H
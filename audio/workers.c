@@ -0,0 +1,153 @@
+#define _GNU_SOURCE
+#include "workers.h"
+#include "rt.h"
+
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+// Spins before a worker sleeps; long enough to stay awake across the event
+// boundaries of one period, short enough not to burn a core between periods.
+enum { WORKER_SPIN_LIMIT = 1 << 14 };
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static void generation_wait(WorkerPool *pool, uint32_t seen) {
+#ifdef __linux__
+    syscall(SYS_futex, (uint32_t *)&pool->generation, FUTEX_WAIT_PRIVATE, seen, NULL, NULL, 0);
+#else
+    (void)pool;
+    (void)seen;
+    sched_yield();
+#endif
+}
+
+static void generation_wake(WorkerPool *pool) {
+#ifdef __linux__
+    syscall(SYS_futex, (uint32_t *)&pool->generation, FUTEX_WAKE_PRIVATE, (int)pool->count, NULL, NULL, 0);
+#else
+    (void)pool;
+#endif
+}
+
+static void *worker_main(void *arg) {
+    WorkerSlot *slot = (WorkerSlot *)arg;
+    WorkerPool *pool = slot->pool;
+    if (pool->flush_denormals) rt_flush_denormals();
+    // Start from the generation the pool was created with, not the current
+    // one: a job published before this thread first ran must still be seen.
+    uint32_t seen = 0;
+    for (;;) {
+        uint32_t spins = 0;
+        uint32_t generation;
+        while ((generation = atomic_load(&pool->generation)) == seen) {
+            if (++spins < WORKER_SPIN_LIMIT) {
+                cpu_relax();
+                continue;
+            }
+            // The sleeper count is raised before re-checking the generation
+            // inside the futex, so a wake-up can never be missed.
+            atomic_fetch_add(&pool->sleepers, 1);
+            generation_wait(pool, seen);
+            atomic_fetch_sub(&pool->sleepers, 1);
+            spins = 0;
+        }
+        seen = generation;
+        if (atomic_load(&pool->quit)) break;
+        pool->job(pool->context, slot->part);
+        atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_release);
+    }
+    return NULL;
+}
+
+static void worker_configure(pthread_t thread, uint32_t index, const RealtimeConfig *realtime) {
+#ifdef __linux__
+    uint32_t cpus = worker_pool_cpu_count();
+    int reserved = realtime ? realtime->cpu : -1;
+    if (cpus > 1) {
+        // Helper i takes the (i + 1)th CPU, stepping over the one the audio
+        // thread is pinned to.
+        uint32_t cpu = 0;
+        for (uint32_t n = 0; n <= index; ++n) {
+            do {
+                cpu = (cpu + 1) % cpus;
+            } while ((int)cpu == reserved);
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET((int)cpu, &set);
+        pthread_setaffinity_np(thread, sizeof(set), &set);
+    }
+#endif
+    // The audio thread spins until every helper is done, so helpers must
+    // not run below it. Without the privileges they keep the default
+    // policy, and so does the audio thread.
+    if (realtime) rt_promote_thread(thread, realtime->priority, -1);
+}
+
+bool worker_pool_init(WorkerPool *pool, uint32_t count, const RealtimeConfig *realtime) {
+    memset(pool, 0, sizeof(*pool));
+    pool->flush_denormals = realtime != NULL;
+    atomic_store(&pool->generation, 0);
+    atomic_store(&pool->pending, 0);
+    atomic_store(&pool->sleepers, 0);
+    atomic_store(&pool->quit, false);
+    if (count > WORKER_POOL_MAX) count = WORKER_POOL_MAX;
+    for (uint32_t i = 0; i < count; ++i) {
+        pool->slots[i].pool = pool;
+        pool->slots[i].part = i + 1;
+        if (pthread_create(&pool->threads[i], NULL, worker_main, &pool->slots[i]) != 0) {
+            fprintf(stderr, "Warning: started only %u of %u render threads\n", i, count);
+            break;
+        }
+        worker_configure(pool->threads[i], i, realtime);
+        pool->count = i + 1;
+    }
+    return pool->count == count;
+}
+
+void worker_pool_shutdown(WorkerPool *pool) {
+    if (pool->count == 0) return;
+    atomic_store(&pool->quit, true);
+    atomic_fetch_add(&pool->generation, 1);
+    generation_wake(pool);
+    for (uint32_t i = 0; i < pool->count; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pool->count = 0;
+}
+
+uint32_t worker_pool_cpu_count(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (uint32_t)cpus : 1;
+}
+
+void worker_pool_run(WorkerPool *pool, WorkerJob job, void *context) {
+    if (pool->count == 0) {
+        job(context, 0);
+        return;
+    }
+    pool->job = job;
+    pool->context = context;
+    atomic_store(&pool->pending, pool->count);
+    atomic_fetch_add(&pool->generation, 1);
+    if (atomic_load(&pool->sleepers) > 0) {
+        generation_wake(pool);
+    }
+    job(context, 0);
+    while (atomic_load_explicit(&pool->pending, memory_order_acquire) > 0) {
+        cpu_relax();
+    }
+}
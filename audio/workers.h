@@ -0,0 +1,51 @@
+#ifndef MUSIKA_WORKERS_H
+#define MUSIKA_WORKERS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rt.h"
+
+enum { WORKER_POOL_MAX = 15 };
+
+// Runs part `part` of a job; part 0 always runs on the calling thread.
+typedef void (*WorkerJob)(void *context, uint32_t part);
+
+typedef struct WorkerPool WorkerPool;
+
+typedef struct {
+    WorkerPool *pool;
+    uint32_t part;
+} WorkerSlot;
+
+// Helper threads for the audio callback. A job is published by bumping
+// `generation`; workers spin on it briefly and then sleep on it (futex on
+// Linux), and completion is counted down in `pending`. The callback never
+// takes a lock.
+struct WorkerPool {
+    pthread_t threads[WORKER_POOL_MAX];
+    WorkerSlot slots[WORKER_POOL_MAX];
+    uint32_t count;
+    _Atomic uint32_t generation;
+    _Atomic uint32_t pending;
+    _Atomic uint32_t sleepers;
+    _Atomic bool quit;
+    bool flush_denormals;
+    WorkerJob job;
+    void *context;
+};
+
+// Starts count helper threads (0 leaves the pool empty), pinning helper i
+// to CPU i + 1. realtime is NULL unless the engine runs in real-time mode;
+// then helpers skip realtime->cpu, take the audio thread's SCHED_FIFO
+// priority when allowed and run with FTZ/DAZ set, like the audio thread.
+bool worker_pool_init(WorkerPool *pool, uint32_t count, const RealtimeConfig *realtime);
+void worker_pool_shutdown(WorkerPool *pool);
+uint32_t worker_pool_cpu_count(void);
+// Runs job parts 0..count on the pool and the caller and returns when all
+// of them are done.
+void worker_pool_run(WorkerPool *pool, WorkerJob job, void *context);
+
+#endif // MUSIKA_WORKERS_H
@@ -1,6 +1,7 @@
 #include "cache.h"
 
 #include <errno.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -48,12 +49,20 @@ bool cache_path_for_key(const char *key, char *out_path, size_t out_len) {
     return cache_path_for_key_with_ext(key, ".json", out_path, out_len);
 }
 
+// Writes to a temporary file and renames it into place, so a concurrent
+// reader (another loader thread or process) never sees a partial file.
 bool cache_write(const char *path, const char *data, size_t len) {
+    static _Atomic unsigned long counter;
     if (!path || !data || len == 0) return false;
-    FILE *f = fopen(path, "wb");
+    char tmp[1024];
+    unsigned long n = atomic_fetch_add(&counter, 1);
+    if (snprintf(tmp, sizeof(tmp), "%s.%ld.%lu.tmp", path, (long)getpid(), n) >= (int)sizeof(tmp)) return false;
+    FILE *f = fopen(tmp, "wb");
     if (!f) return false;
     size_t written = fwrite(data, 1, len, f);
-    fclose(f);
-    return written == len;
+    bool ok = fclose(f) == 0 && written == len;
+    if (ok && rename(tmp, path) != 0) ok = false;
+    if (!ok) remove(tmp);
+    return ok;
 }
 
@@ -44,21 +44,73 @@ static void append_repo(MusikaConfig *config, const char *start, size_t len) {
     config->sample_repo_count += 1;
 }
 
+static void append_default_repos(MusikaConfig *config) {
+    append_repo(config, "https://github.com/tyleretters/strudel-samples", strlen("https://github.com/tyleretters/strudel-samples"));
+    append_repo(config, "https://github.com/tidalcycles/Dirt-Samples", strlen("https://github.com/tidalcycles/Dirt-Samples"));
+    append_repo(config, "https://github.com/lukaprincic/strudel-sample-pack", strlen("https://github.com/lukaprincic/strudel-sample-pack"));
+}
+
 static void set_defaults(MusikaConfig *config) {
     config->audio_backend = strdup_safe("miniaudio");
     config->tempo_bpm = 120.0;
+    config->resampler = strdup_safe("cubic");
+    config->voices = 64;
+    config->voice_steal = strdup_safe("oldest");
+    config->period_size = 256;
+    config->periods = 3;
+    config->latency_ms = 0.0;
+    config->realtime = false;
+    config->realtime_priority = 70;
+    config->audio_cpu = -1;
+    config->lock_memory = true;
+    config->master_ceiling = -1.0;
+    config->bus_outputs = 0;
+    config->loader_threads = 4;
+    config->sample_load_timeout = 2.0;
+    config->sample_memory_mb = 1024;
+    config->sample_store = true;
+    config->sample_format = strdup_safe("float");
+    config->render_threads = 1;
+    config->event_queue = 1024;
+    config->delay_beats = 0.75;
+    config->delay_feedback = 0.45;
+    config->reverb_decay = 2.5;
     config->sample_repo_count = 0;
     config->sample_repos = NULL;
-    append_repo(config, "https://github.com/tyleretters/strudel-samples", strlen("https://github.com/tyleretters/strudel-samples"));
-    append_repo(config, "https://github.com/tidalcycles/Dirt-Samples", strlen("https://github.com/tidalcycles/Dirt-Samples"));
-    append_repo(config, "https://github.com/lukaprincic/strudel-sample-pack", strlen("https://github.com/lukaprincic/strudel-sample-pack"));
+    append_default_repos(config);
 }
 
 static void reset_config(MusikaConfig *config) {
     config->audio_backend = NULL;
+    config->audio_file = NULL;
+    config->audio_device = NULL;
+    config->period_size = 256;
+    config->periods = 3;
+    config->latency_ms = 0.0;
+    config->realtime = false;
+    config->realtime_priority = 70;
+    config->audio_cpu = -1;
+    config->lock_memory = true;
+    config->master_ceiling = -1.0;
+    config->bus_outputs = 0;
+    config->loader_threads = 4;
+    config->sample_load_timeout = 2.0;
+    config->sample_memory_mb = 1024;
+    config->sample_store = true;
+    config->sample_format = NULL;
+    config->bank_sample_formats = NULL;
     config->sample_repos = NULL;
     config->sample_repo_count = 0;
     config->tempo_bpm = 120.0;
+    config->resampler = NULL;
+    config->voices = 64;
+    config->voice_steal = NULL;
+    config->delay_beats = 0.75;
+    config->delay_feedback = 0.45;
+    config->reverb_decay = 2.5;
+    config->reverb_impulse = NULL;
+    config->render_threads = 1;
+    config->event_queue = 1024;
 }
 
 static char *load_file(const char *path, size_t *out_len) {
@@ -93,8 +145,7 @@ static const char *skip_ws(const char *p) {
     return p;
 }
 
-static int parse_audio_backend(const char *json, MusikaConfig *config) {
-    const char *key = "\"audioBackend\"";
+static int parse_string_value(const char *json, const char *key, char **out_value) {
     const char *pos = strstr(json, key);
     if (!pos) return 0;
     pos = strchr(pos, ':');
@@ -104,13 +155,28 @@ static int parse_audio_backend(const char *json, MusikaConfig *config) {
     const char *value_start = pos + 1;
     const char *value_end = strchr(value_start, '"');
     if (!value_end) return 0;
-    free(config->audio_backend);
-    config->audio_backend = strdup_range(value_start, (size_t)(value_end - value_start));
+    free(*out_value);
+    *out_value = strdup_range(value_start, (size_t)(value_end - value_start));
     return 1;
 }
 
-static int parse_tempo(const char *json, MusikaConfig *config) {
-    const char *key = "\"tempo\"";
+static int parse_audio_backend(const char *json, MusikaConfig *config) {
+    return parse_string_value(json, "\"audioBackend\"", &config->audio_backend);
+}
+
+static int parse_audio_file(const char *json, MusikaConfig *config) {
+    return parse_string_value(json, "\"audioFile\"", &config->audio_file);
+}
+
+static int parse_audio_device(const char *json, MusikaConfig *config) {
+    return parse_string_value(json, "\"audioDevice\"", &config->audio_device);
+}
+
+static int parse_resampler(const char *json, MusikaConfig *config) {
+    return parse_string_value(json, "\"resampler\"", &config->resampler);
+}
+
+static int parse_number_value(const char *json, const char *key, double *out_value) {
     const char *pos = strstr(json, key);
     if (!pos) return 0;
     pos = strchr(pos, ':');
@@ -118,14 +184,217 @@ static int parse_tempo(const char *json, MusikaConfig *config) {
     pos = skip_ws(pos + 1);
     if (!pos) return 0;
     char *endptr = NULL;
-    double tempo = strtod(pos, &endptr);
+    double value = strtod(pos, &endptr);
     if (pos == endptr) return 0;
+    *out_value = value;
+    return 1;
+}
+
+static int parse_bool_value(const char *json, const char *key, bool *out_value) {
+    const char *pos = strstr(json, key);
+    if (!pos) return 0;
+    pos = strchr(pos, ':');
+    if (!pos) return 0;
+    pos = skip_ws(pos + 1);
+    if (!pos) return 0;
+    if (strncmp(pos, "true", 4) == 0) {
+        *out_value = true;
+    } else if (strncmp(pos, "false", 5) == 0) {
+        *out_value = false;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+static int parse_tempo(const char *json, MusikaConfig *config) {
+    double tempo = 0.0;
+    if (!parse_number_value(json, "\"tempo\"", &tempo)) return 0;
     if (tempo > 0.0) {
         config->tempo_bpm = tempo;
     }
     return 1;
 }
 
+static int parse_voices(const char *json, MusikaConfig *config) {
+    double voices = 0.0;
+    if (!parse_number_value(json, "\"voices\"", &voices)) return 0;
+    if (voices >= 1.0 && voices <= 4096.0) {
+        config->voices = (int)voices;
+    } else {
+        fprintf(stderr, "Warning: voices must be between 1 and 4096 (using %d)\n", config->voices);
+    }
+    return 1;
+}
+
+static int parse_voice_steal(const char *json, MusikaConfig *config) {
+    return parse_string_value(json, "\"voiceSteal\"", &config->voice_steal);
+}
+
+// Device buffer geometry: "periodSize" frames per period, "periods" per
+// buffer, or a "latencyMs" target that the period size is derived from.
+static int parse_buffer_size(const char *json, MusikaConfig *config) {
+    double value = 0.0;
+    int found = 0;
+    if (parse_number_value(json, "\"periodSize\"", &value)) {
+        found = 1;
+        if (value >= 16.0 && value <= 8192.0) {
+            config->period_size = (int)value;
+        } else {
+            fprintf(stderr, "Warning: periodSize must be between 16 and 8192 frames (using %d)\n", config->period_size);
+        }
+    }
+    if (parse_number_value(json, "\"periods\"", &value)) {
+        found = 1;
+        if (value >= 2.0 && value <= 16.0) {
+            config->periods = (int)value;
+        } else {
+            fprintf(stderr, "Warning: periods must be between 2 and 16 (using %d)\n", config->periods);
+        }
+    }
+    if (parse_number_value(json, "\"latencyMs\"", &value)) {
+        found = 1;
+        if (value >= 1.0 && value <= 1000.0) {
+            config->latency_ms = value;
+        } else {
+            fprintf(stderr, "Warning: latencyMs must be between 1 and 1000 (ignored)\n");
+        }
+    }
+    return found;
+}
+
+static int parse_realtime(const char *json, MusikaConfig *config) {
+    int found = parse_bool_value(json, "\"realtime\"", &config->realtime);
+    found |= parse_bool_value(json, "\"lockMemory\"", &config->lock_memory);
+    double value = 0.0;
+    if (parse_number_value(json, "\"realtimePriority\"", &value)) {
+        found = 1;
+        if (value >= 1.0 && value <= 99.0) {
+            config->realtime_priority = (int)value;
+        } else {
+            fprintf(stderr, "Warning: realtimePriority must be between 1 and 99 (using %d)\n", config->realtime_priority);
+        }
+    }
+    if (parse_number_value(json, "\"audioCpu\"", &value)) {
+        found = 1;
+        if (value >= -1.0 && value <= 1023.0) {
+            config->audio_cpu = (int)value;
+        } else {
+            fprintf(stderr, "Warning: audioCpu must be a CPU index or -1 (leaving the audio thread unpinned)\n");
+        }
+    }
+    return found;
+}
+
+static int parse_master_ceiling(const char *json, MusikaConfig *config) {
+    double ceiling = 0.0;
+    if (!parse_number_value(json, "\"masterCeiling\"", &ceiling)) return 0;
+    if (ceiling >= -24.0 && ceiling <= -0.1) {
+        config->master_ceiling = ceiling;
+    } else {
+        fprintf(stderr, "Warning: masterCeiling must be between -24 and -0.1 dB (using %.1f)\n", config->master_ceiling);
+    }
+    return 1;
+}
+
+static int parse_render_threads(const char *json, MusikaConfig *config) {
+    double threads = 0.0;
+    if (!parse_number_value(json, "\"renderThreads\"", &threads)) return 0;
+    if (threads >= 1.0 && threads <= 16.0) {
+        config->render_threads = (int)threads;
+    } else {
+        fprintf(stderr, "Warning: renderThreads must be between 1 and 16 (using %d)\n", config->render_threads);
+    }
+    return 1;
+}
+
+static int parse_event_queue(const char *json, MusikaConfig *config) {
+    double slots = 0.0;
+    if (!parse_number_value(json, "\"eventQueue\"", &slots)) return 0;
+    if (slots >= 64.0 && slots <= 65536.0) {
+        config->event_queue = (int)slots;
+    } else {
+        fprintf(stderr, "Warning: eventQueue must be between 64 and 65536 (using %d)\n", config->event_queue);
+    }
+    return 1;
+}
+
+static int parse_bus_outputs(const char *json, MusikaConfig *config) {
+    double buses = 0.0;
+    if (!parse_number_value(json, "\"busOutputs\"", &buses)) return 0;
+    if (buses >= 0.0 && buses <= 16.0) {
+        config->bus_outputs = (int)buses;
+    } else {
+        fprintf(stderr, "Warning: busOutputs must be between 0 and 16 (using %d)\n", config->bus_outputs);
+    }
+    return 1;
+}
+
+static int parse_sample_loader(const char *json, MusikaConfig *config) {
+    double value = 0.0;
+    int found = parse_bool_value(json, "\"sampleStore\"", &config->sample_store);
+    found |= parse_string_value(json, "\"sampleFormat\"", &config->sample_format);
+    found |= parse_string_value(json, "\"bankSampleFormats\"", &config->bank_sample_formats);
+    if (parse_number_value(json, "\"loaderThreads\"", &value)) {
+        found = 1;
+        if (value >= 1.0 && value <= 16.0) {
+            config->loader_threads = (int)value;
+        } else {
+            fprintf(stderr, "Warning: loaderThreads must be between 1 and 16 (using %d)\n", config->loader_threads);
+        }
+    }
+    if (parse_number_value(json, "\"sampleLoadTimeout\"", &value)) {
+        found = 1;
+        if (value >= 0.0 && value <= 60.0) {
+            config->sample_load_timeout = value;
+        } else {
+            fprintf(stderr, "Warning: sampleLoadTimeout must be between 0 and 60 seconds (using %.1f)\n", config->sample_load_timeout);
+        }
+    }
+    if (parse_number_value(json, "\"sampleMemoryMB\"", &value)) {
+        found = 1;
+        if (value >= 0.0 && value <= 1048576.0) {
+            config->sample_memory_mb = (int)value;
+        } else {
+            fprintf(stderr, "Warning: sampleMemoryMB must be between 0 and 1048576 (using %d)\n", config->sample_memory_mb);
+        }
+    }
+    return found;
+}
+
+static int parse_send_effects(const char *json, MusikaConfig *config) {
+    double value = 0.0;
+    int found = 0;
+    if (parse_number_value(json, "\"delayTime\"", &value)) {
+        found = 1;
+        if (value > 0.0 && value <= 16.0) {
+            config->delay_beats = value;
+        } else {
+            fprintf(stderr, "Warning: delayTime must be between 0 and 16 beats (using %.2f)\n", config->delay_beats);
+        }
+    }
+    if (parse_number_value(json, "\"delayFeedback\"", &value)) {
+        found = 1;
+        if (value >= 0.0 && value <= 0.95) {
+            config->delay_feedback = value;
+        } else {
+            fprintf(stderr, "Warning: delayFeedback must be between 0 and 0.95 (using %.2f)\n", config->delay_feedback);
+        }
+    }
+    if (parse_number_value(json, "\"reverbDecay\"", &value)) {
+        found = 1;
+        if (value >= 0.1 && value <= 30.0) {
+            config->reverb_decay = value;
+        } else {
+            fprintf(stderr, "Warning: reverbDecay must be between 0.1 and 30 seconds (using %.2f)\n", config->reverb_decay);
+        }
+    }
+    if (parse_string_value(json, "\"reverbImpulse\"", &config->reverb_impulse)) {
+        found = 1;
+    }
+    return found;
+}
+
 static int parse_sample_repos(const char *json, MusikaConfig *config) {
     const char *key = "\"sampleRepos\"";
     const char *pos = strstr(json, key);
@@ -173,14 +442,27 @@ void load_config(const char *path, MusikaConfig *config) {
     }
 
     parse_audio_backend(json, config);
+    parse_audio_file(json, config);
+    parse_audio_device(json, config);
+    parse_buffer_size(json, config);
+    parse_realtime(json, config);
+    parse_master_ceiling(json, config);
+    parse_bus_outputs(json, config);
     parse_tempo(json, config);
+    parse_resampler(json, config);
+    parse_voices(json, config);
+    parse_voice_steal(json, config);
+    parse_send_effects(json, config);
+    parse_render_threads(json, config);
+    parse_event_queue(json, config);
+    parse_sample_loader(json, config);
     parse_sample_repos(json, config);
 
     if (!config->audio_backend) {
         config->audio_backend = strdup_safe("simulated");
     }
     if (config->sample_repo_count == 0) {
-        set_defaults(config);
+        append_default_repos(config);
     }
 
     free(json);
@@ -188,6 +470,13 @@ void load_config(const char *path, MusikaConfig *config) {
 
 void free_config(MusikaConfig *config) {
     free(config->audio_backend);
+    free(config->audio_file);
+    free(config->audio_device);
+    free(config->resampler);
+    free(config->voice_steal);
+    free(config->reverb_impulse);
+    free(config->sample_format);
+    free(config->bank_sample_formats);
     clear_sample_repos(config);
     reset_config(config);
 }
@@ -1,13 +1,40 @@
 #ifndef MUSIKA_CONFIG_H
 #define MUSIKA_CONFIG_H
 
+#include <stdbool.h>
 #include <stddef.h>
 
 typedef struct {
     char *audio_backend;
+    char *audio_file; // destination for the "file" backend
+    char *audio_device; // ALSA PCM name, NULL for "default"
+    int period_size;    // frames per device period
+    int periods;        // periods in the device buffer
+    double latency_ms;  // target buffer length; overrides period_size when > 0
+    bool realtime;      // SCHED_FIFO, memory locking and FTZ/DAZ for the audio thread
+    int realtime_priority;
+    int audio_cpu;      // CPU for the audio thread, -1 to leave it unpinned
+    bool lock_memory;
+    double master_ceiling; // master limiter ceiling in dBFS
+    int bus_outputs;       // chain buses with their own device channel pair
+    int loader_threads;    // background threads fetching and decoding samples
+    double sample_load_timeout; // seconds a new pattern waits for its samples
+    int sample_memory_mb;       // decoded sample budget, 0 for no limit
+    bool sample_store;          // keep decoded samples under ~/.cache/musika for mapping
+    char *sample_format;        // "float" or "int16" storage, NULL for float
+    char *bank_sample_formats;  // per-registry overrides, "user=int16,default=float"
     char **sample_repos;
     size_t sample_repo_count;
     double tempo_bpm;
+    char *resampler;
+    int voices;
+    char *voice_steal;
+    double delay_beats;
+    double delay_feedback;
+    double reverb_decay;
+    char *reverb_impulse;
+    int render_threads;
+    int event_queue; // event ring slots
 } MusikaConfig;
 
 void load_config(const char *path, MusikaConfig *config);
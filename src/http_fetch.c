@@ -1,5 +1,6 @@
 #include "http_fetch.h"
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -33,18 +34,27 @@ static size_t write_callback(char *ptr, size_t size, size_t nmemb, void *userdat
     return total;
 }
 
+// curl_global_init is not thread-safe, and sample loader threads fetch
+// concurrently, so it runs once for the process and is never cleaned up.
+static pthread_once_t curl_once = PTHREAD_ONCE_INIT;
+static bool curl_ready;
+
+static void curl_init_once(void) {
+    curl_ready = curl_global_init(CURL_GLOBAL_DEFAULT) == 0;
+}
+
 bool http_fetch_to_buffer(const char *url, char **out_buffer, size_t *out_len) {
     if (!url || !out_buffer) return false;
     *out_buffer = NULL;
     if (out_len) *out_len = 0;
 
-    if (curl_global_init(CURL_GLOBAL_DEFAULT) != 0) {
+    pthread_once(&curl_once, curl_init_once);
+    if (!curl_ready) {
         return false;
     }
 
     CURL *curl = curl_easy_init();
     if (!curl) {
-        curl_global_cleanup();
         return false;
     }
 
@@ -55,6 +65,7 @@ bool http_fetch_to_buffer(const char *url, char **out_buffer, size_t *out_len) {
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buffer);
     curl_easy_setopt(curl, CURLOPT_USERAGENT, "Musika/1.0");
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
 
     CURLcode res = curl_easy_perform(curl);
     long response_code = 0;
@@ -63,7 +74,6 @@ bool http_fetch_to_buffer(const char *url, char **out_buffer, size_t *out_len) {
     }
 
     curl_easy_cleanup(curl);
-    curl_global_cleanup();
 
     if (res != CURLE_OK || response_code >= 400 || buffer.len == 0) {
         free(buffer.data);
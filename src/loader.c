@@ -0,0 +1,507 @@
+#define _XOPEN_SOURCE 700
+
+#include "loader.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "cache.h"
+#include "http_fetch.h"
+#include "pcmstore.h"
+
+// Backoff before a failed sample is fetched again, doubling with each
+// failure in a row, so a pattern evaluated in a loop does not hammer an
+// unreachable server.
+static const double SAMPLE_RETRY_MIN_SECONDS = 5.0;
+static const double SAMPLE_RETRY_MAX_SECONDS = 300.0;
+
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static bool file_exists(const char *path) {
+    struct stat st;
+    return path && stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+static const char *variant_value_for_ref(const SampleRef *ref) {
+    if (!ref || !ref->sound) return NULL;
+    const SampleSound *sound = ref->sound;
+    if (sound->pitched_entry_count > 0 && sound->pitched_variants && ref->variant_index < sound->pitched_entry_count) {
+        return sound->pitched_variants[ref->variant_index];
+    }
+    if (sound->variant_count > 0 && sound->variants && ref->variant_index < sound->variant_count) {
+        return sound->variants[ref->variant_index];
+    }
+    return NULL;
+}
+
+static bool build_variant_url(const SampleRef *ref, char *out, size_t out_len) {
+    if (!ref || !ref->sound || ref->variant_index >= ref->sound->variant_count || !out || out_len == 0) return false;
+    const char *variant = variant_value_for_ref(ref);
+    if (!variant || variant[0] == '\0') return false;
+
+    if (strncmp(variant, "http://", 7) == 0 || strncmp(variant, "https://", 8) == 0 || strncmp(variant, "file://", 7) == 0 || variant[0] == '/' || variant[0] == '.') {
+        return snprintf(out, out_len, "%s", variant) < (int)out_len;
+    }
+
+    const char *base = (ref->registry && ref->registry->base) ? ref->registry->base : NULL;
+    if (base && base[0]) {
+        size_t base_len = strlen(base);
+        bool needs_slash = base_len > 0 && base[base_len - 1] != '/' && variant[0] != '/';
+        if (needs_slash) {
+            return snprintf(out, out_len, "%s/%s", base, variant) < (int)out_len;
+        }
+        return snprintf(out, out_len, "%s%s", base, variant) < (int)out_len;
+    }
+
+    return snprintf(out, out_len, "%s", variant) < (int)out_len;
+}
+
+static bool is_remote_url(const char *url) {
+    return url && (strncmp(url, "http://", 7) == 0 || strncmp(url, "https://", 8) == 0);
+}
+
+static bool ensure_cached_sample(const char *url, char *out_path, size_t out_len) {
+    if (!url || !out_path || out_len == 0) return false;
+    if (!cache_path_for_key_with_ext(url, ".wav", out_path, out_len)) return false;
+    if (file_exists(out_path)) return true;
+
+    char *buffer = NULL;
+    size_t len = 0;
+    if (!http_fetch_to_buffer(url, &buffer, &len)) return false;
+    bool ok = cache_write(out_path, buffer, len);
+    free(buffer);
+    return ok;
+}
+
+// Decodes the WAV at path into format, going through the decoded-PCM store
+// when use_store is set: a stored copy is mapped instead of decoded, and a
+// fresh decode is stored and then served from its mapping.
+static bool load_wav(const char *path, AudioSampleFormat format, bool use_store, AudioSample *out) {
+    PcmStoreSource origin;
+    char resolved[PATH_MAX];
+    char store[512];
+    const char *ext = format == AUDIO_SAMPLE_S16 ? ".s16.pcm" : ".pcm";
+    bool storable = use_store && pcm_store_source_of(path, &origin) && realpath(path, resolved) &&
+                    cache_path_for_key_with_ext(resolved, ext, store, sizeof(store));
+    if (storable && pcm_store_map(store, &origin, format, out)) return true;
+    if (!audio_sample_from_wav_as(path, format, out)) return false;
+    AudioSample mapped;
+    if (storable && pcm_store_write(store, &origin, out) && pcm_store_map(store, &origin, format, &mapped)) {
+        audio_sample_free(out);
+        *out = mapped;
+    }
+    return true;
+}
+
+// Fetches (through the on-disk cache) and decodes one sample. An empty
+// source is the built-in tone.
+static bool load_source(const char *source,
+                        uint32_t sample_rate,
+                        AudioSampleFormat format,
+                        bool use_store,
+                        AudioSample *out) {
+    if (source[0] == '\0') {
+        return audio_sample_generate_sine(out, 1.5, sample_rate, 440.0);
+    }
+    char path[512];
+    if (is_remote_url(source)) {
+        if (!ensure_cached_sample(source, path, sizeof(path))) return false;
+    } else if (snprintf(path, sizeof(path), "%s", source) >= (int)sizeof(path) || !file_exists(path)) {
+        return false;
+    }
+    return load_wav(path, format, use_store, out);
+}
+
+static uint64_t hash_key(const char *key) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char *)key; *p; ++p) {
+        hash ^= (uint64_t)*p;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static char *copy_string(const char *text) {
+    size_t len = strlen(text) + 1;
+    char *copy = (char *)malloc(len);
+    if (copy) memcpy(copy, text, len);
+    return copy;
+}
+
+// Storage format for the slot's registry (the key's first field). Lock held.
+static AudioSampleFormat slot_format(const SampleLoader *loader, const SampleSlot *slot) {
+    size_t len = strcspn(slot->key, ":");
+    for (size_t i = 0; i < loader->bank_format_count; ++i) {
+        const SampleBankFormat *entry = &loader->bank_formats[i];
+        if (strlen(entry->bank) == len && strncmp(entry->bank, slot->key, len) == 0) return entry->format;
+    }
+    return loader->format;
+}
+
+static void lru_remove(SampleLoader *loader, SampleSlot *slot) {
+    if (!slot->in_lru) return;
+    if (slot->lru_prev) slot->lru_prev->lru_next = slot->lru_next;
+    else loader->lru_head = slot->lru_next;
+    if (slot->lru_next) slot->lru_next->lru_prev = slot->lru_prev;
+    else loader->lru_tail = slot->lru_prev;
+    slot->lru_prev = slot->lru_next = NULL;
+    slot->in_lru = false;
+}
+
+static void lru_append(SampleLoader *loader, SampleSlot *slot) {
+    if (slot->in_lru) return;
+    slot->lru_prev = loader->lru_tail;
+    slot->lru_next = NULL;
+    if (loader->lru_tail) loader->lru_tail->lru_next = slot;
+    else loader->lru_head = slot;
+    loader->lru_tail = slot;
+    slot->in_lru = true;
+}
+
+static void free_sample(void *ptr) {
+    audio_sample_free((AudioSample *)ptr);
+    free(ptr);
+}
+
+// Evicts unpinned samples, oldest release first, until the cache fits the
+// budget. Lock held.
+static void evict_over_budget(SampleLoader *loader) {
+    if (loader->budget_bytes == 0) return;
+    while (loader->lru_head && loader->resident_bytes > loader->budget_bytes) {
+        SampleSlot *slot = loader->lru_head;
+        lru_remove(loader, slot);
+        audio_epoch_retire(loader->epoch, free_sample, slot->sample);
+        slot->sample = NULL;
+        loader->resident_bytes -= slot->bytes;
+        slot->bytes = 0;
+        atomic_store_explicit(&slot->state, SAMPLE_SLOT_EVICTED, memory_order_relaxed);
+    }
+    if (loader->resident_bytes > loader->budget_bytes && !loader->over_budget_warned) {
+        fprintf(stderr, "Warning: samples in use take %.0f MB, over the %.0f MB sample memory budget\n",
+                (double)loader->resident_bytes / 1048576.0, (double)loader->budget_bytes / 1048576.0);
+        loader->over_budget_warned = true;
+    }
+}
+
+static void *loader_thread(void *arg) {
+    SampleLoader *loader = (SampleLoader *)arg;
+    pthread_mutex_lock(&loader->lock);
+    while (true) {
+        while (!loader->queue_head && !loader->stopping) {
+            pthread_cond_wait(&loader->work, &loader->lock);
+        }
+        if (loader->stopping) break;
+        SampleSlot *slot = loader->queue_head;
+        loader->queue_head = slot->queue_next;
+        if (!loader->queue_head) loader->queue_tail = NULL;
+        slot->queue_next = NULL;
+        bool use_store = loader->use_store;
+        AudioSampleFormat format = slot_format(loader, slot);
+        pthread_mutex_unlock(&loader->lock);
+
+        // source never changes once the slot exists, so it is read unlocked.
+        AudioSample *sample = (AudioSample *)calloc(1, sizeof(AudioSample));
+        bool ok = sample && load_source(slot->source, loader->sample_rate, format, use_store, sample);
+        if (!ok) free(sample);
+
+        pthread_mutex_lock(&loader->lock);
+        if (ok) {
+            slot->sample = sample;
+            slot->bytes = audio_sample_bytes(sample);
+            loader->resident_bytes += slot->bytes;
+            slot->failures = 0;
+            atomic_store_explicit(&slot->state, SAMPLE_SLOT_READY, memory_order_release);
+            if (slot->pins == 0) lru_append(loader, slot);
+            evict_over_budget(loader);
+        } else {
+            double delay = SAMPLE_RETRY_MIN_SECONDS;
+            for (uint32_t i = 0; i < slot->failures && delay < SAMPLE_RETRY_MAX_SECONDS; ++i) delay *= 2.0;
+            if (delay > SAMPLE_RETRY_MAX_SECONDS) delay = SAMPLE_RETRY_MAX_SECONDS;
+            slot->failures++;
+            slot->retry_at = monotonic_seconds() + delay;
+            atomic_store_explicit(&slot->state, SAMPLE_SLOT_FAILED, memory_order_release);
+        }
+        pthread_cond_broadcast(&loader->progress);
+    }
+    pthread_mutex_unlock(&loader->lock);
+    return NULL;
+}
+
+// Cache key for ref: registry:sound:variant, or the shared built-in tone.
+static bool ref_key(const SampleRef *ref, char *key, size_t key_len, bool *out_tone) {
+    if (!ref || !ref->valid || !ref->sound || ref->variant_index >= ref->sound->variant_count) return false;
+    *out_tone = ref->sound->name && strcmp(ref->sound->name, "tone") == 0;
+    if (*out_tone) return snprintf(key, key_len, "builtin:tone") < (int)key_len;
+    const char *registry_name = (ref->registry && ref->registry->name) ? ref->registry->name : "default";
+    return snprintf(key, key_len, "%s:%s:%zu", registry_name, ref->sound->name, ref->variant_index) < (int)key_len;
+}
+
+// Doubles the bucket array once the table is three quarters full. Lock held.
+static void grow_table(SampleLoader *loader) {
+    if (loader->slot_count * 4 < loader->bucket_count * 3) return;
+    size_t count = loader->bucket_count * 2;
+    SampleSlot **buckets = (SampleSlot **)calloc(count, sizeof(SampleSlot *));
+    if (!buckets) return; // keep the longer chains rather than fail
+    for (size_t i = 0; i < loader->bucket_count; ++i) {
+        SampleSlot *slot = loader->buckets[i];
+        while (slot) {
+            SampleSlot *next = slot->hash_next;
+            size_t b = (size_t)slot->hash & (count - 1);
+            slot->hash_next = buckets[b];
+            buckets[b] = slot;
+            slot = next;
+        }
+    }
+    free(loader->buckets);
+    loader->buckets = buckets;
+    loader->bucket_count = count;
+}
+
+static void queue_slot(SampleLoader *loader, SampleSlot *slot) {
+    atomic_store_explicit(&slot->state, SAMPLE_SLOT_LOADING, memory_order_relaxed);
+    slot->queue_next = NULL;
+    if (loader->queue_tail) loader->queue_tail->queue_next = slot;
+    else loader->queue_head = slot;
+    loader->queue_tail = slot;
+    pthread_cond_signal(&loader->work);
+}
+
+// Finds the slot for ref, creating it if needed, and queues it unless it is
+// resident, loading, or failed within its retry backoff. Lock held; returns
+// NULL for refs that cannot be loaded.
+static SampleSlot *slot_for_ref(SampleLoader *loader, const SampleRef *ref) {
+    char key[256];
+    bool tone = false;
+    if (!ref_key(ref, key, sizeof(key), &tone)) return NULL;
+    uint64_t hash = hash_key(key);
+    for (SampleSlot *slot = loader->buckets[hash & (loader->bucket_count - 1)]; slot; slot = slot->hash_next) {
+        if (slot->hash == hash && strcmp(slot->key, key) == 0) {
+            int state = atomic_load_explicit(&slot->state, memory_order_relaxed);
+            if (state == SAMPLE_SLOT_EVICTED ||
+                (state == SAMPLE_SLOT_FAILED && slot->retry_at > 0.0 && monotonic_seconds() >= slot->retry_at)) {
+                queue_slot(loader, slot);
+            }
+            return slot;
+        }
+    }
+
+    char source[512] = "";
+    bool have_source = tone || build_variant_url(ref, source, sizeof(source));
+    SampleSlot *slot = (SampleSlot *)calloc(1, sizeof(SampleSlot));
+    if (slot) {
+        slot->key = copy_string(key);
+        slot->source = copy_string(source);
+    }
+    if (!slot || !slot->key || !slot->source) {
+        if (slot) {
+            free(slot->key);
+            free(slot->source);
+            free(slot);
+        }
+        fprintf(stderr, "Warning: out of memory caching sample %s\n", key);
+        return NULL;
+    }
+    slot->hash = hash;
+    size_t b = (size_t)hash & (loader->bucket_count - 1);
+    slot->hash_next = loader->buckets[b];
+    loader->buckets[b] = slot;
+    loader->slot_count++;
+    grow_table(loader);
+    if (have_source) {
+        queue_slot(loader, slot);
+    } else {
+        atomic_store_explicit(&slot->state, SAMPLE_SLOT_FAILED, memory_order_relaxed);
+    }
+    return slot;
+}
+
+static size_t set_loading(const SampleSet *set) {
+    size_t loading = 0;
+    for (size_t i = 0; i < set->slot_count; ++i) {
+        if (atomic_load_explicit(&set->slots[i]->state, memory_order_relaxed) == SAMPLE_SLOT_LOADING) loading++;
+    }
+    return loading;
+}
+
+bool sample_loader_init(SampleLoader *loader,
+                        uint32_t threads,
+                        uint32_t sample_rate,
+                        const AudioSample *fallback,
+                        AudioEpoch *epoch) {
+    memset(loader, 0, sizeof(*loader));
+    loader->sample_rate = sample_rate ? sample_rate : 48000;
+    loader->fallback = fallback;
+    loader->epoch = epoch;
+    loader->use_store = true;
+    loader->bucket_count = 64;
+    loader->buckets = (SampleSlot **)calloc(loader->bucket_count, sizeof(SampleSlot *));
+    if (!loader->buckets) return false;
+    pthread_mutex_init(&loader->lock, NULL);
+    pthread_cond_init(&loader->work, NULL);
+    pthread_cond_init(&loader->progress, NULL);
+    if (threads < 1) threads = 1;
+    if (threads > SAMPLE_LOADER_MAX_THREADS) threads = SAMPLE_LOADER_MAX_THREADS;
+    for (uint32_t i = 0; i < threads; ++i) {
+        if (pthread_create(&loader->threads[loader->thread_count], NULL, loader_thread, loader) != 0) break;
+        loader->thread_count++;
+    }
+    if (loader->thread_count == 0) {
+        sample_loader_shutdown(loader);
+        return false;
+    }
+    if (loader->thread_count < threads) {
+        fprintf(stderr, "Warning: started %u of %u sample loader threads\n", loader->thread_count, threads);
+    }
+    return true;
+}
+
+void sample_loader_shutdown(SampleLoader *loader) {
+    pthread_mutex_lock(&loader->lock);
+    loader->stopping = true;
+    pthread_cond_broadcast(&loader->work);
+    pthread_mutex_unlock(&loader->lock);
+    for (uint32_t i = 0; i < loader->thread_count; ++i) {
+        pthread_join(loader->threads[i], NULL);
+    }
+    loader->thread_count = 0;
+    for (size_t i = 0; i < loader->bucket_count; ++i) {
+        SampleSlot *slot = loader->buckets[i];
+        while (slot) {
+            SampleSlot *next = slot->hash_next;
+            if (atomic_load_explicit(&slot->state, memory_order_relaxed) == SAMPLE_SLOT_READY) {
+                audio_epoch_retire(loader->epoch, free_sample, slot->sample);
+            }
+            free(slot->key);
+            free(slot->source);
+            free(slot);
+            slot = next;
+        }
+    }
+    free(loader->buckets);
+    loader->buckets = NULL;
+    loader->bucket_count = 0;
+    loader->slot_count = 0;
+    loader->resident_bytes = 0;
+    pthread_cond_destroy(&loader->progress);
+    pthread_cond_destroy(&loader->work);
+    pthread_mutex_destroy(&loader->lock);
+}
+
+void sample_loader_set_budget(SampleLoader *loader, size_t bytes) {
+    pthread_mutex_lock(&loader->lock);
+    loader->budget_bytes = bytes;
+    loader->over_budget_warned = false;
+    evict_over_budget(loader);
+    pthread_mutex_unlock(&loader->lock);
+}
+
+void sample_loader_set_store(SampleLoader *loader, bool enabled) {
+    pthread_mutex_lock(&loader->lock);
+    loader->use_store = enabled;
+    pthread_mutex_unlock(&loader->lock);
+}
+
+void sample_loader_set_format(SampleLoader *loader, AudioSampleFormat format) {
+    pthread_mutex_lock(&loader->lock);
+    loader->format = format;
+    pthread_mutex_unlock(&loader->lock);
+}
+
+bool sample_loader_set_bank_format(SampleLoader *loader, const char *bank, AudioSampleFormat format) {
+    if (!bank || bank[0] == '\0' || strlen(bank) >= sizeof(loader->bank_formats[0].bank)) return false;
+    pthread_mutex_lock(&loader->lock);
+    SampleBankFormat *entry = NULL;
+    for (size_t i = 0; i < loader->bank_format_count; ++i) {
+        if (strcmp(loader->bank_formats[i].bank, bank) == 0) entry = &loader->bank_formats[i];
+    }
+    if (!entry && loader->bank_format_count < SAMPLE_LOADER_MAX_BANK_FORMATS) {
+        entry = &loader->bank_formats[loader->bank_format_count++];
+        snprintf(entry->bank, sizeof(entry->bank), "%s", bank);
+    }
+    if (entry) entry->format = format;
+    pthread_mutex_unlock(&loader->lock);
+    return entry != NULL;
+}
+
+void sample_loader_usage(SampleLoader *loader, size_t *out_bytes, size_t *out_sounds) {
+    pthread_mutex_lock(&loader->lock);
+    if (out_bytes) *out_bytes = loader->resident_bytes;
+    if (out_sounds) *out_sounds = loader->slot_count;
+    pthread_mutex_unlock(&loader->lock);
+}
+
+size_t sample_loader_acquire(SampleLoader *loader, const Pattern *pattern, SampleSet *set) {
+    memset(set, 0, sizeof(*set));
+    pthread_mutex_lock(&loader->lock);
+    for (size_t i = 0; i < pattern->step_count && i < PATTERN_MAX_STEPS; ++i) {
+        const PatternStep *step = &pattern->steps[i];
+        if (step->is_synth || !step->sample.valid) continue;
+        SampleSlot *slot = slot_for_ref(loader, &step->sample);
+        if (!slot) continue;
+        set->steps[i] = slot;
+        bool seen = false;
+        for (size_t s = 0; s < set->slot_count && !seen; ++s) {
+            seen = set->slots[s] == slot;
+        }
+        if (seen) continue;
+        set->slots[set->slot_count++] = slot;
+        if (slot->pins++ == 0) lru_remove(loader, slot);
+    }
+    size_t loading = set_loading(set);
+    pthread_mutex_unlock(&loader->lock);
+    return loading;
+}
+
+void sample_loader_release(SampleLoader *loader, SampleSet *set) {
+    pthread_mutex_lock(&loader->lock);
+    for (size_t i = 0; i < set->slot_count; ++i) {
+        SampleSlot *slot = set->slots[i];
+        if (--slot->pins == 0 && atomic_load_explicit(&slot->state, memory_order_relaxed) == SAMPLE_SLOT_READY) {
+            lru_append(loader, slot);
+        }
+    }
+    evict_over_budget(loader);
+    pthread_mutex_unlock(&loader->lock);
+    memset(set, 0, sizeof(*set));
+}
+
+size_t sample_loader_pending(SampleLoader *loader, const SampleSet *set) {
+    pthread_mutex_lock(&loader->lock);
+    size_t loading = set_loading(set);
+    pthread_mutex_unlock(&loader->lock);
+    return loading;
+}
+
+bool sample_loader_wait(SampleLoader *loader, const SampleSet *set, double timeout) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    if (timeout >= 0.0) {
+        double whole = (double)(time_t)timeout;
+        deadline.tv_sec += (time_t)whole;
+        deadline.tv_nsec += (long)((timeout - whole) * 1e9);
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+    pthread_mutex_lock(&loader->lock);
+    bool done = true;
+    while (set_loading(set) > 0) {
+        if (timeout < 0.0) {
+            pthread_cond_wait(&loader->progress, &loader->lock);
+        } else if (pthread_cond_timedwait(&loader->progress, &loader->lock, &deadline) != 0) {
+            done = set_loading(set) == 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&loader->lock);
+    return done;
+}
@@ -0,0 +1,129 @@
+#ifndef MUSIKA_LOADER_H
+#define MUSIKA_LOADER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../audio/audio.h"
+#include "pattern.h"
+
+enum { SAMPLE_LOADER_MAX_THREADS = 16 };
+enum { SAMPLE_LOADER_MAX_BANK_FORMATS = 16 };
+
+typedef enum {
+    SAMPLE_SLOT_LOADING = 0, // queued or being fetched and decoded
+    SAMPLE_SLOT_READY,
+    SAMPLE_SLOT_FAILED,      // lookups get the fallback sample; retried on acquire after a backoff
+    SAMPLE_SLOT_EVICTED,     // unloaded to stay within the budget; reloads when a pattern needs it
+} SampleSlotState;
+
+// One cached sound. Slots are allocated once and never move or go away
+// before shutdown, so sets can point at them directly. Each load gets its
+// own AudioSample; evicting one retires it through the engine's epoch, so
+// voices still playing it keep valid data.
+typedef struct SampleSlot {
+    char *key;    // registry:sound:variant
+    char *source; // URL or path to load; empty for the built-in tone
+    uint64_t hash;
+    _Atomic int state;   // SampleSlotState; READY is stored after sample is set
+    AudioSample *sample; // while READY
+    size_t bytes;
+    uint32_t pins;       // sets holding the slot; pinned slots are never evicted
+    uint32_t failures;   // failed loads in a row
+    double retry_at;     // monotonic time after which a FAILED slot reloads; 0 never
+    bool in_lru;
+    struct SampleSlot *hash_next;
+    struct SampleSlot *queue_next;
+    struct SampleSlot *lru_prev; // unpinned resident slots, least recently released first
+    struct SampleSlot *lru_next;
+} SampleSlot;
+
+// A pattern's samples resolved to slots once, when the pattern is set, so
+// scheduling a step is an index rather than a key lookup. Holding a set pins
+// its slots in the cache.
+typedef struct {
+    SampleSlot *steps[PATTERN_MAX_STEPS]; // NULL for synth steps and refs that cannot load
+    SampleSlot *slots[PATTERN_MAX_STEPS]; // distinct slots, each pinned once
+    size_t slot_count;
+} SampleSet;
+
+// Storage format for every sample of one registry.
+typedef struct {
+    char bank[64];
+    AudioSampleFormat format;
+} SampleBankFormat;
+
+// Loads samples on a small pool of background threads so the scheduling
+// thread never waits on the network or the disk. Slots live in a hash table
+// that grows as needed; resident samples past the memory budget are evicted
+// least recently used first, skipping any a held set still pins.
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work;     // a slot was queued, or the loader is stopping
+    pthread_cond_t progress; // a slot finished loading
+    SampleSlot **buckets;
+    size_t bucket_count; // power of two
+    size_t slot_count;
+    SampleSlot *queue_head; // slots waiting for a thread, oldest first
+    SampleSlot *queue_tail;
+    SampleSlot *lru_head;
+    SampleSlot *lru_tail;
+    size_t resident_bytes;
+    size_t budget_bytes; // 0 for no limit
+    bool over_budget_warned;
+    bool stopping;
+    uint32_t sample_rate;        // rate for generated samples
+    const AudioSample *fallback; // stands in for samples that failed to load
+    AudioEpoch *epoch;           // evicted samples are retired here
+    bool use_store;              // map decoded samples from the PCM store (pcmstore.h)
+    AudioSampleFormat format;    // storage for samples of banks without an override
+    SampleBankFormat bank_formats[SAMPLE_LOADER_MAX_BANK_FORMATS];
+    size_t bank_format_count;
+    pthread_t threads[SAMPLE_LOADER_MAX_THREADS];
+    uint32_t thread_count;
+} SampleLoader;
+
+bool sample_loader_init(SampleLoader *loader,
+                        uint32_t threads,
+                        uint32_t sample_rate,
+                        const AudioSample *fallback,
+                        AudioEpoch *epoch);
+// Stops the threads (waiting for loads in progress) and retires every
+// sample; the engine frees them once the audio thread is done.
+void sample_loader_shutdown(SampleLoader *loader);
+void sample_loader_set_budget(SampleLoader *loader, size_t bytes);
+// Turns the decoded-PCM store under ~/.cache/musika on or off (on by default).
+void sample_loader_set_store(SampleLoader *loader, bool enabled);
+// Storage format for samples loaded from now on, for every bank or for one
+// registry. int16 halves the memory a sample takes; it is widened to float
+// as voices read it. The built-in tone stays float.
+void sample_loader_set_format(SampleLoader *loader, AudioSampleFormat format);
+bool sample_loader_set_bank_format(SampleLoader *loader, const char *bank, AudioSampleFormat format);
+// Bytes of decoded audio held and the number of cached sounds.
+void sample_loader_usage(SampleLoader *loader, size_t *out_bytes, size_t *out_sounds);
+// Resolves every sample the pattern uses into set, pins them and queues the
+// ones not resident yet. Returns how many are still loading.
+size_t sample_loader_acquire(SampleLoader *loader, const Pattern *pattern, SampleSet *set);
+// Unpins the set's slots, making them candidates for eviction.
+void sample_loader_release(SampleLoader *loader, SampleSet *set);
+// Number of the set's samples still loading; never blocks.
+size_t sample_loader_pending(SampleLoader *loader, const SampleSet *set);
+// Blocks until none of the set's samples are loading, or for at most timeout
+// seconds (forever when negative). Returns true if all finished.
+bool sample_loader_wait(SampleLoader *loader, const SampleSet *set, double timeout);
+
+// The sample for a step of a held set: the loaded sample, the fallback if it
+// failed, or NULL while it is still loading. Lock-free; called by the one
+// thread that schedules the set's pattern.
+static inline const AudioSample *sample_loader_get(const SampleLoader *loader, const SampleSet *set, size_t step) {
+    SampleSlot *slot = step < PATTERN_MAX_STEPS ? set->steps[step] : NULL;
+    if (!slot) return NULL;
+    int state = atomic_load_explicit(&slot->state, memory_order_acquire);
+    if (state == SAMPLE_SLOT_READY) return slot->sample;
+    return state == SAMPLE_SLOT_FAILED ? loader->fallback : NULL;
+}
+
+#endif // MUSIKA_LOADER_H
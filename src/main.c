@@ -1,4 +1,5 @@
 #include <ctype.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -12,6 +13,7 @@
 #include "samplemap.h"
 #include "transport.h"
 #include "../audio/audio.h"
+#include "../audio/wav.h"
 
 static void banner(void) {
     printf("Musika: live-coded terminal groove\n");
@@ -29,6 +31,11 @@ static void print_help(void) {
     printf("  :play           Start playback of the active pattern.\n");
     printf("  :stop           Pause playback without clearing the pattern.\n");
     printf("  :panic          Stop playback and clear queued audio.\n");
+    printf("  :stats          Show engine load, voice and timing counters since start.\n");
+    printf("  :buses          Show each chain's bus gain, mute and solo state.\n");
+    printf("  :mute <n>       Silence chain n without stopping it (:unmute <n> restores it).\n");
+    printf("  :solo <n>       Hear only soloed chains (:unsolo [n] releases one or all).\n");
+    printf("  :gain <n> <dB>  Set chain n's bus gain; chain 0 is steps outside any chain.\n");
     printf("  :clear          Clear the buffer.\n");
     printf("  :quit           Exit Musika.\n\n");
     printf("Pattern hints:\n");
@@ -40,21 +47,148 @@ static void print_help(void) {
 
 static void show_config(const MusikaConfig *config) {
     printf("Audio backend : %s\n", config->audio_backend);
+    if (config->audio_backend && strcmp(config->audio_backend, "file") == 0) {
+        printf("Audio file    : %s\n", config->audio_file ? config->audio_file : "musika-out.wav");
+    }
+    if (config->latency_ms > 0.0) {
+        printf("Latency       : %.1f ms target over %d periods\n", config->latency_ms, config->periods);
+    } else {
+        printf("Period        : %d frames x %d\n", config->period_size, config->periods);
+    }
+    if (config->audio_device) {
+        printf("Audio device  : %s\n", config->audio_device);
+    }
+    if (config->realtime) {
+        printf("Real-time     : SCHED_FIFO %d", config->realtime_priority);
+        if (config->audio_cpu >= 0) printf(", CPU %d", config->audio_cpu);
+        printf("%s\n", config->lock_memory ? ", memory locked" : "");
+    }
     printf("Sample packs  :\n");
     for (size_t i = 0; i < config->sample_repo_count; ++i) {
         printf("  - %s\n", config->sample_repos[i]);
     }
     printf("Tempo         : %.2f bpm\n", config->tempo_bpm);
+    printf("Resampler     : %s\n", config->resampler);
+    printf("Voices        : %d (steal %s)\n", config->voices, config->voice_steal ? config->voice_steal : "oldest");
+    printf("Render threads: %d\n", config->render_threads);
+    printf("Event queue   : %d slots\n", config->event_queue);
+    printf("Sample loader : %d threads, waits %.1f s for new sounds\n", config->loader_threads, config->sample_load_timeout);
+    if (config->sample_memory_mb > 0) {
+        printf("Sample memory : %d MB\n", config->sample_memory_mb);
+    } else {
+        printf("Sample memory : unlimited\n");
+    }
+    printf("Sample store  : %s\n", config->sample_store ? "~/.cache/musika (decoded, mapped)" : "off");
+    printf("Sample format : %s", config->sample_format ? config->sample_format : "float");
+    if (config->bank_sample_formats && config->bank_sample_formats[0] != '\0') {
+        printf(" (%s)", config->bank_sample_formats);
+    }
+    printf("\n");
+    printf("Master ceiling: %.1f dBFS\n", config->master_ceiling);
+    if (config->bus_outputs > 0) {
+        printf("Bus outputs   : chains 1-%d on channels 3-%d\n", config->bus_outputs, 2 + 2 * config->bus_outputs);
+    }
+    printf("Delay         : %.2f beats (feedback %.2f)\n", config->delay_beats, config->delay_feedback);
+    if (config->reverb_impulse && config->reverb_impulse[0] != '\0') {
+        printf("Reverb        : impulse %s\n", config->reverb_impulse);
+    } else {
+        printf("Reverb decay  : %.2f s\n", config->reverb_decay);
+    }
+}
+
+// Applies the loader settings: budget, store and the storage format,
+// globally and per registry ("bank=format" entries separated by commas).
+static void configure_sample_loader(SampleLoader *loader, const MusikaConfig *config) {
+    sample_loader_set_budget(loader, (size_t)config->sample_memory_mb << 20);
+    sample_loader_set_store(loader, config->sample_store);
+    AudioSampleFormat format = AUDIO_SAMPLE_F32;
+    if (config->sample_format && audio_sample_format_from_name(config->sample_format, &format)) {
+        sample_loader_set_format(loader, format);
+    } else if (config->sample_format) {
+        fprintf(stderr, "Warning: unknown sampleFormat '%s' (use float or int16)\n", config->sample_format);
+    }
+    const char *entry = config->bank_sample_formats;
+    while (entry && *entry) {
+        while (*entry == ' ') entry++;
+        size_t len = strcspn(entry, ",");
+        char bank[128];
+        const char *eq = memchr(entry, '=', len);
+        if (len < sizeof(bank)) {
+            memcpy(bank, entry, len);
+            bank[len] = '\0';
+        }
+        bool ok = eq && len < sizeof(bank);
+        if (ok) {
+            bank[eq - entry] = '\0';
+            ok = audio_sample_format_from_name(bank + (eq - entry) + 1, &format) &&
+                 sample_loader_set_bank_format(loader, bank, format);
+        }
+        if (!ok) {
+            fprintf(stderr, "Warning: ignoring bankSampleFormats entry '%.*s' (use bank=float or bank=int16)\n",
+                    (int)len, entry);
+        }
+        entry += len;
+        if (*entry == ',') entry++;
+    }
+}
+
+static AudioEngineConfig engine_config_from(const MusikaConfig *config) {
+    AudioEngineConfig engine_config = audio_engine_config_init(48000, 2);
+    AudioBackend backend = AUDIO_BACKEND_DEVICE;
+    if (config->audio_backend && audio_backend_from_name(config->audio_backend, &backend)) {
+        engine_config.backend = backend;
+    } else if (config->audio_backend) {
+        fprintf(stderr, "Warning: unknown audioBackend '%s' (use miniaudio, null or file)\n", config->audio_backend);
+    }
+    engine_config.output_path = config->audio_file;
+    engine_config.device_name = config->audio_device;
+    if (config->period_size > 0) engine_config.period_frames = (uint32_t)config->period_size;
+    if (config->periods > 0) engine_config.periods = (uint32_t)config->periods;
+    engine_config.latency_ms = config->latency_ms;
+    engine_config.realtime.enabled = config->realtime;
+    engine_config.realtime.priority = config->realtime_priority;
+    engine_config.realtime.cpu = config->audio_cpu;
+    engine_config.realtime.lock_memory = config->lock_memory;
+    engine_config.master_ceiling_db = (float)config->master_ceiling;
+    if (config->bus_outputs > 0) engine_config.bus_outputs = (uint32_t)config->bus_outputs;
+    ResampleQuality quality = RESAMPLE_CUBIC;
+    if (config->resampler && resample_quality_from_name(config->resampler, &quality)) {
+        engine_config.resample_quality = quality;
+    } else if (config->resampler) {
+        fprintf(stderr, "Warning: unknown resampler '%s' (using cubic)\n", config->resampler);
+    }
+    if (config->voices > 0) {
+        engine_config.voice_capacity = (uint32_t)config->voices;
+    }
+    VoiceStealPolicy policy = VOICE_STEAL_OLDEST;
+    if (config->voice_steal && audio_voice_steal_policy_from_name(config->voice_steal, &policy)) {
+        engine_config.steal_policy = policy;
+    } else if (config->voice_steal) {
+        fprintf(stderr, "Warning: unknown voiceSteal '%s' (use oldest, quietest or priority)\n", config->voice_steal);
+    }
+    engine_config.tempo_bpm = config->tempo_bpm;
+    engine_config.delay_beats = config->delay_beats;
+    engine_config.delay_feedback = config->delay_feedback;
+    engine_config.reverb_decay = config->reverb_decay;
+    engine_config.reverb_impulse = config->reverb_impulse;
+    if (config->render_threads > 0) {
+        engine_config.render_threads = (uint32_t)config->render_threads;
+    }
+    if (config->event_queue > 0) {
+        engine_config.event_capacity = (uint32_t)config->event_queue;
+    }
+    return engine_config;
 }
 
-static int run_beep_mode(void) {
+static int run_beep_mode(const MusikaConfig *config) {
     AudioEngine engine;
     AudioSample tone;
+    AudioEngineConfig engine_config = engine_config_from(config);
     if (!audio_sample_generate_sine(&tone, 2.5, 48000, 440.0)) {
         fprintf(stderr, "Failed to generate tone.\n");
         return 1;
     }
-    if (!audio_engine_init(&engine, 48000, 2)) {
+    if (!audio_engine_init(&engine, &engine_config)) {
         fprintf(stderr, "Audio init failed.\n");
         audio_sample_free(&tone);
         return 1;
@@ -74,6 +208,264 @@ static int run_beep_mode(void) {
     return 0;
 }
 
+typedef struct {
+    const char *out_path;
+    const char *pattern_path;
+    uint64_t cycles;
+    double tail_seconds;
+    WavFormat format;
+    bool stems; // also write each chain's bus to its own file
+} RenderOptions;
+
+static void free_lines(char **lines, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        free(lines[i]);
+    }
+    free(lines);
+}
+
+static bool read_pattern_file(const char *path, char ***out_lines, size_t *out_count) {
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    char line[2048];
+    char **lines = NULL;
+    size_t count = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char **grown = (char **)realloc(lines, sizeof(char *) * (count + 1));
+        size_t len = strlen(line);
+        char *copy = (char *)malloc(len + 1);
+        if (!grown || !copy) {
+            free(copy);
+            free_lines(grown ? grown : lines, count);
+            fclose(f);
+            return false;
+        }
+        memcpy(copy, line, len + 1);
+        lines = grown;
+        lines[count++] = copy;
+    }
+    fclose(f);
+    *out_lines = lines;
+    *out_count = count;
+    return true;
+}
+
+// out.wav -> out.chain3.wav for chain 3's stem.
+static void stem_path(const char *out_path, uint32_t chain, char *out, size_t out_len) {
+    size_t len = strlen(out_path);
+    if (len > 4 && strcmp(out_path + len - 4, ".wav") == 0) len -= 4;
+    snprintf(out, out_len, "%.*s.chain%u.wav", (int)len, out_path, chain);
+}
+
+static double elapsed_seconds(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+// Renders a pattern file to WAV without a sound card. The transport and the
+// mixer run exactly as they do live, but the clock is the number of frames
+// rendered so far, so the render runs as fast as the CPU allows and the
+// same input always gives the same output.
+static int run_render_mode(const MusikaConfig *config,
+                           const SampleRegistry *default_registry,
+                           const SampleRegistry *user_registry,
+                           const RenderOptions *options) {
+    char **lines = NULL;
+    size_t line_count = 0;
+    if (!options->pattern_path || !read_pattern_file(options->pattern_path, &lines, &line_count)) {
+        fprintf(stderr, "Could not read pattern file '%s'.\n", options->pattern_path ? options->pattern_path : "");
+        return 1;
+    }
+    Pattern pattern;
+    bool has_pattern = pattern_from_lines(lines, line_count, default_registry, user_registry, &pattern);
+    free_lines(lines, line_count);
+    if (!has_pattern) {
+        fprintf(stderr, "Pattern file '%s' is empty.\n", options->pattern_path);
+        return 1;
+    }
+
+    AudioSample samples[1];
+    if (!audio_sample_from_wav("assets/kick.wav", &samples[0])) {
+        fprintf(stderr, "Failed to load kick sample. Run ./scripts/fetch_kick.sh to generate assets/kick.wav.\n");
+        return 1;
+    }
+    AudioEngine engine;
+    AudioEngineConfig engine_config = engine_config_from(config);
+    if (options->stems) {
+        // Stems are the bus outputs: the master in the first channel pair,
+        // one pair per chain after it.
+        engine_config.bus_outputs = (uint32_t)pattern.chain_count;
+        if (pattern.chain_count == 0) {
+            fprintf(stderr, "Warning: pattern has no chains, so there are no stems to write\n");
+        }
+    }
+    if (!audio_engine_init_offline(&engine, &engine_config)) {
+        fprintf(stderr, "Audio initialization failed.\n");
+        audio_sample_free(&samples[0]);
+        return 1;
+    }
+    Transport transport;
+    if (!transport_init(&transport, &engine, samples, 1, config->tempo_bpm, (uint32_t)config->loader_threads, -1.0)) {
+        audio_engine_shutdown(&engine);
+        audio_sample_free(&samples[0]);
+        return 1;
+    }
+    configure_sample_loader(&transport.loader, config);
+    // Offline there is no deadline, so every sample is loaded before the first block.
+    transport_set_pattern(&transport, &pattern);
+    transport_wait_pattern(&transport);
+    transport_play(&transport);
+
+    // writers[0] takes the master, writers[n] chain n's stem.
+    WavWriter writers[AUDIO_MAX_CHAIN_BUSES + 1];
+    const uint32_t stems = engine.bus_outputs;
+    uint32_t opened = 0;
+    float *block = (float *)malloc(sizeof(float) * AUDIO_BLOCK_FRAMES * engine.channels);
+    float *split = (float *)malloc(sizeof(float) * AUDIO_BLOCK_FRAMES * 2);
+    bool ok = block && split;
+    for (uint32_t w = 0; ok && w <= stems; ++w) {
+        char path[1024];
+        if (w == 0) {
+            snprintf(path, sizeof(path), "%s", options->out_path);
+        } else {
+            stem_path(options->out_path, w, path, sizeof(path));
+        }
+        uint32_t channels = stems > 0 ? 2 : engine.channels;
+        if (!wav_writer_open(&writers[w], path, engine.sample_rate, channels, options->format)) {
+            fprintf(stderr, "Could not open '%s' for writing.\n", path);
+            ok = false;
+            break;
+        }
+        opened++;
+    }
+    if (!ok) {
+        for (uint32_t w = 0; w < opened; ++w) {
+            wav_writer_close(&writers[w]);
+        }
+        free(block);
+        free(split);
+        transport_stop(&transport);
+        audio_engine_shutdown(&engine);
+        audio_sample_free(&samples[0]);
+        return 1;
+    }
+
+    struct timespec started;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    const double block_seconds = (double)AUDIO_BLOCK_FRAMES / (double)engine.sample_rate;
+    uint64_t rendered = 0;
+    uint64_t total = UINT64_MAX;
+    while (rendered < total) {
+        if (total == UINT64_MAX) {
+            double now = audio_engine_time_seconds(&engine);
+            if (transport_schedule(&transport, now + block_seconds, options->cycles)) {
+                // Everything is queued: render to the end of the last cycle plus the tail.
+                total = (uint64_t)((transport.next_event_time + options->tail_seconds) * (double)engine.sample_rate);
+                if (total <= rendered) break;
+            }
+        }
+        uint32_t n = AUDIO_BLOCK_FRAMES;
+        if (total - rendered < n) n = (uint32_t)(total - rendered);
+        audio_engine_render(&engine, block, n);
+        if (stems == 0) {
+            ok = wav_writer_write(&writers[0], block, n);
+        } else {
+            for (uint32_t w = 0; ok && w <= stems; ++w) {
+                for (uint32_t f = 0; f < n; ++f) {
+                    split[2 * f] = block[(size_t)f * engine.channels + 2 * w];
+                    split[2 * f + 1] = block[(size_t)f * engine.channels + 2 * w + 1];
+                }
+                ok = wav_writer_write(&writers[w], split, n);
+            }
+        }
+        if (!ok) break;
+        rendered += n;
+    }
+    for (uint32_t w = 0; w <= stems; ++w) {
+        if (!wav_writer_close(&writers[w])) ok = false;
+    }
+
+    double wall = elapsed_seconds(&started);
+    double audio_seconds = (double)rendered / (double)engine.sample_rate;
+    if (ok) {
+        printf("Rendered %llu cycle(s), %.2f s of audio, to %s in %.2f s (%.1fx realtime)\n",
+               (unsigned long long)options->cycles,
+               audio_seconds,
+               options->out_path,
+               wall,
+               wall > 0.0 ? audio_seconds / wall : 0.0);
+        if (stems > 0) {
+            char path[1024];
+            stem_path(options->out_path, 1, path, sizeof(path));
+            printf("Wrote %u chain stem(s) alongside it, starting with %s\n", stems, path);
+        }
+    } else {
+        fprintf(stderr, "Failed while writing '%s'.\n", options->out_path);
+    }
+
+    free(block);
+    free(split);
+    transport_stop(&transport);
+    audio_engine_shutdown(&engine);
+    audio_sample_free(&samples[0]);
+    return ok ? 0 : 1;
+}
+
+// Prints the engine counters for the last interval to stderr every
+// `interval` seconds while the live loop runs (--stats-interval).
+typedef struct {
+    AudioEngine *engine;
+    double interval;
+    _Atomic bool running;
+    pthread_t thread;
+    bool started;
+} StatsReporter;
+
+static void *stats_reporter_thread(void *user) {
+    StatsReporter *reporter = (StatsReporter *)user;
+    AudioStatsSnapshot before;
+    audio_engine_stats(reporter->engine, &before);
+    struct timespec last;
+    clock_gettime(CLOCK_MONOTONIC, &last);
+    while (atomic_load(&reporter->running)) {
+        struct timespec nap = {0, 100 * 1000000L};
+        nanosleep(&nap, NULL);
+        if (elapsed_seconds(&last) < reporter->interval) continue;
+        clock_gettime(CLOCK_MONOTONIC, &last);
+        AudioStatsSnapshot now;
+        AudioStatsSnapshot delta;
+        audio_engine_stats(reporter->engine, &now);
+        audio_stats_delta(&now, &before, &delta);
+        before = now;
+        fprintf(stderr, "\n-- stats, last %.1f s --\n", reporter->interval);
+        audio_stats_print(&delta, stderr);
+    }
+    return NULL;
+}
+
+static void stats_reporter_start(StatsReporter *reporter, AudioEngine *engine, double interval) {
+    memset(reporter, 0, sizeof(*reporter));
+    if (interval <= 0.0) return;
+    reporter->engine = engine;
+    reporter->interval = interval;
+    atomic_store(&reporter->running, true);
+    if (pthread_create(&reporter->thread, NULL, stats_reporter_thread, reporter) == 0) {
+        reporter->started = true;
+    } else {
+        fprintf(stderr, "Warning: could not start the stats reporter\n");
+    }
+}
+
+static void stats_reporter_stop(StatsReporter *reporter) {
+    atomic_store(&reporter->running, false);
+    if (reporter->started) {
+        pthread_join(reporter->thread, NULL);
+        reporter->started = false;
+    }
+}
+
 static void handle_list_sounds(const SampleRegistry *default_registry, const SampleRegistry *user_registry, const char *arg) {
     const char *filter = NULL;
     if (arg && arg[0] != '\0') {
@@ -82,32 +474,136 @@ static void handle_list_sounds(const SampleRegistry *default_registry, const Sam
     sample_registry_print_merged(default_registry, user_registry, filter, stdout);
 }
 
-static void run_loop(MusikaConfig *config, SampleRegistry *default_registry, SampleRegistry *user_registry) {
+static void print_buses(const AudioEngine *engine, size_t chain_count) {
+    for (uint32_t bus = 0; bus <= chain_count && bus < AUDIO_BUS_COUNT; ++bus) {
+        AudioBusState state;
+        audio_engine_bus_state(engine, bus, &state);
+        if (bus == 0) {
+            printf("Chain 0 (unchained steps):");
+        } else {
+            printf("Chain %-2u                 :", bus);
+        }
+        if (state.gain > 0.0f) {
+            printf(" %+.1f dB", 20.0 * log10((double)state.gain));
+        } else {
+            printf(" -inf dB");
+        }
+        if (state.mute) printf(", muted");
+        if (state.solo) printf(", solo");
+        if (!state.mute && !state.audible && state.gain > 0.0f) printf(", silent (another chain is soloed)");
+        printf("\n");
+    }
+}
+
+// Parses the chain number argument of a bus command; bus 0 holds steps
+// outside any chain.
+static bool parse_bus_arg(const char *arg, uint32_t *out_bus, const char **rest) {
+    char *end = NULL;
+    long bus = strtol(arg, &end, 10);
+    if (end == arg || bus < 0 || bus >= AUDIO_BUS_COUNT) {
+        printf("Expected a chain number from 0 to %d.\n", AUDIO_MAX_CHAIN_BUSES);
+        return false;
+    }
+    *out_bus = (uint32_t)bus;
+    if (rest) *rest = end;
+    return true;
+}
+
+// :mute, :unmute, :solo, :unsolo and :gain. Returns false when line is not
+// a bus command.
+static bool handle_bus_command(AudioEngine *engine, const char *line) {
+    static const char *names[] = {":mute", ":unmute", ":solo", ":unsolo", ":gain"};
+    size_t which = sizeof(names) / sizeof(names[0]);
+    const char *arg = NULL;
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        size_t len = strlen(names[i]);
+        if (strncmp(line, names[i], len) == 0 && (line[len] == '\0' || isspace((unsigned char)line[len]))) {
+            which = i;
+            arg = line + len;
+            break;
+        }
+    }
+    if (!arg) return false;
+    while (*arg && isspace((unsigned char)*arg)) arg++;
+    if (which == 3 && *arg == '\0') {
+        for (uint32_t bus = 0; bus < AUDIO_BUS_COUNT; ++bus) {
+            audio_engine_set_bus_solo(engine, bus, false);
+        }
+        printf("All solos released.\n");
+        return true;
+    }
+    uint32_t bus = 0;
+    const char *rest = NULL;
+    if (!parse_bus_arg(arg, &bus, &rest)) return true;
+    switch (which) {
+    case 0:
+        audio_engine_set_bus_mute(engine, bus, true);
+        printf("Chain %u muted.\n", bus);
+        break;
+    case 1:
+        audio_engine_set_bus_mute(engine, bus, false);
+        printf("Chain %u unmuted.\n", bus);
+        break;
+    case 2:
+        audio_engine_set_bus_solo(engine, bus, true);
+        printf("Chain %u soloed.\n", bus);
+        break;
+    case 3:
+        audio_engine_set_bus_solo(engine, bus, false);
+        printf("Chain %u solo released.\n", bus);
+        break;
+    default: {
+        char *end = NULL;
+        double db = strtod(rest, &end);
+        if (end == rest || db > 24.0) {
+            printf("Usage: :gain <chain> <dB> (up to +24 dB)\n");
+            break;
+        }
+        audio_engine_set_bus_gain(engine, bus, db <= -96.0 ? 0.0f : (float)pow(10.0, db / 20.0));
+        printf("Chain %u gain %+.1f dB.\n", bus, db);
+        break;
+    }
+    }
+    return true;
+}
+
+static void run_loop(MusikaConfig *config, SampleRegistry *default_registry, SampleRegistry *user_registry, double stats_interval) {
     TextBuffer buffer = text_buffer_new();
     char line[2048];
     AudioEngine engine;
     AudioSample samples[1];
     Transport transport;
     Pattern pattern;
+    size_t chain_count = 0; // chains in the evaluated pattern, for :buses
+    AudioEngineConfig engine_config = engine_config_from(config);
 
     if (!audio_sample_from_wav("assets/kick.wav", &samples[0])) {
         fprintf(stderr, "Failed to load kick sample. Run ./scripts/fetch_kick.sh to generate assets/kick.wav.\n");
         text_buffer_free(&buffer);
         return;
     }
-    if (!audio_engine_init(&engine, 48000, 2)) {
+    if (!audio_engine_init(&engine, &engine_config)) {
         fprintf(stderr, "Audio initialization failed.\n");
         audio_sample_free(&samples[0]);
         text_buffer_free(&buffer);
         return;
     }
-    if (!transport_start(&transport, &engine, samples, 1, config->tempo_bpm)) {
+    if (!transport_start(&transport, &engine, samples, 1, config->tempo_bpm, (uint32_t)config->loader_threads,
+                         config->sample_load_timeout)) {
         fprintf(stderr, "Transport initialization failed.\n");
         audio_engine_shutdown(&engine);
         audio_sample_free(&samples[0]);
         text_buffer_free(&buffer);
         return;
     }
+    configure_sample_loader(&transport.loader, config);
+
+    const ma_device_config *device = &engine.device.config;
+    printf("Audio output  : %u Hz, %u frames x %u periods (%.1f ms)\n", device->sampleRate, device->periodSizeInFrames,
+           device->periods, 1000.0 * device->periodSizeInFrames * device->periods / device->sampleRate);
+
+    StatsReporter reporter;
+    stats_reporter_start(&reporter, &engine, stats_interval);
 
     banner();
     while (1) {
@@ -161,8 +657,13 @@ static void run_loop(MusikaConfig *config, SampleRegistry *default_registry, Sam
                 continue;
             }
             if (pattern_from_lines(buffer.lines, buffer.length, default_registry, user_registry, &pattern)) {
-                transport_set_pattern(&transport, &pattern);
-                printf("Pattern loaded into transport. Use :play to hear it.\n");
+                size_t loading = transport_set_pattern(&transport, &pattern);
+                chain_count = pattern.chain_count;
+                if (loading > 0) {
+                    printf("Pattern loaded; fetching %zu sample(s), it starts once they are ready.\n", loading);
+                } else {
+                    printf("Pattern loaded into transport. Use :play to hear it.\n");
+                }
             } else {
                 printf("Pattern is empty; nothing to evaluate.\n");
             }
@@ -175,6 +676,18 @@ static void run_loop(MusikaConfig *config, SampleRegistry *default_registry, Sam
         } else if (strcmp(line, ":panic") == 0) {
             transport_panic(&transport);
             printf("Transport and queues cleared.\n");
+        } else if (strcmp(line, ":stats") == 0) {
+            AudioStatsSnapshot stats;
+            audio_engine_stats(&engine, &stats);
+            audio_stats_print(&stats, stdout);
+            size_t sample_bytes = 0;
+            size_t sounds = 0;
+            sample_loader_usage(&transport.loader, &sample_bytes, &sounds);
+            printf("Samples       : %zu sounds known, %.1f MB decoded\n", sounds, (double)sample_bytes / 1048576.0);
+        } else if (strcmp(line, ":buses") == 0) {
+            print_buses(&engine, chain_count);
+        } else if (handle_bus_command(&engine, line)) {
+            continue;
         } else if (strcmp(line, ":clear") == 0) {
             text_buffer_clear(&buffer);
             printf("Buffer cleared.\n");
@@ -187,6 +700,7 @@ static void run_loop(MusikaConfig *config, SampleRegistry *default_registry, Sam
         }
     }
 
+    stats_reporter_stop(&reporter);
     transport_stop(&transport);
     audio_engine_shutdown(&engine);
     audio_sample_free(&samples[0]);
@@ -212,6 +726,10 @@ int main(int argc, char **argv) {
     const char *user_source = NULL;
     bool refresh_samples = false;
     bool beep_mode = false;
+    double stats_interval = 0.0;
+    RenderOptions render = {0};
+    render.cycles = 1;
+    render.format = WAV_PCM16;
 
     for (int i = 1; i < argc; ++i) {
         if (strcmp(argv[i], "--list-sounds") == 0) {
@@ -224,11 +742,37 @@ int main(int argc, char **argv) {
             refresh_samples = true;
         } else if (strcmp(argv[i], "--beep") == 0) {
             beep_mode = true;
+        } else if (strcmp(argv[i], "--stats-interval") == 0 && i + 1 < argc) {
+            stats_interval = strtod(argv[++i], NULL);
+            if (stats_interval <= 0.0) {
+                fprintf(stderr, "Warning: --stats-interval expects seconds greater than 0 (stats reporting off)\n");
+                stats_interval = 0.0;
+            }
+        } else if (strcmp(argv[i], "--render") == 0 && i + 1 < argc) {
+            render.out_path = argv[++i];
+        } else if (strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+            long cycles = strtol(argv[++i], NULL, 10);
+            if (cycles > 0) {
+                render.cycles = (uint64_t)cycles;
+            } else {
+                fprintf(stderr, "Warning: --cycles expects a positive number (using %llu)\n", (unsigned long long)render.cycles);
+            }
+        } else if (strcmp(argv[i], "--tail") == 0 && i + 1 < argc) {
+            double tail = strtod(argv[++i], NULL);
+            render.tail_seconds = tail > 0.0 ? tail : 0.0;
+        } else if (strcmp(argv[i], "--stems") == 0) {
+            render.stems = true;
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            if (!wav_format_from_name(argv[++i], &render.format)) {
+                fprintf(stderr, "Warning: unknown --format '%s' (use 16, 24 or float)\n", argv[i]);
+            }
+        } else if (argv[i][0] != '-') {
+            render.pattern_path = argv[i];
         }
     }
 
     if (beep_mode) {
-        int rc = run_beep_mode();
+        int rc = run_beep_mode(&config);
         sample_registry_free(&default_registry);
         free_config(&config);
         return rc;
@@ -260,7 +804,15 @@ int main(int argc, char **argv) {
         return 0;
     }
 
-    run_loop(&config, &default_registry, &user_registry);
+    if (render.out_path) {
+        int rc = run_render_mode(&config, &default_registry, &user_registry, &render);
+        sample_registry_free(&user_registry);
+        sample_registry_free(&default_registry);
+        free_config(&config);
+        return rc;
+    }
+
+    run_loop(&config, &default_registry, &user_registry, stats_interval);
     sample_registry_free(&user_registry);
     sample_registry_free(&default_registry);
     free_config(&config);
@@ -193,6 +193,16 @@ static bool parse_positive_int(const char *text, int *out_value, const char **re
     return true;
 }
 
+static bool parse_number_arg(const char *text, double *out_value) {
+    const char *start = skip_spaces(text);
+    if (!start || *start == '\0') return false;
+    char *end = NULL;
+    double value = strtod(start, &end);
+    if (end == start || *skip_spaces(end) != '\0' || !isfinite(value)) return false;
+    *out_value = value;
+    return true;
+}
+
 static void warn_once_for_modifier(const char *name, const char *message, ModifierWarningState *state) {
     if (!name || !message || !state) return;
     if (modifier_warned(state, name)) return;
@@ -393,7 +403,8 @@ static void append_note_step(Pattern *pattern,
                              NoteParseResult result,
                              const SampleRef *sample,
                              bool *missing_sample_warned,
-                             bool advance_time) {
+                             bool advance_time,
+                             bool is_synth) {
     if (!pattern || !note_step) return;
     PatternStep step = {0};
     step.duration_beats = note_step->duration_beats;
@@ -403,9 +414,15 @@ static void append_note_step(Pattern *pattern,
     step.advance_time = advance_time;
     step.chain_id = -1;
     step.time_scale = 1.0;
+    step.gain = 1.0;
+    step.pan = 0.5;
+    step.delay = 0.0;
+    step.room = 0.0;
 
     if (result == NOTE_PARSE_OK || result == NOTE_PARSE_HIT) {
-        if (sample && sample->valid) {
+        if (is_synth) {
+            step.is_synth = true;
+        } else if (sample && sample->valid) {
             step.sample = *sample;
             if (sample->sound && sample->sound->pitched_entry_count > 0 && note_step->has_midi_note) {
                 size_t variant_index = sample->variant_index;
@@ -432,10 +449,12 @@ static void append_note_step(Pattern *pattern,
 
 static void apply_pitch_shift_to_step(PatternStep *step, int semitone_shift, bool *pitch_clamp_warned) {
     if (!step || semitone_shift == 0 || !step->has_midi_note) return;
-    if (!step->sample.valid || !step->sample.sound) return;
-    if (step->sample.sound->pitched_entry_count == 0 &&
-        !(step->sample.sound->name && strcmp(step->sample.sound->name, "tone") == 0)) {
-        return;
+    if (!step->is_synth) {
+        if (!step->sample.valid || !step->sample.sound) return;
+        if (step->sample.sound->pitched_entry_count == 0 &&
+            !(step->sample.sound->name && strcmp(step->sample.sound->name, "tone") == 0)) {
+            return;
+        }
     }
 
     int midi = step->midi_note + semitone_shift;
@@ -454,6 +473,7 @@ static void apply_pitch_shift_to_step(PatternStep *step, int semitone_shift, boo
     }
 
     step->midi_note = midi;
+    if (step->is_synth) return;
 
     if (step->sample.sound->pitched_entry_count > 0) {
         size_t variant_index = step->sample.variant_index;
@@ -573,7 +593,8 @@ static void emit_note_token(const char *token,
                             Pattern *pattern,
                             bool *truncated_token_seen,
                             bool *missing_sample_warned,
-                            bool advance_time) {
+                            bool advance_time,
+                            bool is_synth) {
     if (!token || !pattern) return;
     char buffer[TOKEN_BUFFER_LEN];
     size_t len = strlen(token);
@@ -587,7 +608,7 @@ static void emit_note_token(const char *token,
     NoteStep step = {0};
     NoteParseResult result = parse_note_token(buffer, context, &step);
     if (result != NOTE_PARSE_NONE) {
-        append_note_step(pattern, &step, result, sample, missing_sample_warned, advance_time);
+        append_note_step(pattern, &step, result, sample, missing_sample_warned, advance_time, is_synth);
     }
 }
 
@@ -597,7 +618,8 @@ static void parse_note_sequence(const char *text,
                                 Pattern *pattern,
                                 bool *truncated_token_seen,
                                 bool *missing_sample_warned,
-                                bool *percussion_chord_warned) {
+                                bool *percussion_chord_warned,
+                                bool is_synth) {
     if (!text || !pattern) return;
     const char *p = text;
     while (p && *p) {
@@ -647,7 +669,7 @@ static void parse_note_sequence(const char *text,
                 p = after_group;
             }
 
-            bool pitched_sample = false;
+            bool pitched_sample = is_synth;
             if (sample && sample->valid && sample->sound) {
                 pitched_sample = (sample->sound->pitched_entry_count > 0) ||
                                  (sample->sound->name && strcmp(sample->sound->name, "tone") == 0);
@@ -677,7 +699,7 @@ static void parse_note_sequence(const char *text,
                 bool advance_time = !treat_as_chord || i == 0;
                 // Within a chord group, "~" is treated as a rest token: it emits no
                 // voice and does not affect chord timing.
-                emit_note_token(token_to_emit, sample, context, pattern, truncated_token_seen, missing_sample_warned, advance_time);
+                emit_note_token(token_to_emit, sample, context, pattern, truncated_token_seen, missing_sample_warned, advance_time, is_synth);
             }
             continue;
         }
@@ -691,7 +713,7 @@ static void parse_note_sequence(const char *text,
             if (len >= sizeof(token) && truncated_token_seen) *truncated_token_seen = true;
             memcpy(token, start, copy_len);
             token[copy_len] = '\0';
-            emit_note_token(token, sample, context, pattern, truncated_token_seen, missing_sample_warned, true);
+            emit_note_token(token, sample, context, pattern, truncated_token_seen, missing_sample_warned, true, is_synth);
         }
     }
 }
@@ -714,6 +736,16 @@ static void parse_modifier_chain(const char *text,
     int every_interval = chain ? chain->every_interval : 0;
     TimeTransformType every_type = chain ? chain->every_type : TIME_TRANSFORM_NONE;
     int every_factor = chain ? chain->every_factor : 0;
+    ResampleQuality resample_quality = chain ? chain->resample_quality : RESAMPLE_DEFAULT;
+    int priority = chain ? chain->priority : 0;
+    double gain = 1.0;
+    double pan = 0.5;
+    bool has_pan = false;
+    double sends[2] = {0.0, 0.0}; // delay, room
+    bool has_send[2] = {false, false};
+    bool is_synth = chain && chain->is_synth;
+    SynthParams synth = chain ? chain->synth : synth_params_init(SYNTH_SAW);
+    VoiceFilterParams filter = chain ? chain->filter : (VoiceFilterParams){0};
     const char *p = text;
     while (p && *p) {
         p = skip_spaces(p);
@@ -769,7 +801,8 @@ static void parse_modifier_chain(const char *text,
                                    pattern,
                                    truncated_token_seen,
                                    missing_sample_warned,
-                                   percussion_chord_warned);
+                                   percussion_chord_warned,
+                                   is_synth);
             }
         } else if (equals_ci(name, "octave")) {
             const char *arg_ptr = skip_spaces(arg_buf);
@@ -867,6 +900,84 @@ static void parse_modifier_chain(const char *text,
                     every_factor = tfactor;
                 }
             }
+        } else if (equals_ci(name, "resample")) {
+            const char *arg_ptr = arg_buf;
+            char quality_text[32];
+            ResampleQuality quality = RESAMPLE_DEFAULT;
+            if (!copy_quoted_string(&arg_ptr, quality_text, sizeof(quality_text), truncated_token_seen)) {
+                warn_once_for_modifier(name, "Warning: .resample() expects a quoted mode like \"cubic\" (ignored)", modifier_warnings);
+            } else if (!resample_quality_from_name(quality_text, &quality)) {
+                fprintf(stderr, "Warning: unknown resample mode '%s' (use nearest, linear, cubic or sinc)\n", quality_text);
+            } else {
+                resample_quality = quality;
+            }
+        } else if (equals_ci(name, "gain") || equals_ci(name, "postgain")) {
+            double value = 0.0;
+            if (!parse_number_arg(arg_buf, &value) || value < 0.0) {
+                warn_once_for_modifier(name, "Warning: gain modifiers expect a non-negative number (ignored)", modifier_warnings);
+            } else {
+                gain *= value;
+            }
+        } else if (equals_ci(name, "pan")) {
+            double value = 0.0;
+            if (!parse_number_arg(arg_buf, &value) || value < 0.0 || value > 1.0) {
+                warn_once_for_modifier(name, "Warning: .pan() expects a number from 0 (left) to 1 (right) (ignored)", modifier_warnings);
+            } else {
+                pan = value;
+                has_pan = true;
+            }
+        } else if (equals_ci(name, "delay") || equals_ci(name, "room")) {
+            int send = equals_ci(name, "delay") ? 0 : 1;
+            double value = 0.0;
+            if (!parse_number_arg(arg_buf, &value) || value < 0.0 || value > 1.0) {
+                warn_once_for_modifier(name, "Warning: send levels expect a number from 0 to 1 (ignored)", modifier_warnings);
+            } else {
+                sends[send] = value;
+                has_send[send] = true;
+            }
+        } else if (is_synth && (equals_ci(name, "attack") || equals_ci(name, "decay") || equals_ci(name, "release"))) {
+            double seconds = 0.0;
+            if (!parse_number_arg(arg_buf, &seconds) || seconds < 0.0 || seconds > 30.0) {
+                warn_once_for_modifier(name, "Warning: envelope times expect seconds between 0 and 30 (ignored)", modifier_warnings);
+            } else if (equals_ci(name, "attack")) {
+                synth.attack = (float)seconds;
+            } else if (equals_ci(name, "decay")) {
+                synth.decay = (float)seconds;
+            } else {
+                synth.release = (float)seconds;
+            }
+        } else if (is_synth && equals_ci(name, "sustain")) {
+            double level = 0.0;
+            if (!parse_number_arg(arg_buf, &level) || level < 0.0 || level > 1.0) {
+                warn_once_for_modifier(name, "Warning: .sustain() expects a level between 0 and 1 (ignored)", modifier_warnings);
+            } else {
+                synth.sustain = (float)level;
+            }
+        } else if (equals_ci(name, "lpf") || equals_ci(name, "cutoff") || equals_ci(name, "hpf")) {
+            double hz = 0.0;
+            if (!parse_number_arg(arg_buf, &hz) || hz < 20.0 || hz > 20000.0) {
+                warn_once_for_modifier(name, "Warning: filter cutoffs expect a frequency between 20 and 20000 Hz (ignored)", modifier_warnings);
+            } else if (equals_ci(name, "hpf")) {
+                filter.hpf = (float)hz;
+            } else {
+                filter.lpf = (float)hz;
+            }
+        } else if (equals_ci(name, "resonance")) {
+            double q = 0.0;
+            if (!parse_number_arg(arg_buf, &q) || q < 0.1 || q > 20.0) {
+                warn_once_for_modifier(name, "Warning: .resonance() expects a Q between 0.1 and 20 (ignored)", modifier_warnings);
+            } else {
+                filter.resonance = (float)q;
+            }
+        } else if (equals_ci(name, "priority")) {
+            const char *arg_ptr = skip_spaces(arg_buf);
+            char *end = NULL;
+            long value = strtol(arg_ptr, &end, 10);
+            if (end == arg_ptr || *skip_spaces(end) != '\0' || value < -100 || value > 100) {
+                warn_once_for_modifier(name, "Warning: .priority() expects an integer between -100 and 100 (ignored)", modifier_warnings);
+            } else {
+                priority = (int)value;
+            }
         } else {
             if (!modifier_warned(modifier_warnings, name)) {
                 fprintf(stderr, "Warning: modifier '%s' is not implemented yet (ignored)\n", name);
@@ -889,6 +1000,10 @@ static void parse_modifier_chain(const char *text,
         for (size_t i = start_index; i < end_index; ++i) {
             pattern->steps[i].chain_id = chain_id;
             pattern->steps[i].time_scale = 1.0;
+            pattern->steps[i].gain *= gain;
+            if (has_pan) pattern->steps[i].pan = pan;
+            if (has_send[0]) pattern->steps[i].delay = sends[0];
+            if (has_send[1]) pattern->steps[i].room = sends[1];
         }
     }
 
@@ -898,6 +1013,10 @@ static void parse_modifier_chain(const char *text,
         chain->every_interval = every_interval;
         chain->every_type = every_type;
         chain->every_factor = every_factor;
+        chain->resample_quality = resample_quality;
+        chain->priority = priority;
+        chain->synth = synth;
+        chain->filter = filter;
     }
 }
 
@@ -1031,6 +1150,41 @@ static bool parse_sample_invocation(const char *line,
     return true;
 }
 
+// Parses @synth("saw") at the start of a line. Returns true when the line is
+// a synth invocation, even if the waveform name was not recognised.
+static bool parse_synth_invocation(const char *line, SynthWaveform *out_waveform, const char **out_rest, bool *truncated_token_seen) {
+    if (!line) return false;
+    const char *p = skip_spaces(line);
+    const char *keyword = "@synth";
+    size_t keyword_len = strlen(keyword);
+    if (strncmp(p, keyword, keyword_len) != 0) return false;
+    p += keyword_len;
+    p = skip_spaces(p);
+    if (*p != '(') {
+        fprintf(stderr, "Warning: @synth must be followed by '('\n");
+        return false;
+    }
+    p++;
+
+    char name[32];
+    if (!copy_quoted_string(&p, name, sizeof(name), truncated_token_seen)) {
+        fprintf(stderr, "Warning: @synth(...) requires a quoted waveform like \"saw\"\n");
+        return false;
+    }
+    p = skip_spaces(p);
+    if (*p != ')') {
+        fprintf(stderr, "Warning: @synth missing closing ')'\n");
+        return false;
+    }
+    if (out_rest) *out_rest = p + 1;
+
+    if (!synth_waveform_from_name(name, out_waveform)) {
+        fprintf(stderr, "Warning: unknown synth waveform '%s' (use saw, square, triangle or sine; using saw)\n", name);
+        *out_waveform = SYNTH_SAW;
+    }
+    return true;
+}
+
 bool pattern_from_lines(char **lines, size_t line_count, const SampleRegistry *default_registry, const SampleRegistry *user_registry, Pattern *out_pattern) {
     if (!out_pattern) return false;
     memset(out_pattern, 0, sizeof(*out_pattern));
@@ -1044,6 +1198,7 @@ bool pattern_from_lines(char **lines, size_t line_count, const SampleRegistry *d
     PatternChain *current_chain = NULL;
     int current_chain_id = -1;
     bool chain_capacity_warned = false;
+    bool skipping_synth_chain = false; // a @synth line found no chain; drop its continuation lines
     ModifierWarningState modifier_warnings = {0};
     bool pitch_clamp_warned = false;
     bool percussion_chord_warned = false;
@@ -1058,7 +1213,18 @@ bool pattern_from_lines(char **lines, size_t line_count, const SampleRegistry *d
 
         SampleRef parsed_sample = {0};
         const char *rest = NULL;
-            if (parse_sample_invocation(trimmed, default_registry, user_registry, &parsed_sample, &rest, &truncated_token_seen)) {
+        SynthWaveform synth_waveform = SYNTH_SAW;
+        bool synth_line = parse_synth_invocation(trimmed, &synth_waveform, &rest, &truncated_token_seen);
+            if (synth_line || parse_sample_invocation(trimmed, default_registry, user_registry, &parsed_sample, &rest, &truncated_token_seen)) {
+                skipping_synth_chain = false;
+                if (synth_line && out_pattern->chain_count >= (sizeof(out_pattern->chains) / sizeof(out_pattern->chains[0]))) {
+                    // Without a chain the notes would compile as sample steps
+                    // with no sample and never sound.
+                    fprintf(stderr, "Warning: maximum chain count reached; skipping @synth line\n");
+                    have_current_sample = false;
+                    skipping_synth_chain = true;
+                    continue;
+                }
                 current_sample = parsed_sample;
                 have_current_sample = true;
                 current_chain = NULL;
@@ -1069,6 +1235,8 @@ bool pattern_from_lines(char **lines, size_t line_count, const SampleRegistry *d
                     *current_chain = (PatternChain){0};
                     current_chain->id = current_chain_id;
                     current_chain->base_time_scale = 1.0;
+                    current_chain->synth = synth_params_init(synth_waveform);
+                    current_chain->is_synth = synth_line;
                 } else if (!chain_capacity_warned) {
                     fprintf(stderr, "Warning: maximum chain count reached; additional chains will ignore tempo transforms\n");
                     chain_capacity_warned = true;
@@ -1089,6 +1257,7 @@ bool pattern_from_lines(char **lines, size_t line_count, const SampleRegistry *d
                 continue;
             }
 
+        if (skipping_synth_chain && trimmed[0] == '.') continue;
         if (have_current_sample && trimmed[0] == '.') {
             parse_modifier_chain(trimmed,
                                  &current_sample,
@@ -1139,9 +1308,10 @@ bool pattern_from_lines(char **lines, size_t line_count, const SampleRegistry *d
                                      note_result,
                                      tone_ref.valid ? &tone_ref : NULL,
                                      &missing_sample_warned,
-                                     true);
+                                     true,
+                                     false);
                 } else {
-                    append_note_step(out_pattern, &note_step, note_result, NULL, &missing_sample_warned, true);
+                    append_note_step(out_pattern, &note_step, note_result, NULL, &missing_sample_warned, true, false);
                 }
                 continue;
             }
@@ -1156,6 +1326,10 @@ bool pattern_from_lines(char **lines, size_t line_count, const SampleRegistry *d
             step.advance_time = true;
             step.chain_id = -1;
             step.time_scale = 1.0;
+            step.gain = 1.0;
+            step.pan = 0.5;
+            step.delay = 0.0;
+            step.room = 0.0;
             add_step(out_pattern, &step);
         }
     }
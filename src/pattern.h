@@ -5,6 +5,11 @@
 #include <stdbool.h>
 
 #include "samplemap.h"
+#include "../audio/filter.h"
+#include "../audio/resample.h"
+#include "../audio/synth.h"
+
+enum { PATTERN_MAX_STEPS = 128 };
 
 typedef struct {
     const SampleRegistry *registry;
@@ -26,6 +31,11 @@ typedef struct {
     int every_interval;
     TimeTransformType every_type;
     int every_factor;
+    ResampleQuality resample_quality;
+    int priority;
+    bool is_synth; // chain started with @synth(...) rather than @sample(...)
+    SynthParams synth;
+    VoiceFilterParams filter;
 } PatternChain;
 
 typedef struct {
@@ -37,10 +47,15 @@ typedef struct {
     bool advance_time;
     int chain_id;
     double time_scale; // reserved for future per-step time transforms
+    double gain;
+    double pan; // 0 = left, 0.5 = centre, 1 = right
+    double delay; // send level to the delay bus
+    double room;  // send level to the reverb bus
+    bool is_synth;
 } PatternStep;
 
 typedef struct {
-    PatternStep steps[128];
+    PatternStep steps[PATTERN_MAX_STEPS];
     size_t step_count;
 
     PatternChain chains[16];
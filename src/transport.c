@@ -4,11 +4,8 @@
 #include <stdatomic.h>
 #include <stdio.h>
 #include <string.h>
-#include <sys/stat.h>
 #include <time.h>
 
-#include "cache.h"
-#include "http_fetch.h"
 static void sleep_ms(int ms) {
     struct timespec ts;
     ts.tv_sec = ms / 1000;
@@ -16,9 +13,10 @@ static void sleep_ms(int ms) {
     nanosleep(&ts, NULL);
 }
 
-static bool file_exists(const char *path) {
-    struct stat st;
-    return path && stat(path, &st) == 0 && S_ISREG(st.st_mode);
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
 }
 
 static const PatternChain *find_chain(const Pattern *pattern, int chain_id) {
@@ -31,6 +29,12 @@ static const PatternChain *find_chain(const Pattern *pattern, int chain_id) {
     return NULL;
 }
 
+// Chain n plays on sub-mix bus n; steps outside a chain share bus 0.
+static uint32_t chain_bus(const PatternChain *chain) {
+    if (!chain || chain->id < 0 || chain->id >= AUDIO_MAX_CHAIN_BUSES) return 0;
+    return (uint32_t)chain->id + 1;
+}
+
 static double chain_time_scale(const Pattern *pattern, const PatternStep *step, uint64_t cycle_number) {
     double scale = (step && step->time_scale > 0.0) ? step->time_scale : 1.0;
     const PatternChain *chain = find_chain(pattern, step ? step->chain_id : -1);
@@ -53,150 +57,139 @@ static double chain_time_scale(const Pattern *pattern, const PatternStep *step,
     return scale;
 }
 
-static const char *variant_value_for_ref(const SampleRef *ref) {
-    if (!ref || !ref->sound) return NULL;
-    const SampleSound *sound = ref->sound;
-    if (sound->pitched_entry_count > 0 && sound->pitched_variants && ref->variant_index < sound->pitched_entry_count) {
-        return sound->pitched_variants[ref->variant_index];
-    }
-    if (sound->variant_count > 0 && sound->variants && ref->variant_index < sound->variant_count) {
-        return sound->variants[ref->variant_index];
-    }
-    return NULL;
-}
-
-static bool build_variant_url(const SampleRef *ref, char *out, size_t out_len) {
-    if (!ref || !ref->sound || ref->variant_index >= ref->sound->variant_count || !out || out_len == 0) return false;
-    const char *variant = variant_value_for_ref(ref);
-    if (!variant || variant[0] == '\0') return false;
-
-    if (strncmp(variant, "http://", 7) == 0 || strncmp(variant, "https://", 8) == 0 || strncmp(variant, "file://", 7) == 0 || variant[0] == '/' || variant[0] == '.') {
-        return snprintf(out, out_len, "%s", variant) < (int)out_len;
-    }
-
-    const char *base = (ref->registry && ref->registry->base) ? ref->registry->base : NULL;
-    if (base && base[0]) {
-        size_t base_len = strlen(base);
-        bool needs_slash = base_len > 0 && base[base_len - 1] != '/' && variant[0] != '/';
-        if (needs_slash) {
-            return snprintf(out, out_len, "%s/%s", base, variant) < (int)out_len;
-        }
-        return snprintf(out, out_len, "%s%s", base, variant) < (int)out_len;
-    }
-
-    return snprintf(out, out_len, "%s", variant) < (int)out_len;
-}
-
-static bool is_remote_url(const char *url) {
-    return url && (strncmp(url, "http://", 7) == 0 || strncmp(url, "https://", 8) == 0);
-}
-
-static const AudioSample *load_builtin_tone(Transport *t) {
-    if (!t) return NULL;
-    const char *key = "builtin:tone";
-    for (size_t i = 0; i < t->sample_cache_count; ++i) {
-        if (t->sample_cache[i].loaded && strcmp(t->sample_cache[i].key, key) == 0) {
-            return &t->sample_cache[i].sample;
-        }
-    }
-
-    if (t->sample_cache_count >= sizeof(t->sample_cache) / sizeof(t->sample_cache[0])) {
-        return NULL;
+// Pushes an event into the engine's ring; the batch is committed by
+// transport_schedule. On a full ring the step is held back rather than lost.
+static bool push_event(Transport *t, const ScheduledEvent *event) {
+    if (audio_engine_queue_push(t->audio, event)) {
+        t->queue_full = false;
+        return true;
     }
-
-    AudioSample sample;
-    if (!audio_sample_generate_sine(&sample, 1.5, t->audio ? t->audio->sample_rate : 48000, 440.0)) {
-        return NULL;
+    if (!t->queue_full) {
+        fprintf(stderr, "Warning: event queue full (%u slots); holding back scheduling\n", t->audio->ring.capacity);
+        t->queue_full_count++;
     }
-
-    size_t slot = t->sample_cache_count++;
-    t->sample_cache[slot].loaded = true;
-    snprintf(t->sample_cache[slot].key, sizeof(t->sample_cache[slot].key), "%s", key);
-    t->sample_cache[slot].sample = sample;
-    return &t->sample_cache[slot].sample;
+    t->queue_full = true;
+    return false;
 }
 
-static bool ensure_cached_sample(const char *url, char *out_path, size_t out_len) {
-    if (!url || !out_path || out_len == 0) return false;
-    if (!cache_path_for_key_with_ext(url, ".wav", out_path, out_len)) return false;
-    if (file_exists(out_path)) return true;
-
-    char *buffer = NULL;
-    size_t len = 0;
-    if (!http_fetch_to_buffer(url, &buffer, &len)) return false;
-    bool ok = cache_write(out_path, buffer, len);
-    free(buffer);
-    return ok;
+// Synth steps need no sample data: the event carries the chain's patch and
+// the note's frequency, and the note length becomes the gate.
+static bool schedule_synth_step(Transport *t, const Pattern *pattern, const PatternStep *step, double duration_beats) {
+    const PatternChain *chain = find_chain(pattern, step->chain_id);
+    if (!chain || !chain->is_synth) return true;
+    uint64_t start_frame = (uint64_t)(t->next_event_time * (double)t->audio->sample_rate);
+    uint64_t gate_frames = (uint64_t)(duration_beats * t->seconds_per_beat * (double)t->audio->sample_rate);
+    ScheduledEvent event = audio_scheduled_event_init(NULL, start_frame);
+    event.is_synth = true;
+    event.synth = chain->synth;
+    event.frequency = synth_frequency_from_midi(step->has_midi_note ? step->midi_note : 60);
+    event.note_duration_frames = gate_frames > 0 ? gate_frames : 1;
+    event.priority = chain->priority;
+    event.gain = (float)step->gain;
+    event.pan = (float)step->pan;
+    event.delay = (float)step->delay;
+    event.room = (float)step->room;
+    event.filter = chain->filter;
+    event.bus = chain_bus(chain);
+    return push_event(t, &event);
 }
 
-static const AudioSample *load_sample_for_ref(Transport *t, const SampleRef *ref) {
-    if (!t || !ref || !ref->valid) return NULL;
-    if (!ref->sound || ref->variant_index >= ref->sound->variant_count) return NULL;
-
-    if (ref->sound->name && strcmp(ref->sound->name, "tone") == 0) {
-        const AudioSample *tone = load_builtin_tone(t);
-        if (tone) return tone;
-    }
-
-    const char *registry_name = (ref->registry && ref->registry->name) ? ref->registry->name : "default";
-    char cache_key[256];
-    if (snprintf(cache_key, sizeof(cache_key), "%s:%s:%zu", registry_name, ref->sound->name, ref->variant_index) >= (int)sizeof(cache_key)) {
-        return NULL;
-    }
-
-    for (size_t i = 0; i < t->sample_cache_count; ++i) {
-        if (t->sample_cache[i].loaded && strcmp(t->sample_cache[i].key, cache_key) == 0) {
-            return &t->sample_cache[i].sample;
+bool transport_schedule(Transport *t, double horizon, uint64_t max_cycles) {
+    size_t active = atomic_load(&t->active_pattern) % 2;
+    Pattern *pattern = &t->patterns[active];
+    const SampleSet *set = &t->sample_sets[active];
+    if (pattern->step_count == 0) return max_cycles > 0;
+
+    while (t->next_event_time <= horizon) {
+        if (max_cycles > 0 && t->cycle_count >= max_cycles) break;
+        PatternStep *step = &pattern->steps[t->next_step];
+        // cycle_number represents the upcoming pattern-cycle boundary: one full wrap
+        // through the compiled step list. .every() uses this global counter, not a
+        // per-chain or per-bar metric.
+        uint64_t cycle_number = t->cycle_count + 1;
+        double scaled_duration_beats = step->duration_beats * chain_time_scale(pattern, step, cycle_number);
+        if (step->is_synth) {
+            if (!schedule_synth_step(t, pattern, step, scaled_duration_beats)) break;
+        } else if (step->sample.valid) {
+            // NULL while the sample is still loading: the step stays silent.
+            const AudioSample *sample = sample_loader_get(&t->loader, set, t->next_step);
+            if (sample) {
+                uint64_t start_frame = (uint64_t)(t->next_event_time * (double)t->audio->sample_rate);
+                uint64_t note_duration_frames = 0;
+                if (step->has_midi_note) {
+                    double seconds = scaled_duration_beats * t->seconds_per_beat;
+                    note_duration_frames = (uint64_t)(seconds * (double)t->audio->sample_rate);
+                    if (note_duration_frames == 0) {
+                        note_duration_frames = 1;
+                    }
+                }
+                const PatternChain *chain = find_chain(pattern, step->chain_id);
+                ScheduledEvent event = audio_scheduled_event_init(sample, start_frame);
+                event.playback_rate = step->playback_rate > 0.0 ? step->playback_rate : 1.0;
+                event.is_pitched = step->has_midi_note;
+                event.note_duration_frames = note_duration_frames;
+                event.resample_quality = chain ? chain->resample_quality : RESAMPLE_DEFAULT;
+                event.priority = chain ? chain->priority : 0;
+                event.gain = (float)step->gain;
+                event.pan = (float)step->pan;
+                event.delay = (float)step->delay;
+                event.room = (float)step->room;
+                if (chain) event.filter = chain->filter;
+                event.bus = chain_bus(chain);
+                if (!push_event(t, &event)) break;
+            }
         }
-    }
-
-    if (t->sample_cache_count >= sizeof(t->sample_cache) / sizeof(t->sample_cache[0])) {
-        return NULL;
-    }
-
-    char url[512];
-    if (!build_variant_url(ref, url, sizeof(url))) {
-        return (t->sample_count > 0) ? &t->samples[0] : NULL;
-    }
-
-    char path[512];
-    bool remote = is_remote_url(url);
-    if (remote) {
-        if (!ensure_cached_sample(url, path, sizeof(path))) {
-            return (t->sample_count > 0) ? &t->samples[0] : NULL;
+        if (step->advance_time) {
+            t->next_event_time += scaled_duration_beats * t->seconds_per_beat;
         }
-    } else {
-        if (snprintf(path, sizeof(path), "%s", url) >= (int)sizeof(path) || !file_exists(path)) {
-            return (t->sample_count > 0) ? &t->samples[0] : NULL;
+        t->next_step = (t->next_step + 1) % pattern->step_count;
+        if (t->next_step == 0) {
+            // Completed one full pattern cycle (wrap from last step back to step 0).
+            t->cycle_count++;
         }
     }
+    audio_engine_queue_commit(t->audio);
+    return max_cycles > 0 && t->cycle_count >= max_cycles;
+}
 
-    AudioSample sample;
-    if (!audio_sample_from_wav(path, &sample)) {
-        return (t->sample_count > 0) ? &t->samples[0] : NULL;
-    }
-
-    size_t slot = t->sample_cache_count++;
-    t->sample_cache[slot].loaded = true;
-    snprintf(t->sample_cache[slot].key, sizeof(t->sample_cache[slot].key), "%s", cache_key);
-    t->sample_cache[slot].sample = sample;
-    return &t->sample_cache[slot].sample;
+// Makes pattern the active one and restarts it from its first step. The
+// transport takes over set; the outgoing pattern's samples are unpinned.
+static void arm_pattern(Transport *t, const Pattern *pattern, const SampleSet *set) {
+    size_t current = atomic_load(&t->active_pattern) % 2;
+    size_t next = (current + 1) % 2;
+    t->patterns[next] = *pattern;
+    t->sample_sets[next] = *set;
+    atomic_store(&t->active_pattern, next);
+    sample_loader_release(&t->loader, &t->sample_sets[current]);
+    t->next_step = 0;
+    t->next_event_time = audio_engine_time_seconds(t->audio);
+    t->cycle_count = 0;
+    t->queue_full = false;
 }
 
-static void free_cached_samples(Transport *t) {
-    if (!t) return;
-    for (size_t i = 0; i < t->sample_cache_count; ++i) {
-        if (t->sample_cache[i].loaded) {
-            audio_sample_free(&t->sample_cache[i].sample);
-            t->sample_cache[i].loaded = false;
+// Arms the parked pattern once its samples are resident or it has waited
+// arm_timeout seconds. Runs on the scheduling thread.
+static void arm_pending_pattern(Transport *t) {
+    pthread_mutex_lock(&t->pending_lock);
+    if (t->has_pending) {
+        bool timed_out = t->arm_timeout >= 0.0 && monotonic_seconds() - t->pending_since >= t->arm_timeout;
+        size_t loading = sample_loader_pending(&t->loader, &t->pending_set);
+        if (loading == 0 || timed_out) {
+            if (loading > 0) {
+                fprintf(stderr, "Warning: starting the pattern with %zu sample(s) still loading; they join when ready\n", loading);
+            }
+            arm_pattern(t, &t->pending, &t->pending_set);
+            t->has_pending = false;
         }
     }
-    t->sample_cache_count = 0;
+    pthread_mutex_unlock(&t->pending_lock);
 }
 
 static void *transport_thread(void *user) {
     Transport *t = (Transport *)user;
     while (atomic_load(&t->running)) {
+        arm_pending_pattern(t);
+        audio_epoch_collect(&t->audio->epoch);
         if (!atomic_load(&t->playing)) {
             sleep_ms(10);
             continue;
@@ -209,89 +202,97 @@ static void *transport_thread(void *user) {
         }
 
         double now = audio_engine_time_seconds(t->audio);
-        double horizon = now + 0.2;
         if (t->next_event_time < now) {
             t->next_event_time = now;
         }
-
-        while (t->next_event_time <= horizon) {
-            PatternStep *step = &pattern->steps[t->next_step];
-            // cycle_number represents the upcoming pattern-cycle boundary: one full wrap
-            // through the compiled step list. .every() uses this global counter, not a
-            // per-chain or per-bar metric.
-            uint64_t cycle_number = t->cycle_count + 1;
-            double scaled_duration_beats = step->duration_beats * chain_time_scale(pattern, step, cycle_number);
-            if (step->sample.valid) {
-                const AudioSample *sample = load_sample_for_ref(t, &step->sample);
-                if (sample) {
-                    uint64_t start_frame = (uint64_t)(t->next_event_time * (double)t->audio->sample_rate);
-                    uint64_t note_duration_frames = 0;
-                    if (step->has_midi_note) {
-                        double seconds = scaled_duration_beats * t->seconds_per_beat;
-                        note_duration_frames = (uint64_t)(seconds * (double)t->audio->sample_rate);
-                        if (note_duration_frames == 0) {
-                            note_duration_frames = 1;
-                        }
-                    }
-                    audio_engine_queue_rate(t->audio,
-                                            sample,
-                                            start_frame,
-                                            step->playback_rate > 0.0 ? step->playback_rate : 1.0,
-                                            step->has_midi_note,
-                                            note_duration_frames);
-                }
-            }
-            if (step->advance_time) {
-                t->next_event_time += scaled_duration_beats * t->seconds_per_beat;
-            }
-            t->next_step = (t->next_step + 1) % pattern->step_count;
-            if (t->next_step == 0) {
-                // Completed one full pattern cycle (wrap from last step back to step 0).
-                t->cycle_count++;
-            }
-        }
+        transport_schedule(t, now + 0.2, 0);
 
         sleep_ms(10);
     }
     return NULL;
 }
 
-bool transport_start(Transport *transport, AudioEngine *audio, AudioSample *samples, size_t sample_count, double bpm) {
+bool transport_init(Transport *transport,
+                    AudioEngine *audio,
+                    AudioSample *samples,
+                    size_t sample_count,
+                    double bpm,
+                    uint32_t loader_threads,
+                    double arm_timeout) {
     memset(transport, 0, sizeof(*transport));
     transport->audio = audio;
     transport->samples = samples;
     transport->sample_count = sample_count;
     transport->seconds_per_beat = 60.0 / bpm;
     atomic_store(&transport->active_pattern, 0);
-    atomic_store(&transport->running, true);
+    atomic_store(&transport->running, false);
     atomic_store(&transport->playing, false);
     transport->next_event_time = 0.0;
     transport->next_step = 0;
     transport->cycle_count = 0;
-    transport->sample_cache_count = 0;
+    transport->arm_timeout = arm_timeout;
+    if (!sample_loader_init(&transport->loader, loader_threads, audio->sample_rate, sample_count > 0 ? &samples[0] : NULL,
+                            &audio->epoch)) {
+        fprintf(stderr, "Failed to start the sample loader\n");
+        return false;
+    }
+    pthread_mutex_init(&transport->pending_lock, NULL);
+    return true;
+}
 
+bool transport_start(Transport *transport,
+                     AudioEngine *audio,
+                     AudioSample *samples,
+                     size_t sample_count,
+                     double bpm,
+                     uint32_t loader_threads,
+                     double arm_timeout) {
+    if (!transport_init(transport, audio, samples, sample_count, bpm, loader_threads, arm_timeout)) return false;
+    atomic_store(&transport->running, true);
     if (pthread_create(&transport->thread, NULL, transport_thread, transport) != 0) {
         atomic_store(&transport->running, false);
+        transport_stop(transport);
         return false;
     }
+    transport->thread_started = true;
     return true;
 }
 
 void transport_stop(Transport *transport) {
     if (!transport) return;
     atomic_store(&transport->running, false);
-    pthread_join(transport->thread, NULL);
-    free_cached_samples(transport);
+    if (transport->thread_started) {
+        pthread_join(transport->thread, NULL);
+        transport->thread_started = false;
+    }
+    sample_loader_shutdown(&transport->loader);
+    pthread_mutex_destroy(&transport->pending_lock);
 }
 
-void transport_set_pattern(Transport *transport, const Pattern *pattern) {
-    if (!transport || !pattern) return;
-    size_t next = (atomic_load(&transport->active_pattern) + 1) % 2;
-    transport->patterns[next] = *pattern;
-    atomic_store(&transport->active_pattern, next);
-    transport->next_step = 0;
-    transport->next_event_time = audio_engine_time_seconds(transport->audio);
-    transport->cycle_count = 0;
+size_t transport_set_pattern(Transport *transport, const Pattern *pattern) {
+    if (!transport || !pattern) return 0;
+    SampleSet set;
+    size_t loading = sample_loader_acquire(&transport->loader, pattern, &set);
+    pthread_mutex_lock(&transport->pending_lock);
+    // A pattern replaced before it was armed gives its samples back.
+    if (transport->has_pending) sample_loader_release(&transport->loader, &transport->pending_set);
+    transport->pending = *pattern;
+    transport->pending_set = set;
+    transport->has_pending = true;
+    transport->pending_since = monotonic_seconds();
+    pthread_mutex_unlock(&transport->pending_lock);
+    return loading;
+}
+
+void transport_wait_pattern(Transport *transport) {
+    if (!transport) return;
+    pthread_mutex_lock(&transport->pending_lock);
+    if (transport->has_pending) {
+        sample_loader_wait(&transport->loader, &transport->pending_set, -1.0);
+        arm_pattern(transport, &transport->pending, &transport->pending_set);
+        transport->has_pending = false;
+    }
+    pthread_mutex_unlock(&transport->pending_lock);
 }
 
 void transport_play(Transport *transport) {
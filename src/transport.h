@@ -7,6 +7,7 @@
 #include <stdint.h>
 
 #include "../audio/audio.h"
+#include "loader.h"
 #include "pattern.h"
 
 typedef struct {
@@ -16,6 +17,7 @@ typedef struct {
     double seconds_per_beat;
 
     Pattern patterns[2];
+    SampleSet sample_sets[2]; // each pattern's samples, pinned while it plays
     _Atomic size_t active_pattern;
 
     _Atomic bool running;
@@ -25,21 +27,59 @@ typedef struct {
     size_t next_step;
     uint64_t cycle_count; // counts completed pattern cycles (full wraps through the step list)
 
-    struct {
-        char key[256];
-        AudioSample sample;
-        bool loaded;
-    } sample_cache[128];
-    size_t sample_cache_count;
+    // Set while the event ring is full: scheduling stops at the step that did
+    // not fit and resumes from it once the audio thread has drained the ring.
+    bool queue_full;
+    uint64_t queue_full_count; // times scheduling was held back
+
+    SampleLoader loader;
+
+    // A new pattern waits here while its samples load. The scheduling thread
+    // arms it once they are all resident, or after arm_timeout seconds.
+    pthread_mutex_t pending_lock;
+    Pattern pending;
+    SampleSet pending_set;
+    bool has_pending;
+    double pending_since;
+    double arm_timeout; // negative waits for every sample
 
     pthread_t thread;
+    bool thread_started;
 } Transport;
 
-bool transport_start(Transport *transport, AudioEngine *audio, AudioSample *samples, size_t sample_count, double bpm);
+// Prepares the transport and its sample loader threads, but not the
+// scheduling thread, for callers that drive transport_schedule themselves
+// (offline rendering). samples[0] stands in for sounds that fail to load.
+bool transport_init(Transport *transport,
+                    AudioEngine *audio,
+                    AudioSample *samples,
+                    size_t sample_count,
+                    double bpm,
+                    uint32_t loader_threads,
+                    double arm_timeout);
+bool transport_start(Transport *transport,
+                     AudioEngine *audio,
+                     AudioSample *samples,
+                     size_t sample_count,
+                     double bpm,
+                     uint32_t loader_threads,
+                     double arm_timeout);
+// Stops scheduling and loading. Call before audio_engine_shutdown: samples
+// are handed to the engine, which frees them once the audio thread stops.
 void transport_stop(Transport *transport);
-void transport_set_pattern(Transport *transport, const Pattern *pattern);
+// Starts loading the pattern's samples and parks it until they are resident
+// (see arm_timeout). Returns how many samples are still loading.
+size_t transport_set_pattern(Transport *transport, const Pattern *pattern);
+// Blocks until the parked pattern's samples have loaded, then arms it.
+void transport_wait_pattern(Transport *transport);
 void transport_play(Transport *transport);
 void transport_pause(Transport *transport);
 void transport_panic(Transport *transport);
+// Queues every step of the active pattern that starts at or before horizon
+// (seconds of engine time) and publishes them as one batch. With
+// max_cycles > 0, stops once that many full cycles have been queued and
+// returns true. If the event ring fills up, returns early with queue_full set
+// and picks up from the same step on the next call.
+bool transport_schedule(Transport *transport, double horizon, uint64_t max_cycles);
 
 #endif // MUSIKA_TRANSPORT_H
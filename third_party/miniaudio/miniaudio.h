@@ -3,16 +3,21 @@
 
 // Minimal embedded subset inspired by miniaudio. Provides a small cross-platform
 // audio device wrapper that opens the default playback device on Linux (ALSA via
-// dynamic loading) and macOS (AudioQueue). Only the pieces needed by Musika are
+// dynamic loading) and macOS (AudioQueue). Two device-less backends run the
+// callback from a real-time paced thread instead: `null` discards the output and
+// `file` streams it to a float WAV. Only the pieces needed by Musika are
 // implemented.
 
 #include <stdint.h>
 #include <stddef.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <dlfcn.h>
+#include <stdio.h>
+#include <time.h>
 
 #if defined(__APPLE__)
 #include <AudioToolbox/AudioQueue.h>
@@ -30,8 +35,14 @@ typedef uint32_t ma_uint32;
 typedef uint64_t ma_uint64;
 typedef int32_t ma_int32;
 
+typedef enum ma_backend {
+    ma_backend_default = 0, // the platform's playback device
+    ma_backend_null,
+    ma_backend_file,
+} ma_backend;
+
 typedef struct ma_context {
-    int placeholder;
+    ma_backend backend;
 } ma_context;
 
 struct ma_device;
@@ -39,26 +50,32 @@ typedef void (*ma_device_callback_proc)(struct ma_device *pDevice, void *pOutput
 
 typedef struct ma_device_config {
     ma_uint32 sampleRate;
-    ma_uint32 periodSizeInFrames;
+    ma_uint32 periodSizeInFrames; // requested; the device may round it
+    ma_uint32 periods;            // periods in the device buffer
     ma_uint32 channels;
     ma_device_callback_proc dataCallback;
     void *pUserData;
+    const char *pFilePath;   // output for ma_backend_file
+    const char *pDeviceName; // ALSA PCM name; NULL opens "default"
 } ma_device_config;
 
 static inline ma_device_config ma_device_config_init(ma_uint32 channels, ma_uint32 sampleRate) {
     ma_device_config cfg;
     cfg.sampleRate = sampleRate ? sampleRate : 48000;
     cfg.periodSizeInFrames = 512;
+    cfg.periods = 3;
     cfg.channels = channels ? channels : 2;
     cfg.dataCallback = NULL;
     cfg.pUserData = NULL;
+    cfg.pFilePath = NULL;
+    cfg.pDeviceName = NULL;
     return cfg;
 }
 
-static inline ma_result ma_context_init(void *pCallbacks, ma_uint32 flags, ma_context *pContext) {
-    (void)pCallbacks;
-    (void)flags;
-    (void)pContext;
+// Uses the first listed backend, or the platform device when none is given.
+static inline ma_result ma_context_init(const ma_backend *pBackends, ma_uint32 backendCount, ma_context *pContext) {
+    if (!pContext) return -1;
+    pContext->backend = (pBackends && backendCount > 0) ? pBackends[0] : ma_backend_default;
     return 0;
 }
 
@@ -71,16 +88,48 @@ static inline void ma_context_uninit(ma_context *pContext) {
 #include <sound/asound.h>
 
 typedef struct _snd_pcm snd_pcm_t;
+typedef struct _snd_pcm_hw_params snd_pcm_hw_params_t;
+typedef struct _snd_pcm_sw_params snd_pcm_sw_params_t;
 typedef long snd_pcm_sframes_t;
 typedef unsigned long snd_pcm_uframes_t;
+typedef struct {
+    void *addr;
+    unsigned int first; // bits
+    unsigned int step;  // bits
+} snd_pcm_channel_area_t;
 
 typedef struct ma__alsa_api {
     void *handle;
     int (*open)(snd_pcm_t **, const char *, int, int);
     int (*close)(snd_pcm_t *);
     int (*prepare)(snd_pcm_t *);
+    int (*start)(snd_pcm_t *);
+    int (*drop)(snd_pcm_t *);
+    int (*recover)(snd_pcm_t *, int, int);
+    int (*wait)(snd_pcm_t *, int);
+    snd_pcm_state_t (*state)(snd_pcm_t *);
+    snd_pcm_sframes_t (*avail_update)(snd_pcm_t *);
     snd_pcm_sframes_t (*writei)(snd_pcm_t *, const void *, snd_pcm_uframes_t);
-    int (*set_params)(snd_pcm_t *, snd_pcm_format_t, snd_pcm_access_t, unsigned int, unsigned int, int, unsigned int);
+    int (*mmap_begin)(snd_pcm_t *, const snd_pcm_channel_area_t **, snd_pcm_uframes_t *, snd_pcm_uframes_t *);
+    snd_pcm_sframes_t (*mmap_commit)(snd_pcm_t *, snd_pcm_uframes_t, snd_pcm_uframes_t);
+    int (*hw_malloc)(snd_pcm_hw_params_t **);
+    void (*hw_free)(snd_pcm_hw_params_t *);
+    int (*hw_any)(snd_pcm_t *, snd_pcm_hw_params_t *);
+    int (*hw_set_access)(snd_pcm_t *, snd_pcm_hw_params_t *, snd_pcm_access_t);
+    int (*hw_set_format)(snd_pcm_t *, snd_pcm_hw_params_t *, snd_pcm_format_t);
+    int (*hw_set_channels)(snd_pcm_t *, snd_pcm_hw_params_t *, unsigned int);
+    int (*hw_set_rate_near)(snd_pcm_t *, snd_pcm_hw_params_t *, unsigned int *, int *);
+    int (*hw_set_period_size_near)(snd_pcm_t *, snd_pcm_hw_params_t *, snd_pcm_uframes_t *, int *);
+    int (*hw_set_periods_near)(snd_pcm_t *, snd_pcm_hw_params_t *, unsigned int *, int *);
+    int (*hw_params)(snd_pcm_t *, snd_pcm_hw_params_t *);
+    int (*hw_get_period_size)(const snd_pcm_hw_params_t *, snd_pcm_uframes_t *, int *);
+    int (*hw_get_buffer_size)(const snd_pcm_hw_params_t *, snd_pcm_uframes_t *);
+    int (*sw_malloc)(snd_pcm_sw_params_t **);
+    void (*sw_free)(snd_pcm_sw_params_t *);
+    int (*sw_current)(snd_pcm_t *, snd_pcm_sw_params_t *);
+    int (*sw_set_start_threshold)(snd_pcm_t *, snd_pcm_sw_params_t *, snd_pcm_uframes_t);
+    int (*sw_set_avail_min)(snd_pcm_t *, snd_pcm_sw_params_t *, snd_pcm_uframes_t);
+    int (*sw_params)(snd_pcm_t *, snd_pcm_sw_params_t *);
 } ma__alsa_api;
 #endif
 
@@ -94,36 +143,144 @@ typedef struct ma__aq_state {
 
 typedef struct ma_device {
     ma_device_config config;
-    int running;
+    ma_backend backend;
+    _Atomic int running; // cleared by ma_device_stop while the device thread polls it
     pthread_t thread;
+    float *mix_buffer;
+    FILE *file;           // ma_backend_file
+    ma_uint64 fileFrames;
+    ma_uint32 xrunCount; // underruns so far; written and read on the device thread
 #if defined(__linux__)
     ma__alsa_api alsa;
     snd_pcm_t *pcm;
-    float *mix_buffer;
+    int mmap; // rendering straight into the device buffer
 #elif defined(__APPLE__)
     ma__aq_state aq;
     void *userData;
-#else
-    float *mix_buffer;
 #endif
     void *pUserData;
 } ma_device;
 
+// --- Null and file backends: a thread paced by the monotonic clock ---
+static void ma__put_le32(unsigned char *p, ma_uint32 v) {
+    p[0] = (unsigned char)(v & 0xFF);
+    p[1] = (unsigned char)((v >> 8) & 0xFF);
+    p[2] = (unsigned char)((v >> 16) & 0xFF);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+// 32-bit float WAV header; sizes are patched when the device is closed.
+static int ma__write_wav_header(FILE *f, ma_uint32 channels, ma_uint32 sampleRate, ma_uint64 frames) {
+    unsigned char h[44];
+    ma_uint64 data_bytes = frames * channels * sizeof(float);
+    if (data_bytes > 0xFFFFFFFFull - 36) data_bytes = 0xFFFFFFFFull - 36;
+    memcpy(h, "RIFF", 4);
+    ma__put_le32(h + 4, (ma_uint32)(36 + data_bytes));
+    memcpy(h + 8, "WAVEfmt ", 8);
+    ma__put_le32(h + 16, 16);
+    h[20] = 3; // IEEE float
+    h[21] = 0;
+    h[22] = (unsigned char)channels;
+    h[23] = 0;
+    ma__put_le32(h + 24, sampleRate);
+    ma__put_le32(h + 28, sampleRate * channels * (ma_uint32)sizeof(float));
+    h[32] = (unsigned char)(channels * sizeof(float));
+    h[33] = 0;
+    h[34] = 32;
+    h[35] = 0;
+    memcpy(h + 36, "data", 4);
+    ma__put_le32(h + 40, (ma_uint32)data_bytes);
+    return fwrite(h, 1, sizeof(h), f) == sizeof(h) ? 0 : -1;
+}
+
+static void *ma__device_thread_timer(void *user) {
+    ma_device *dev = (ma_device *)user;
+    const ma_uint32 frames = dev->config.periodSizeInFrames;
+    const ma_uint32 channels = dev->config.channels;
+    const size_t sample_count = (size_t)frames * channels;
+    const long long period_ns = (long long)frames * 1000000000LL / dev->config.sampleRate;
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    while (dev->running) {
+        memset(dev->mix_buffer, 0, sample_count * sizeof(float));
+        if (dev->config.dataCallback) {
+            dev->config.dataCallback(dev, dev->mix_buffer, NULL, frames);
+        }
+        if (dev->file && fwrite(dev->mix_buffer, sizeof(float), sample_count, dev->file) == sample_count) {
+            dev->fileFrames += frames;
+        }
+
+        long long ns = (long long)deadline.tv_nsec + period_ns;
+        deadline.tv_sec += (time_t)(ns / 1000000000LL);
+        deadline.tv_nsec = (long)(ns % 1000000000LL);
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long long behind = (long long)(now.tv_sec - deadline.tv_sec) * 1000000000LL + (now.tv_nsec - deadline.tv_nsec);
+        if (behind > 4 * period_ns) {
+            deadline = now; // fell far behind (e.g. suspended): resync instead of bursting
+            dev->xrunCount++;
+            continue;
+        }
+        if (behind < 0) {
+            // Sleeping toward an absolute deadline keeps the average rate exact.
+            struct timespec wait;
+            wait.tv_sec = (time_t)(-behind / 1000000000LL);
+            wait.tv_nsec = (long)(-behind % 1000000000LL);
+            nanosleep(&wait, NULL);
+        }
+    }
+    return NULL;
+}
+
 #if defined(__linux__)
 static int ma__load_alsa(ma__alsa_api *api) {
     if (!api) return -1;
     memset(api, 0, sizeof(*api));
     api->handle = dlopen("libasound.so.2", RTLD_LAZY);
     if (!api->handle) return -1;
-    *(void **)(&api->open) = dlsym(api->handle, "snd_pcm_open");
-    *(void **)(&api->close) = dlsym(api->handle, "snd_pcm_close");
-    *(void **)(&api->prepare) = dlsym(api->handle, "snd_pcm_prepare");
-    *(void **)(&api->writei) = dlsym(api->handle, "snd_pcm_writei");
-    *(void **)(&api->set_params) = dlsym(api->handle, "snd_pcm_set_params");
-    if (!api->open || !api->close || !api->prepare || !api->writei || !api->set_params) {
-        dlclose(api->handle);
-        memset(api, 0, sizeof(*api));
-        return -1;
+    const struct {
+        void *fn;
+        const char *name;
+    } symbols[] = {
+        {&api->open, "snd_pcm_open"},
+        {&api->close, "snd_pcm_close"},
+        {&api->prepare, "snd_pcm_prepare"},
+        {&api->start, "snd_pcm_start"},
+        {&api->drop, "snd_pcm_drop"},
+        {&api->recover, "snd_pcm_recover"},
+        {&api->wait, "snd_pcm_wait"},
+        {&api->state, "snd_pcm_state"},
+        {&api->avail_update, "snd_pcm_avail_update"},
+        {&api->writei, "snd_pcm_writei"},
+        {&api->mmap_begin, "snd_pcm_mmap_begin"},
+        {&api->mmap_commit, "snd_pcm_mmap_commit"},
+        {&api->hw_malloc, "snd_pcm_hw_params_malloc"},
+        {&api->hw_free, "snd_pcm_hw_params_free"},
+        {&api->hw_any, "snd_pcm_hw_params_any"},
+        {&api->hw_set_access, "snd_pcm_hw_params_set_access"},
+        {&api->hw_set_format, "snd_pcm_hw_params_set_format"},
+        {&api->hw_set_channels, "snd_pcm_hw_params_set_channels"},
+        {&api->hw_set_rate_near, "snd_pcm_hw_params_set_rate_near"},
+        {&api->hw_set_period_size_near, "snd_pcm_hw_params_set_period_size_near"},
+        {&api->hw_set_periods_near, "snd_pcm_hw_params_set_periods_near"},
+        {&api->hw_params, "snd_pcm_hw_params"},
+        {&api->hw_get_period_size, "snd_pcm_hw_params_get_period_size"},
+        {&api->hw_get_buffer_size, "snd_pcm_hw_params_get_buffer_size"},
+        {&api->sw_malloc, "snd_pcm_sw_params_malloc"},
+        {&api->sw_free, "snd_pcm_sw_params_free"},
+        {&api->sw_current, "snd_pcm_sw_params_current"},
+        {&api->sw_set_start_threshold, "snd_pcm_sw_params_set_start_threshold"},
+        {&api->sw_set_avail_min, "snd_pcm_sw_params_set_avail_min"},
+        {&api->sw_params, "snd_pcm_sw_params"},
+    };
+    for (size_t i = 0; i < sizeof(symbols) / sizeof(symbols[0]); ++i) {
+        void *sym = dlsym(api->handle, symbols[i].name);
+        if (!sym) {
+            dlclose(api->handle);
+            memset(api, 0, sizeof(*api));
+            return -1;
+        }
+        memcpy(symbols[i].fn, &sym, sizeof(sym));
     }
     return 0;
 }
@@ -134,21 +291,132 @@ static void ma__unload_alsa(ma__alsa_api *api) {
     memset(api, 0, sizeof(*api));
 }
 
-static void *ma__device_thread_alsa(void *user) {
-    ma_device *dev = (ma_device *)user;
+// Negotiates float interleaved output with the requested period size and
+// count, preferring mmap access. Writes the granted values back into the
+// device config.
+static int ma__alsa_configure(ma_device *dev) {
+    ma__alsa_api *a = &dev->alsa;
+    snd_pcm_hw_params_t *hw = NULL;
+    snd_pcm_sw_params_t *sw = NULL;
+    int result = -1;
+    if (a->hw_malloc(&hw) < 0 || a->sw_malloc(&sw) < 0) goto done;
+
+    if (a->hw_any(dev->pcm, hw) < 0) goto done;
+    dev->mmap = a->hw_set_access(dev->pcm, hw, SNDRV_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+    if (!dev->mmap && a->hw_set_access(dev->pcm, hw, SNDRV_PCM_ACCESS_RW_INTERLEAVED) < 0) goto done;
+    if (a->hw_set_format(dev->pcm, hw, SNDRV_PCM_FORMAT_FLOAT_LE) < 0) goto done;
+    if (a->hw_set_channels(dev->pcm, hw, dev->config.channels) < 0) goto done;
+    unsigned int rate = dev->config.sampleRate;
+    if (a->hw_set_rate_near(dev->pcm, hw, &rate, NULL) < 0) goto done;
+    snd_pcm_uframes_t period = dev->config.periodSizeInFrames;
+    if (a->hw_set_period_size_near(dev->pcm, hw, &period, NULL) < 0) goto done;
+    unsigned int periods = dev->config.periods >= 2 ? dev->config.periods : 2;
+    if (a->hw_set_periods_near(dev->pcm, hw, &periods, NULL) < 0) goto done;
+    if (a->hw_params(dev->pcm, hw) < 0) goto done;
+    snd_pcm_uframes_t buffer = 0;
+    a->hw_get_period_size(hw, &period, NULL);
+    a->hw_get_buffer_size(hw, &buffer);
+
+    // Start once the whole buffer is primed and wake for every period.
+    if (a->sw_current(dev->pcm, sw) < 0) goto done;
+    if (a->sw_set_start_threshold(dev->pcm, sw, buffer) < 0) goto done;
+    if (a->sw_set_avail_min(dev->pcm, sw, period) < 0) goto done;
+    if (a->sw_params(dev->pcm, sw) < 0) goto done;
+
+    dev->config.sampleRate = rate;
+    dev->config.periodSizeInFrames = (ma_uint32)period;
+    dev->config.periods = period > 0 ? (ma_uint32)(buffer / period) : periods;
+    result = 0;
+done:
+    if (hw) a->hw_free(hw);
+    if (sw) a->sw_free(sw);
+    return result;
+}
+
+// Underrun (-EPIPE) or suspend (-ESTRPIPE): re-prepare so the next writes
+// prime the buffer and restart the stream.
+static void ma__alsa_recover(ma_device *dev, int err) {
+    dev->xrunCount++;
+    if (dev->alsa.recover(dev->pcm, err, 1) < 0) {
+        dev->alsa.prepare(dev->pcm);
+    }
+}
+
+// Renders each period straight into the mapped device buffer.
+static void ma__alsa_run_mmap(ma_device *dev) {
+    ma__alsa_api *a = &dev->alsa;
+    const snd_pcm_uframes_t period = dev->config.periodSizeInFrames;
+    const size_t frame_bytes = (size_t)dev->config.channels * sizeof(float);
+    while (dev->running) {
+        snd_pcm_sframes_t avail = a->avail_update(dev->pcm);
+        if (avail < 0) {
+            ma__alsa_recover(dev, (int)avail);
+            continue;
+        }
+        if ((snd_pcm_uframes_t)avail < period) {
+            if (a->state(dev->pcm) == SNDRV_PCM_STATE_PREPARED) {
+                a->start(dev->pcm); // buffer primed
+                continue;
+            }
+            int err = a->wait(dev->pcm, 1000);
+            if (err < 0) ma__alsa_recover(dev, err);
+            continue;
+        }
+
+        const snd_pcm_channel_area_t *areas = NULL;
+        snd_pcm_uframes_t offset = 0;
+        snd_pcm_uframes_t frames = period;
+        int err = a->mmap_begin(dev->pcm, &areas, &offset, &frames);
+        if (err < 0) {
+            ma__alsa_recover(dev, err);
+            continue;
+        }
+        float *out = (float *)((char *)areas[0].addr + areas[0].first / 8 + offset * frame_bytes);
+        if (dev->config.dataCallback) {
+            dev->config.dataCallback(dev, out, NULL, (ma_uint32)frames);
+        } else {
+            memset(out, 0, frames * frame_bytes);
+        }
+        snd_pcm_sframes_t committed = a->mmap_commit(dev->pcm, offset, frames);
+        if (committed < 0 || (snd_pcm_uframes_t)committed != frames) {
+            ma__alsa_recover(dev, committed < 0 ? (int)committed : -EPIPE);
+        }
+    }
+}
+
+// Fallback for devices without mmap access: render into mix_buffer and
+// write it out.
+static void ma__alsa_run_rw(ma_device *dev) {
     const ma_uint32 frames = dev->config.periodSizeInFrames;
-    const ma_uint32 channels = dev->config.channels;
-    const size_t sample_count = (size_t)frames * channels;
+    const size_t sample_count = (size_t)frames * dev->config.channels;
     while (dev->running) {
-        memset(dev->mix_buffer, 0, sample_count * sizeof(float));
         if (dev->config.dataCallback) {
             dev->config.dataCallback(dev, dev->mix_buffer, NULL, frames);
+        } else {
+            memset(dev->mix_buffer, 0, sample_count * sizeof(float));
         }
-        snd_pcm_sframes_t written = dev->alsa.writei(dev->pcm, dev->mix_buffer, frames);
-        if (written < 0) {
-            dev->alsa.prepare(dev->pcm);
+        const float *src = dev->mix_buffer;
+        snd_pcm_uframes_t left = frames;
+        while (left > 0 && dev->running) {
+            snd_pcm_sframes_t written = dev->alsa.writei(dev->pcm, src, left);
+            if (written < 0) {
+                ma__alsa_recover(dev, (int)written);
+                continue;
+            }
+            src += (size_t)written * dev->config.channels;
+            left -= (snd_pcm_uframes_t)written;
         }
     }
+}
+
+static void *ma__device_thread_alsa(void *user) {
+    ma_device *dev = (ma_device *)user;
+    if (dev->mmap) {
+        ma__alsa_run_mmap(dev);
+    } else {
+        ma__alsa_run_rw(dev);
+    }
+    dev->alsa.drop(dev->pcm);
     return NULL;
 }
 #endif
@@ -168,30 +436,51 @@ static void ma__aq_callback(void *userData, AudioQueueRef inAQ, AudioQueueBuffer
 #endif
 
 static inline ma_result ma_device_init(ma_context *pContext, const ma_device_config *pConfig, ma_device *pDevice) {
-    (void)pContext;
     if (!pConfig || !pDevice) return -1;
     memset(pDevice, 0, sizeof(*pDevice));
     pDevice->config = *pConfig;
     pDevice->pUserData = pConfig->pUserData;
+    pDevice->backend = pContext ? pContext->backend : ma_backend_default;
+
+    if (pDevice->backend == ma_backend_null || pDevice->backend == ma_backend_file) {
+        size_t sample_count = (size_t)pDevice->config.periodSizeInFrames * pDevice->config.channels;
+        pDevice->mix_buffer = (float *)malloc(sample_count * sizeof(float));
+        if (!pDevice->mix_buffer) return -1;
+        if (pDevice->backend == ma_backend_file) {
+            const char *path = pConfig->pFilePath ? pConfig->pFilePath : "musika-out.wav";
+            pDevice->file = fopen(path, "wb");
+            if (!pDevice->file ||
+                ma__write_wav_header(pDevice->file, pDevice->config.channels, pDevice->config.sampleRate, 0) != 0) {
+                if (pDevice->file) fclose(pDevice->file);
+                free(pDevice->mix_buffer);
+                pDevice->file = NULL;
+                pDevice->mix_buffer = NULL;
+                return -1;
+            }
+        }
+        return 0;
+    }
 
 #if defined(__linux__)
     if (ma__load_alsa(&pDevice->alsa) != 0) return -1;
-    if (pDevice->alsa.open(&pDevice->pcm, "default", SNDRV_PCM_STREAM_PLAYBACK, 0) != 0) {
+    const char *name = pConfig->pDeviceName ? pConfig->pDeviceName : "default";
+    if (pDevice->alsa.open(&pDevice->pcm, name, SNDRV_PCM_STREAM_PLAYBACK, 0) != 0) {
         ma__unload_alsa(&pDevice->alsa);
         return -1;
     }
-    if (pDevice->alsa.set_params(pDevice->pcm, SNDRV_PCM_FORMAT_FLOAT_LE, SNDRV_PCM_ACCESS_RW_INTERLEAVED,
-                                 pDevice->config.channels, pDevice->config.sampleRate, 1, 500000) != 0) {
+    if (ma__alsa_configure(pDevice) != 0) {
         pDevice->alsa.close(pDevice->pcm);
         ma__unload_alsa(&pDevice->alsa);
         return -1;
     }
-    size_t sample_count = (size_t)pDevice->config.periodSizeInFrames * pDevice->config.channels;
-    pDevice->mix_buffer = (float *)malloc(sample_count * sizeof(float));
-    if (!pDevice->mix_buffer) {
-        pDevice->alsa.close(pDevice->pcm);
-        ma__unload_alsa(&pDevice->alsa);
-        return -1;
+    if (!pDevice->mmap) {
+        size_t sample_count = (size_t)pDevice->config.periodSizeInFrames * pDevice->config.channels;
+        pDevice->mix_buffer = (float *)malloc(sample_count * sizeof(float));
+        if (!pDevice->mix_buffer) {
+            pDevice->alsa.close(pDevice->pcm);
+            ma__unload_alsa(&pDevice->alsa);
+            return -1;
+        }
     }
 #elif defined(__APPLE__)
     AudioStreamBasicDescription fmt;
@@ -225,6 +514,14 @@ static inline ma_result ma_device_init(ma_context *pContext, const ma_device_con
 
 static inline ma_result ma_device_start(ma_device *pDevice) {
     if (!pDevice) return -1;
+    if (pDevice->backend != ma_backend_default) {
+        pDevice->running = 1;
+        if (pthread_create(&pDevice->thread, NULL, ma__device_thread_timer, pDevice) != 0) {
+            pDevice->running = 0;
+            return -1;
+        }
+        return 0;
+    }
 #if defined(__linux__)
     pDevice->running = 1;
     if (pthread_create(&pDevice->thread, NULL, ma__device_thread_alsa, pDevice) != 0) {
@@ -240,8 +537,25 @@ static inline ma_result ma_device_start(ma_device *pDevice) {
 #endif
 }
 
+// The thread that runs the data callback, for backends that own one.
+static inline ma_result ma_device_get_thread(ma_device *pDevice, pthread_t *pThread) {
+    if (!pDevice || !pThread || !pDevice->running) return -1;
+#if defined(__APPLE__)
+    if (pDevice->backend == ma_backend_default) return -1; // AudioQueue's own thread
+#endif
+    *pThread = pDevice->thread;
+    return 0;
+}
+
 static inline void ma_device_stop(ma_device *pDevice) {
     if (!pDevice) return;
+    if (pDevice->backend != ma_backend_default) {
+        if (pDevice->running) {
+            pDevice->running = 0;
+            pthread_join(pDevice->thread, NULL);
+        }
+        return;
+    }
 #if defined(__linux__)
     if (pDevice->running) {
         pDevice->running = 0;
@@ -256,6 +570,19 @@ static inline void ma_device_stop(ma_device *pDevice) {
 
 static inline void ma_device_uninit(ma_device *pDevice) {
     if (!pDevice) return;
+    if (pDevice->backend != ma_backend_default) {
+        ma_device_stop(pDevice);
+        if (pDevice->file) {
+            if (fseek(pDevice->file, 0, SEEK_SET) == 0) {
+                ma__write_wav_header(pDevice->file, pDevice->config.channels, pDevice->config.sampleRate, pDevice->fileFrames);
+            }
+            fclose(pDevice->file);
+            pDevice->file = NULL;
+        }
+        free(pDevice->mix_buffer);
+        pDevice->mix_buffer = NULL;
+        return;
+    }
 #if defined(__linux__)
     ma_device_stop(pDevice);
     if (pDevice->pcm) pDevice->alsa.close(pDevice->pcm);